@@ -23,5 +23,6 @@ Utility modules associated with the bge module.
 """
 
 __all__ = (
+    "components",
     "logger",
 )
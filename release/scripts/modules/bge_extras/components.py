@@ -0,0 +1,68 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8-80 compliant>
+
+"""
+Components implemented natively by the game engine.
+
+The classes of this module only declare the arguments shown in the UI,
+the game engine never imports them and updates the components of each
+class together in C++.
+"""
+
+import bge
+import bpy
+from collections import OrderedDict
+from mathutils import Vector
+
+__all__ = (
+    "Rotator",
+    "Follower",
+    "Lifetime",
+)
+
+
+class Rotator(bge.types.KX_PythonComponent):
+    """Rotate the object at a constant speed in radians per second."""
+
+    args = OrderedDict((
+        ("Speed", Vector((0.0, 0.0, 1.0))),
+        ("Local", True),
+    ))
+
+
+class Follower(bge.types.KX_PythonComponent):
+    """Move the object smoothly to the position of the target.
+
+    A speed of zero sticks the object to the target.
+    """
+
+    args = OrderedDict((
+        ("Target", bpy.types.Object),
+        ("Speed", 5.0),
+        ("Offset", Vector((0.0, 0.0, 0.0))),
+    ))
+
+
+class Lifetime(bge.types.KX_PythonComponent):
+    """Remove the object after a time in seconds."""
+
+    args = OrderedDict((
+        ("Time", 1.0),
+    ))
@@ -584,6 +584,9 @@ class SCENE_PT_game_physics(SceneButtonsPanel, Panel):
             sub.prop(gs, "erp2_parameter", text="ERP for Contact Constraints")
             sub.prop(gs, "cfm_parameter", text="CFM for Soft Constraints")
 
+            layout.prop(gs, "use_bvh_cache")
+            layout.prop(gs, "use_sensor_spatial_hash")
+
             row = layout.row()
             row.label(text="Object Activity:")
             row.prop(gs, "use_activity_culling")
@@ -621,6 +624,26 @@ class SCENE_PT_game_physics_obstacles(SceneButtonsPanel, Panel):
             layout.prop(gs, "show_obstacle_simulation")
 
 
+class SCENE_PT_game_threading(SceneButtonsPanel, Panel):
+    bl_label = "Game Threading"
+    bl_options = {'DEFAULT_CLOSED'}
+    COMPAT_ENGINES = {'BLENDER_EEVEE', 'BLENDER_WORKBENCH'}
+
+    @classmethod
+    def poll(cls, context):
+        scene = context.scene
+        return (scene.render.engine in cls.COMPAT_ENGINES)
+
+    def draw(self, context):
+        layout = self.layout
+
+        gs = context.scene.game_settings
+
+        layout.prop(gs, "use_threaded_scenegraph")
+        layout.prop(gs, "use_independent_physics")
+        layout.prop(gs, "use_threaded_physics")
+
+
 class SCENE_PT_game_navmesh(SceneButtonsPanel, Panel):
     bl_label = "Navigation Mesh"
     bl_options = {'DEFAULT_CLOSED'}
@@ -767,6 +790,22 @@ class OBJECT_PT_activity_culling(ObjectButtonsPanel, Panel):
         sub.active = activity.use_logic
         sub.prop(activity, "logic_radius")
 
+
+class OBJECT_PT_game_instancing(ObjectButtonsPanel, Panel):
+    bl_label = "Game Instancing"
+    COMPAT_ENGINES = {'BLENDER_EEVEE', 'BLENDER_WORKBENCH'}
+
+    @classmethod
+    def poll(cls, context):
+        ob = context.object
+        return context.scene.render.engine in cls.COMPAT_ENGINES and ob.type == 'MESH'
+
+    def draw(self, context):
+        layout = self.layout
+        game = context.object.game
+
+        layout.prop(game, "use_instanced_render")
+
 class OBJECT_MT_lod_tools(Menu):
     bl_label = "Level Of Detail Tools"
 
@@ -835,11 +874,13 @@ classes = (
     PHYSICS_PT_game_obstacles,
     SCENE_PT_game_physics,
     SCENE_PT_game_physics_obstacles,
+    SCENE_PT_game_threading,
     SCENE_PT_game_navmesh,
     SCENE_PT_game_hysteresis,
     SCENE_PT_game_console,
     OBJECT_MT_lod_tools,
     OBJECT_PT_activity_culling,
+    OBJECT_PT_game_instancing,
     OBJECT_PT_levels_of_detail,
 )
 
@@ -970,6 +970,18 @@ void DRW_transform_to_display_image_render(struct GPUTexture *tex);
 void DRW_game_gpu_viewport_set(struct GPUViewport *viewport);
 struct GPUViewport *DRW_game_gpu_viewport_get(void);
 
+/* Extra instances of an evaluated object drawn with the batches of this object,
+ * matrices and colors are arrays of len elements. */
+typedef struct DRWGameInstances {
+  struct Object *ob;
+  const float (*matrices)[4][4];
+  const float (*colors)[4];
+  int len;
+} DRWGameInstances;
+
+/* The instances are drawn by the next non overlay game render loops. */
+void DRW_game_instances_set(const DRWGameInstances *instances, int len);
+
 
 /* Viewport render debug  */
 void DRW_debug_line_bge(const float v1[3], const float v2[3], const float color[4]);
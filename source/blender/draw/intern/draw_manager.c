@@ -3440,6 +3440,64 @@ EEVEE_Data *EEVEE_engine_data_get(void)
   return data;
 }
 
+static struct {
+  const DRWGameInstances *instances;
+  int len;
+} g_game_instances = {NULL, 0};
+
+void DRW_game_instances_set(const DRWGameInstances *instances, int len)
+{
+  g_game_instances.instances = instances;
+  g_game_instances.len = len;
+}
+
+/* Populate the game instances as duplis of their evaluated object, the calls sharing the same
+ * batches are merged into instanced draws. */
+static void drw_game_instances_populate(Depsgraph *depsgraph)
+{
+  for (int i = 0; i < g_game_instances.len; i++) {
+    const DRWGameInstances *instances = &g_game_instances.instances[i];
+    Object *ob = DEG_get_evaluated_object(depsgraph, instances->ob);
+    /* Not evaluated yet. */
+    if (!DEG_is_evaluated_object(ob)) {
+      continue;
+    }
+
+    DupliObject dob = {NULL};
+    dob.ob = ob;
+    dob.ob_data = ob->data;
+
+    /* The instanced object is hidden, its instances are visible. */
+    Object temp_ob = *ob;
+    temp_ob.base_flag |= (BASE_FROM_DUPLI | BASE_ENABLED_AND_MAYBE_VISIBLE_IN_VIEWPORT |
+                          BASE_ENABLED_AND_VISIBLE_IN_DEFAULT_VIEWPORT);
+
+    DST.dupli_parent = ob;
+    DST.dupli_source = &dob;
+
+    for (int j = 0; j < instances->len; j++) {
+      copy_m4_m4(dob.mat, instances->matrices[j]);
+      dob.random_id = (uint)j;
+
+      copy_m4_m4(temp_ob.object_to_world, instances->matrices[j]);
+      invert_m4_m4(temp_ob.world_to_object, temp_ob.object_to_world);
+      SET_FLAG_FROM_TEST(temp_ob.transflag, is_negative_m4(dob.mat), OB_NEG_SCALE);
+      copy_v4_v4(temp_ob.color, instances->colors[j]);
+
+      drw_duplidata_load(&temp_ob);
+      drw_engines_cache_populate(&temp_ob);
+    }
+
+    /* Free the data allocated by the engines in the temporary object. */
+    if (temp_ob.runtime.bb != ob->runtime.bb) {
+      MEM_SAFE_FREE(temp_ob.runtime.bb);
+    }
+  }
+
+  DST.dupli_parent = NULL;
+  DST.dupli_source = NULL;
+}
+
 void DRW_game_render_loop(bContext *C,
                           GPUViewport *viewport,
                           Depsgraph *depsgraph,
@@ -3570,6 +3628,8 @@ void DRW_game_render_loop(bContext *C,
       drw_engines_cache_populate(ob);
     }
     DEG_OBJECT_ITER_END;
+
+    drw_game_instances_populate(depsgraph);
   }
 
   drw_duplidata_free();
@@ -872,6 +872,8 @@ enum {
   OB_OVERLAY_COLLECTION = 1 << 24,
 
   OB_LOD_UPDATE_PHYSICS = 1 << 25,
+
+  OB_INSTANCED_RENDER = 1 << 26,
 };
 
 /* ob->gameflag2 */
@@ -971,6 +971,11 @@ enum {
 // #define GAME_USE_UI_ANTI_FLICKER (1 << 20) /* deprecated */
 #define GAME_USE_VIEWPORT_RENDER (1 << 21)
 #define GAME_PYTHON_CONSOLE (1 << 22)
+#define GAME_USE_THREADED_SCENEGRAPH (1 << 23)
+#define GAME_USE_INDEPENDENT_PHYSICS (1 << 25)
+#define GAME_USE_THREADED_PHYSICS (1 << 26)
+#define GAME_USE_BVH_CACHE (1 << 27)
+#define GAME_USE_SENSOR_HASH (1 << 28)
 /* Note: GameData.flag is now an int (max 32 flags). A short could only take 16 flags */
 
 /* GameData.playerflag */
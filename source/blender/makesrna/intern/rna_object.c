@@ -3227,6 +3227,14 @@ static void rna_def_object_game_settings(BlenderRNA *brna)
   RNA_def_property_ui_text(
       prop, "Create obstacle", "Create representation for obstacle simulation");
 
+  prop = RNA_def_property(srna, "use_instanced_render", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "gameflag", OB_INSTANCED_RENDER);
+  RNA_def_property_ui_text(prop,
+                           "Instanced Render",
+                           "Draw the added copies of this mesh object as instances of a single "
+                           "object instead of copying the object for each of them, not used by "
+                           "the viewport render");
+
   prop = RNA_def_property(srna, "obstacle_radius", PROP_FLOAT, PROP_NONE | PROP_UNIT_LENGTH);
   RNA_def_property_float_sdna(prop, NULL, "obstacleRad");
   RNA_def_property_range(prop, 0.0, 1000.0);
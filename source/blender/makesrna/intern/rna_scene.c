@@ -6111,6 +6111,46 @@ static void rna_def_scene_game_data(BlenderRNA *brna)
       "Restrict the number of animation updates to the animation FPS (this is "
       "better for performance, but can cause issues with smooth playback)");
 
+  prop = RNA_def_property(srna, "use_threaded_scenegraph", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", GAME_USE_THREADED_SCENEGRAPH);
+  RNA_def_property_ui_text(prop,
+                           "Threaded Scene Graph",
+                           "Update the world transforms of independent object hierarchies "
+                           "on multiple threads");
+
+  prop = RNA_def_property(srna, "use_independent_physics", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", GAME_USE_INDEPENDENT_PHYSICS);
+  RNA_def_property_ui_text(prop,
+                           "Independent Physics",
+                           "Step the physics of this scene on a worker thread, concurrently "
+                           "with the logic and the other independent scenes. The scene must not "
+                           "share objects with other scenes and use the same deactivation time "
+                           "and contact breaking threshold");
+
+  prop = RNA_def_property(srna, "use_threaded_physics", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", GAME_USE_THREADED_PHYSICS);
+  RNA_def_property_ui_text(prop,
+                           "Threaded Physics",
+                           "Run the collision detection and the constraint solving of this scene "
+                           "on multiple threads. Disabled when the scene uses soft bodies");
+
+  prop = RNA_def_property(srna, "use_bvh_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", GAME_USE_BVH_CACHE);
+  RNA_def_property_ui_text(prop,
+                           "Cache Mesh BVH",
+                           "Save the bounding volume hierarchy of static triangle mesh shapes in "
+                           "a bvh_cache directory next to the blend file and load it at the next "
+                           "start instead of building it again");
+
+  prop = RNA_def_property(srna, "use_sensor_spatial_hash", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", GAME_USE_SENSOR_HASH);
+  RNA_def_property_ui_text(prop,
+                           "Spatial Hash Sensors",
+                           "Sense the objects of the Near and Radar sensors from a grid of the "
+                           "actor bounding boxes in one pass per frame, instead of a ghost object "
+                           "per sensor in the physics. The objects are tested by their bounding "
+                           "box and don't run the Python collision callbacks");
+
   prop = RNA_def_property(srna, "use_python_console", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flag", GAME_PYTHON_CONSOLE);
   RNA_def_property_ui_text(prop, "Python Console", "Create a python interpreter console in game");
@@ -47,6 +47,7 @@
 #include "wm_window.h"
 
 #include "CM_Message.h"
+#include "CM_Profiler.h"
 #include "GHOST_ISystem.h"
 #include "KX_Globals.h"
 #include "LA_BlenderLauncher.h"
@@ -380,6 +381,9 @@ extern "C" void StartKetsjiShell(struct bContext *C,
   } while (exitrequested == KX_ExitRequest::RESTART_GAME ||
            exitrequested == KX_ExitRequest::START_OTHER_GAME);
 
+  // Close a trace file left open by bge.logic.startProfiling.
+  CM_Profiler::Stop();
+
   if (bfd) {
     /* Hack to not free the win->ghosting AND win->gpu_ctx when we restart/load new
      * .blend */
@@ -0,0 +1,296 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Common/CM_Profiler.cpp
+ *  \ingroup common
+ */
+
+#include "CM_Profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "CM_Message.h"
+
+namespace {
+
+struct ProfileScope {
+  const char *name;
+  int64_t start;
+  int64_t end;
+};
+
+/// Single producer (the owner thread) and single consumer (the flushing thread) ring buffer.
+struct ThreadBuffer {
+  static const unsigned int size = 1 << 14;
+
+  ProfileScope scopes[size];
+  std::atomic<unsigned int> head;
+  std::atomic<unsigned int> tail;
+  /// Number of scopes lost because the buffer was full.
+  std::atomic<unsigned int> dropped;
+  unsigned int id;
+  std::string name;
+  /// True when the thread name was written in the trace file.
+  bool named;
+};
+
+struct ProfilerData {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::unordered_set<std::string> names;
+  std::ofstream file;
+  int64_t startTime;
+  bool firstEvent;
+  unsigned int nextId;
+  /// Scopes dropped by the exited threads.
+  unsigned int dropped;
+};
+
+}  // namespace
+
+std::atomic<bool> CM_Profiler::m_running(false);
+
+/// Never destructed, threads could record scopes while the program exits.
+static ProfilerData &get_data()
+{
+  static ProfilerData *data = new ProfilerData{{}, {}, {}, {}, 0, true, 0, 0};
+  return *data;
+}
+
+/// The buffer is kept by the profiler after the thread exit until it is drained.
+static thread_local std::shared_ptr<ThreadBuffer> threadBuffer;
+
+static ThreadBuffer *get_thread_buffer()
+{
+  if (!threadBuffer) {
+    ProfilerData &data = get_data();
+    std::lock_guard<std::mutex> lock(data.mutex);
+
+    threadBuffer = std::make_shared<ThreadBuffer>();
+    threadBuffer->head = 0;
+    threadBuffer->tail = 0;
+    threadBuffer->dropped = 0;
+    threadBuffer->id = data.nextId++;
+    threadBuffer->name = "Thread " + std::to_string(threadBuffer->id);
+    threadBuffer->named = false;
+    data.buffers.push_back(threadBuffer);
+  }
+
+  return threadBuffer.get();
+}
+
+static void write_string(std::ofstream &file, const char *str)
+{
+  file << '"';
+  for (const char *c = str; *c; ++c) {
+    switch (*c) {
+      case '"':
+        file << "\\\"";
+        break;
+      case '\\':
+        file << "\\\\";
+        break;
+      default:
+        if ((unsigned char)*c < 0x20) {
+          static const char hex[] = "0123456789abcdef";
+          file << "\\u00" << hex[(*c >> 4) & 0xF] << hex[*c & 0xF];
+        }
+        else {
+          file << *c;
+        }
+    }
+  }
+  file << '"';
+}
+
+static void begin_event(ProfilerData &data)
+{
+  if (!data.firstEvent) {
+    data.file << ",";
+  }
+  data.file << "\n";
+  data.firstEvent = false;
+}
+
+/// Drain all the buffers in the file, data.mutex must be locked.
+static void flush_buffers(ProfilerData &data)
+{
+  for (std::vector<std::shared_ptr<ThreadBuffer>>::iterator it = data.buffers.begin();
+       it != data.buffers.end();)
+  {
+    ThreadBuffer *buffer = it->get();
+    const unsigned int tail = buffer->tail.load(std::memory_order_relaxed);
+    const unsigned int head = buffer->head.load(std::memory_order_acquire);
+
+    if (tail != head && !buffer->named) {
+      begin_event(data);
+      data.file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"args\":{\"name\":";
+      write_string(data.file, buffer->name.c_str());
+      data.file << "}}";
+      buffer->named = true;
+    }
+
+    for (unsigned int i = tail; i != head; ++i) {
+      const ProfileScope &scope = buffer->scopes[i & (ThreadBuffer::size - 1)];
+      // Scopes started before the capture.
+      if (scope.start < data.startTime) {
+        continue;
+      }
+
+      begin_event(data);
+      data.file << "{\"name\":";
+      write_string(data.file, scope.name);
+      data.file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"ts\":" << (double)(scope.start - data.startTime) * 1.0e-3
+                << ",\"dur\":" << (double)(scope.end - scope.start) * 1.0e-3 << "}";
+    }
+    buffer->tail.store(head, std::memory_order_release);
+
+    // Only the profiler owns the buffer of an exited thread.
+    if (it->use_count() == 1) {
+      data.dropped += buffer->dropped;
+      it = data.buffers.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+}
+
+bool CM_Profiler::Start(const std::string &path)
+{
+  ProfilerData &data = get_data();
+  // Register the calling thread first to name it.
+  ThreadBuffer *mainBuffer = get_thread_buffer();
+
+  std::lock_guard<std::mutex> lock(data.mutex);
+
+  if (IsRunning()) {
+    CM_Warning("profiler already writing a trace file.");
+    return false;
+  }
+
+  data.file.open(path, std::ios::out | std::ios::trunc);
+  if (!data.file.is_open()) {
+    CM_Error("can't open profiler trace file \"" << path << "\".");
+    return false;
+  }
+
+  data.file.setf(std::ios::fixed);
+  data.file.precision(3);
+  data.file << "{\"traceEvents\":[";
+  data.firstEvent = true;
+  data.startTime = GetTime();
+  data.dropped = 0;
+
+  // Discard the scopes recorded since the last capture and rename the threads in the new file.
+  for (std::shared_ptr<ThreadBuffer> &buffer : data.buffers) {
+    buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+    buffer->dropped = 0;
+    buffer->named = false;
+  }
+  mainBuffer->name = "Main";
+
+  m_running = true;
+
+  CM_Message("Profiling to \"" << path << "\".");
+
+  return true;
+}
+
+void CM_Profiler::Stop()
+{
+  ProfilerData &data = get_data();
+  std::lock_guard<std::mutex> lock(data.mutex);
+
+  if (!IsRunning()) {
+    return;
+  }
+
+  m_running = false;
+
+  flush_buffers(data);
+
+  unsigned int dropped = data.dropped;
+  for (std::shared_ptr<ThreadBuffer> &buffer : data.buffers) {
+    dropped += buffer->dropped;
+  }
+  if (dropped > 0) {
+    CM_Warning("profiler dropped " << dropped << " scopes recorded in too long frames.");
+  }
+
+  data.file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  data.file.close();
+}
+
+void CM_Profiler::Flush()
+{
+  if (!IsRunning()) {
+    return;
+  }
+
+  ProfilerData &data = get_data();
+  std::lock_guard<std::mutex> lock(data.mutex);
+
+  // Stopped while waiting for the lock.
+  if (!IsRunning()) {
+    return;
+  }
+
+  flush_buffers(data);
+}
+
+const char *CM_Profiler::Intern(const std::string &name)
+{
+  ProfilerData &data = get_data();
+  std::lock_guard<std::mutex> lock(data.mutex);
+
+  // The nodes of the set are never moved.
+  return data.names.insert(name).first->c_str();
+}
+
+int64_t CM_Profiler::GetTime()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void CM_Profiler::AddScope(const char *name, int64_t start, int64_t end)
+{
+  ThreadBuffer *buffer = get_thread_buffer();
+
+  const unsigned int head = buffer->head.load(std::memory_order_relaxed);
+  if (head - buffer->tail.load(std::memory_order_acquire) == ThreadBuffer::size) {
+    ++buffer->dropped;
+    return;
+  }
+
+  buffer->scopes[head & (ThreadBuffer::size - 1)] = {name, start, end};
+  buffer->head.store(head + 1, std::memory_order_release);
+}
@@ -0,0 +1,101 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file CM_Profiler.h
+ *  \ingroup common
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/** Capture of timed scopes written to a Chrome trace file (chrome://tracing or Perfetto).
+ * Each thread records its scopes in its own ring buffer without locking, the buffers are
+ * drained into the file by Flush() once per frame. The scopes nest by time on a thread,
+ * making the hierarchy visible in the trace viewer.
+ */
+class CM_Profiler {
+ private:
+  static std::atomic<bool> m_running;
+
+ public:
+  /// Open the trace file and start recording, return false if the file can't be opened.
+  static bool Start(const std::string &path);
+  /// Write the pending scopes and close the trace file.
+  static void Stop();
+  /// Write the scopes recorded by all the threads since the last flush.
+  static void Flush();
+
+  inline static bool IsRunning()
+  {
+    return m_running.load(std::memory_order_relaxed);
+  }
+
+  /// Return a name living until the end of the program for a scope, e.g. a scene name.
+  static const char *Intern(const std::string &name);
+
+  /// Time in nanoseconds of a monotonic clock.
+  static int64_t GetTime();
+  /// Record a scope of the calling thread, dropped if its buffer is full.
+  static void AddScope(const char *name, int64_t start, int64_t end);
+};
+
+/** Record the time spent until the end of the C++ scope while the profiler is running.
+ * A null name disables the scope.
+ */
+class CM_ProfileScope {
+ private:
+  const char *m_name;
+  int64_t m_start;
+
+ public:
+  CM_ProfileScope(const char *name)
+      : m_name(CM_Profiler::IsRunning() ? name : nullptr),
+        m_start(m_name ? CM_Profiler::GetTime() : 0)
+  {
+  }
+
+  ~CM_ProfileScope()
+  {
+    if (m_name) {
+      CM_Profiler::AddScope(m_name, m_start, CM_Profiler::GetTime());
+    }
+  }
+};
+
+#define CM_PROFILE_SCOPE_CONCAT_(a, b) a##b
+#define CM_PROFILE_SCOPE_CONCAT(a, b) CM_PROFILE_SCOPE_CONCAT_(a, b)
+#define CM_PROFILE_SCOPE(name) \
+  CM_ProfileScope CM_PROFILE_SCOPE_CONCAT(_profileScope, __LINE__)(name)
+/// Scope named by a string expression, evaluated only while the profiler is running.
+#define CM_PROFILE_SCOPE_NAME(name) \
+  CM_ProfileScope CM_PROFILE_SCOPE_CONCAT(_profileScope, __LINE__)( \
+      CM_Profiler::IsRunning() ? CM_Profiler::Intern(name) : nullptr)
+/** Scope named by a string expression interned once into a const char * cache, for the scopes
+ * entered every frame. The cache must be reset to nullptr when the name changes.
+ */
+#define CM_PROFILE_SCOPE_CACHED(cache, name) \
+  CM_ProfileScope CM_PROFILE_SCOPE_CONCAT(_profileScope, __LINE__)( \
+      CM_Profiler::IsRunning() ? ((cache) ? (cache) : ((cache) = CM_Profiler::Intern(name))) : \
+                                 nullptr)
@@ -61,6 +61,7 @@
 
 #ifdef WITH_BULLET
 #  include "CcdPhysicsEnvironment.h"
+#  include "CcdTaskScheduler.h"
 #endif
 
 #ifdef WITH_PYTHON
@@ -105,6 +106,12 @@ BL_Converter::BL_Converter(Main *maggie, KX_KetsjiEngine *engine)
 {
   BKE_main_id_tag_all(maggie, LIB_TAG_DOIT, false);  // avoid re-tagging later on
   m_threadinfo.m_pool = BLI_task_pool_create(nullptr, TASK_PRIORITY_LOW);
+
+#ifdef WITH_BULLET
+  /* The physics scheduler is installed by the main thread before any scene is converted,
+   * the physics can then be stepped and queried from the worker threads. */
+  CcdTaskScheduler::Install();
+#endif
 }
 
 BL_Converter::~BL_Converter()
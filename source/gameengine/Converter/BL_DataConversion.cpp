@@ -989,8 +989,11 @@ static ListBase *BL_GetActiveConstraint(Object *ob)
   return &ob->constraints;
 }
 
-static void BL_ConvertComponentsObject(KX_GameObject *gameobj, Object *blenderobj)
+static void BL_ConvertComponentsObject(KX_Scene *kxscene,
+                                       KX_GameObject *gameobj,
+                                       Object *blenderobj)
 {
+  KX_NativeComponentManager &nativeComponentManager = kxscene->GetNativeComponentManager();
 #ifdef WITH_PYTHON
   PythonProxy *pp = (PythonProxy *)blenderobj->components.first;
   PyObject *arg_dict = NULL, *args = NULL, *mod = NULL, *cls = NULL, *pycomp = NULL, *ret = NULL;
@@ -1011,6 +1014,12 @@ static void BL_ConvertComponentsObject(KX_GameObject *gameobj, Object *blenderob
     Py_XDECREF(pycomp);
     args = arg_dict = mod = cls = pycomp = ret = NULL;
 
+    // The native components are not imported, their python class is only used by the UI.
+    if (nativeComponentManager.Convert(gameobj, pp)) {
+      pp = pp->next;
+      continue;
+    }
+
     // Grab the module
     mod = PyImport_ImportModule(pp->module);
 
@@ -1070,10 +1079,17 @@ static void BL_ConvertComponentsObject(KX_GameObject *gameobj, Object *blenderob
   Py_XDECREF(cls);
   Py_XDECREF(pycomp);
 
+  // An object using only native components is not updated by the python proxy manager.
+  if (components->GetCount() == 0) {
+    components->Release();
+    return;
+  }
+
   gameobj->SetComponents(components);
 #else
-  (void)gameobj;
-  (void)blenderobj;
+  for (PythonProxy *pp = (PythonProxy *)blenderobj->components.first; pp; pp = pp->next) {
+    nativeComponentManager.Convert(gameobj, pp);
+  }
 #endif
 }
 
@@ -1130,6 +1146,8 @@ static void bl_ConvertBlenderObject_Single(BL_SceneConverter *converter,
   gameobj->NodeSetLocalPosition(pos);
   gameobj->NodeSetLocalOrientation(rotation);
   gameobj->NodeSetLocalScale(scale);
+  // Objects in inactive layers are not synchronized with the depsgraph.
+  gameobj->SetInactiveLayer(!isInActiveLayer);
   gameobj->NodeUpdateGS(0);
 
   sumolist->Add(CM_AddRef(gameobj));
@@ -1206,6 +1224,7 @@ static void bl_ConvertBlenderObject_Single(BL_SceneConverter *converter,
     // tf.Add(gameobj->GetSGNode());
 
     gameobj->NodeUpdateGS(0);
+    kxscene->AddDirtyTransformObject(gameobj);
   }
   else {
     // we must store this object otherwise it will be deleted
@@ -1298,6 +1317,9 @@ void BL_ConvertBlenderObjects(struct Main *maggie,
     // no occlusion culling by default
     kxscene->SetDbvtOcclusionRes(0);
 
+    kxscene->SetThreadedSceneGraph((blenderscene->gm.flag & GAME_USE_THREADED_SCENEGRAPH) != 0);
+    kxscene->SetIndependentPhysics((blenderscene->gm.flag & GAME_USE_INDEPENDENT_PHYSICS) != 0);
+
     if (blenderscene->gm.lodflag & SCE_LOD_USE_HYST) {
       kxscene->SetLodHysteresis(true);
       kxscene->SetLodHysteresisValue(blenderscene->gm.scehysteresis);
@@ -1773,7 +1795,7 @@ void BL_ConvertBlenderObjects(struct Main *maggie,
         continue;
       }
     }
-    BL_ConvertComponentsObject(gameobj, blenderobj);
+    BL_ConvertComponentsObject(kxscene, gameobj, blenderobj);
   }
 
   for (KX_GameObject *gameobj : objectlist) {
@@ -1787,6 +1809,7 @@ void BL_ConvertBlenderObjects(struct Main *maggie,
       // Register object for component update.
       kxscene->GetPythonProxyManager().Register(gameobj);
     }
+    kxscene->GetNativeComponentManager().Register(gameobj);
   }
 
   // cleanup converted set of group objects
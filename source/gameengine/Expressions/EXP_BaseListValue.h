@@ -18,8 +18,18 @@
 
 #pragma once
 
+#include <memory>
+#include <unordered_map>
+
 #include "EXP_Value.h"
 
+class EXP_BaseListValue;
+
+/// Reference to an indexed list kept by its items, cleared when the list is freed.
+struct EXP_NameIndexReference {
+  EXP_BaseListValue *m_list;
+};
+
 class EXP_BaseListValue : public EXP_PropValue {
   Py_Header
 
@@ -32,6 +42,30 @@ class EXP_BaseListValue : public EXP_PropValue {
   VectorType m_pValueArray;
   bool m_bReleaseContents;
 
+ private:
+  typedef std::unordered_map<std::string, VectorType> NameIndex;
+
+  /// Items of each name in list order, used to find items by name in large lists.
+  mutable NameIndex m_nameIndex;
+  /** Entry of each item in the name index, the removed items are unindexed without
+   * accessing them as they could be already freed.
+   */
+  mutable std::unordered_map<EXP_Value *, NameIndex::value_type *> m_nameIndexEntries;
+  bool m_nameIndexEnabled;
+  /// True when the index matches the items, reset when the items are reordered or replaced.
+  mutable bool m_nameIndexValid;
+  /// Reference given to the indexed items to update their entry when they are renamed.
+  mutable std::shared_ptr<EXP_NameIndexReference> m_nameIndexReference;
+
+  bool IsNameIndexValid() const;
+  void BuildNameIndex() const;
+  void AddNameIndexEntry(EXP_Value *value) const;
+  void IndexValue(EXP_Value *value);
+  void UnindexValue(EXP_Value *value);
+
+ protected:
+  void InvalidateNameIndex();
+
   void SetValue(int i, EXP_Value *val);
   EXP_Value *GetValue(int i);
   EXP_Value *FindValue(const std::string &name) const;
@@ -51,6 +85,17 @@ class EXP_BaseListValue : public EXP_PropValue {
 
   void SetReleaseOnDestruct(bool bReleaseContents);
 
+  /** Find the items by name using a hash index instead of comparing the name of all
+   * the items, the index is only used when the list contains many items.
+   * The items of an indexed list must call RenameValue on the lists of the references
+   * received in EXP_Value::AddNameIndexReference when they are renamed.
+   */
+  void EnableNameIndex(bool enable);
+  /** Move the entry of a renamed item to its new name in the index.
+   * \return False if the item is not indexed in this list anymore.
+   */
+  bool RenameValue(EXP_Value *value);
+
   void Remove(int i);
   void Resize(int num);
   void ReleaseAndRemoveAll();
@@ -76,6 +76,7 @@ template<class ItemType> class EXP_ListValue : public EXP_BaseListValue {
     for (unsigned int i = 0; i < numelements; i++) {
       replica->m_pValueArray[i] = m_pValueArray[i]->GetReplica();
     }
+    replica->InvalidateNameIndex();
 
     return replica;
   }
@@ -23,6 +23,7 @@
 #endif
 
 #include <map>     // Array functionality for the property list.
+#include <memory>
 #include <string>  // std::string class.
 #include <vector>
 
@@ -72,6 +73,8 @@ enum VALUE_DATA_TYPE {
 #  include "object.h"
 #endif
 
+struct EXP_NameIndexReference;
+
 /**
  * Baseclass EXP_Value
  *
@@ -152,6 +155,10 @@ class EXP_Value : public EXP_PyObjectPlus, public CM_RefCount<EXP_Value> {
   virtual std::string GetName() = 0;
   /// Set the name of the value.
   virtual void SetName(const std::string &name);
+  /** Called when the value is added to the name index of a list, a value which can be renamed
+   * keeps the reference to update the index, see EXP_BaseListValue::RenameValue.
+   */
+  virtual void AddNameIndexReference(const std::shared_ptr<EXP_NameIndexReference> &reference);
   /** Sets the value to this cvalue.
    * \attention this particular function should never be called. Why not abstract?
    */
@@ -21,12 +21,23 @@
 
 #include "EXP_ListValue.h"
 
-EXP_BaseListValue::EXP_BaseListValue() : m_bReleaseContents(true)
+/// Minimum number of items to find the items by name with the index.
+static const unsigned int nameIndexMinCount = 64;
+
+EXP_BaseListValue::EXP_BaseListValue()
+    : m_bReleaseContents(true),
+      m_nameIndexEnabled(false),
+      m_nameIndexValid(false)
 {
 }
 
 EXP_BaseListValue::~EXP_BaseListValue()
 {
+  // The items can outlive the list.
+  if (m_nameIndexReference && m_nameIndexReference->m_list == this) {
+    m_nameIndexReference->m_list = nullptr;
+  }
+
   if (m_bReleaseContents) {
     for (EXP_Value *item : m_pValueArray) {
       item->Release();
@@ -34,9 +45,117 @@ EXP_BaseListValue::~EXP_BaseListValue()
   }
 }
 
+bool EXP_BaseListValue::IsNameIndexValid() const
+{
+  return m_nameIndexValid;
+}
+
+void EXP_BaseListValue::BuildNameIndex() const
+{
+  /* A list copied for a replica shares the reference of the original list
+   * until it is indexed. */
+  if (!m_nameIndexReference || m_nameIndexReference->m_list != this) {
+    m_nameIndexReference = std::make_shared<EXP_NameIndexReference>();
+    m_nameIndexReference->m_list = const_cast<EXP_BaseListValue *>(this);
+  }
+
+  m_nameIndex.clear();
+  m_nameIndexEntries.clear();
+  for (EXP_Value *item : m_pValueArray) {
+    AddNameIndexEntry(item);
+    item->AddNameIndexReference(m_nameIndexReference);
+  }
+
+  m_nameIndexValid = true;
+}
+
+void EXP_BaseListValue::AddNameIndexEntry(EXP_Value *value) const
+{
+  NameIndex::value_type &entry = *m_nameIndex.emplace(value->GetName(), VectorType()).first;
+  entry.second.push_back(value);
+  m_nameIndexEntries[value] = &entry;
+}
+
+void EXP_BaseListValue::IndexValue(EXP_Value *value)
+{
+  if (!IsNameIndexValid()) {
+    return;
+  }
+
+  AddNameIndexEntry(value);
+  value->AddNameIndexReference(m_nameIndexReference);
+}
+
+void EXP_BaseListValue::UnindexValue(EXP_Value *value)
+{
+  if (!IsNameIndexValid()) {
+    return;
+  }
+
+  const auto it = m_nameIndexEntries.find(value);
+  if (it == m_nameIndexEntries.end()) {
+    return;
+  }
+
+  NameIndex::value_type *entry = it->second;
+  m_nameIndexEntries.erase(it);
+
+  VectorType &items = entry->second;
+  items.erase(std::remove(items.begin(), items.end(), value), items.end());
+  if (items.empty()) {
+    m_nameIndex.erase(entry->first);
+  }
+}
+
+void EXP_BaseListValue::InvalidateNameIndex()
+{
+  m_nameIndexValid = false;
+}
+
+void EXP_BaseListValue::EnableNameIndex(bool enable)
+{
+  m_nameIndexEnabled = enable;
+  if (!enable) {
+    m_nameIndex.clear();
+    m_nameIndexEntries.clear();
+    m_nameIndexValid = false;
+  }
+}
+
+bool EXP_BaseListValue::RenameValue(EXP_Value *value)
+{
+  if (!IsNameIndexValid()) {
+    // The index is built again from the current names.
+    return true;
+  }
+
+  const auto it = m_nameIndexEntries.find(value);
+  if (it == m_nameIndexEntries.end()) {
+    return false;
+  }
+
+  const std::string name = value->GetName();
+  if (it->second->first == name) {
+    return true;
+  }
+
+  /* The items of a name are stored in list order, finding the position of the item among
+   * the items already using its new name would need to scan the list. */
+  if (m_nameIndex.find(name) != m_nameIndex.end()) {
+    InvalidateNameIndex();
+    return true;
+  }
+
+  UnindexValue(value);
+  AddNameIndexEntry(value);
+
+  return true;
+}
+
 void EXP_BaseListValue::SetValue(int i, EXP_Value *val)
 {
   m_pValueArray[i] = val;
+  InvalidateNameIndex();
 }
 
 EXP_Value *EXP_BaseListValue::GetValue(int i)
@@ -46,6 +165,18 @@ EXP_Value *EXP_BaseListValue::GetValue(int i)
 
 EXP_Value *EXP_BaseListValue::FindValue(const std::string &name) const
 {
+  if (m_nameIndexEnabled && m_pValueArray.size() >= nameIndexMinCount) {
+    if (!IsNameIndexValid()) {
+      BuildNameIndex();
+    }
+
+    const auto it = m_nameIndex.find(name);
+    if (it != m_nameIndex.end()) {
+      return it->second.front();
+    }
+    return NULL;
+  }
+
   const VectorTypeConstIterator it = std::find_if(
       m_pValueArray.begin(), m_pValueArray.end(), [&name](EXP_Value *item) {
         return item->GetName() == name;
@@ -65,15 +196,19 @@ bool EXP_BaseListValue::SearchValue(EXP_Value *val) const
 void EXP_BaseListValue::Add(EXP_Value *value)
 {
   m_pValueArray.push_back(value);
+  IndexValue(value);
 }
 
 void EXP_BaseListValue::Insert(unsigned int i, EXP_Value *value)
 {
   m_pValueArray.insert(m_pValueArray.begin() + i, value);
+  InvalidateNameIndex();
 }
 
 bool EXP_BaseListValue::RemoveValue(EXP_Value *val)
 {
+  UnindexValue(val);
+
   bool result = false;
   for (VectorTypeIterator it = m_pValueArray.begin(); it != m_pValueArray.end();) {
     if (*it == val) {
@@ -130,11 +265,14 @@ void EXP_BaseListValue::SetReleaseOnDestruct(bool bReleaseContents)
 void EXP_BaseListValue::Remove(int i)
 {
   m_pValueArray.erase(m_pValueArray.begin() + i);
+  // The item could still be in the list at another position.
+  InvalidateNameIndex();
 }
 
 void EXP_BaseListValue::Resize(int num)
 {
   m_pValueArray.resize(num);
+  InvalidateNameIndex();
 }
 
 void EXP_BaseListValue::ReleaseAndRemoveAll()
@@ -143,6 +281,7 @@ void EXP_BaseListValue::ReleaseAndRemoveAll()
     item->Release();
   }
   m_pValueArray.clear();
+  InvalidateNameIndex();
 }
 
 int EXP_BaseListValue::GetCount() const
@@ -470,6 +609,7 @@ PyObject *EXP_BaseListValue::Pyreverse()
   }
 
   std::reverse(m_pValueArray.begin(), m_pValueArray.end());
+  InvalidateNameIndex();
   Py_RETURN_NONE;
 }
 
@@ -414,6 +414,11 @@ void EXP_Value::SetName(const std::string &name)
 {
 }
 
+void EXP_Value::AddNameIndexReference(
+    const std::shared_ptr<EXP_NameIndexReference> &reference)
+{
+}
+
 EXP_Value *EXP_Value::GetReplica()
 {
   return nullptr;
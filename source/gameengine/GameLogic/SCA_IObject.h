@@ -139,6 +139,8 @@ class SCA_IObject : public KX_PythonProxy {
   /// Resume progress.
   void ResumeLogic(void);
 
+  bool IsLogicSuspended() const;
+
   /// Set init state.
   void SetInitState(unsigned int initState);
 
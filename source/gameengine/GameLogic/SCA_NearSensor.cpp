@@ -35,6 +35,7 @@
 #include "SCA_NearSensor.h"
 
 #include "KX_CollisionEventManager.h"
+#include "MT_MinMax.h"
 #include "PHY_IMotionState.h"
 #include "PHY_IPhysicsController.h"
 
@@ -47,7 +48,8 @@ SCA_NearSensor::SCA_NearSensor(SCA_EventManager *eventmgr,
                                PHY_IPhysicsController *ctrl)
     : SCA_CollisionSensor(eventmgr, gameobj, bFindMaterial, false, touchedpropname),
       m_Margin(margin),
-      m_ResetMargin(resetmargin)
+      m_ResetMargin(resetmargin),
+      m_useSpatialHash(false)
 
 {
 
@@ -68,7 +70,7 @@ void SCA_NearSensor::SynchronizeTransform()
 {
   // The near and radar sensors are using a different physical object which is
   // not linked to the parent object, must synchronize it.
-  if (m_physCtrl) {
+  if (m_physCtrl && !m_useSpatialHash) {
     PHY_IMotionState *motionState = m_physCtrl->GetMotionState();
     KX_GameObject *parent = ((KX_GameObject *)GetParent());
     motionState->SetWorldPosition(parent->NodeGetWorldPosition());
@@ -154,17 +156,59 @@ bool SCA_NearSensor::Evaluate()
   return result;
 }
 
-// this function is called at broad phase stage to check if the two controller
-// need to interact at all. It is used for Near/Radar sensor that don't need to
-// check collision with object not included in filter
-bool SCA_NearSensor::BroadPhaseFilterCollision(PHY_IPhysicsController *ctrl1, PHY_IPhysicsController *ctrl2)
+void SCA_NearSensor::SetUseSpatialHash(bool use)
 {
-  KX_GameObject *parent = static_cast<KX_GameObject *>(GetParent());
+  m_useSpatialHash = use;
+}
 
-  // need the mapping from PHY_IPhysicsController to gameobjects now
-  BLI_assert(ctrl1 == m_physCtrl && ctrl2);
-  KX_ClientObjectInfo *client_info = static_cast<KX_ClientObjectInfo *>(ctrl2->GetNewClientInfo());
+void SCA_NearSensor::GetSensedAabb(MT_Vector3 &aabbMin, MT_Vector3 &aabbMax)
+{
+  const MT_Vector3 &center = static_cast<KX_GameObject *>(GetParent())->NodeGetWorldPosition();
+  // The radius is the one set by SetPhysCtrlRadius after the last evaluation.
+  const float radius = (m_bLastTriggered) ? m_ResetMargin : m_Margin;
+  aabbMin = center - MT_Vector3(radius, radius, radius);
+  aabbMax = center + MT_Vector3(radius, radius, radius);
+}
+
+bool SCA_NearSensor::TestSensedAabb(const MT_Vector3 &aabbMin, const MT_Vector3 &aabbMax)
+{
+  const MT_Vector3 &center = static_cast<KX_GameObject *>(GetParent())->NodeGetWorldPosition();
+  const float radius = (m_bLastTriggered) ? m_ResetMargin : m_Margin;
+  // Distance from the center of the sphere to the closest point of the box.
+  MT_Scalar distance2 = 0.0f;
+  for (unsigned short i = 0; i < 3; ++i) {
+    const MT_Scalar delta = center[i] - MT_max(aabbMin[i], MT_min(center[i], aabbMax[i]));
+    distance2 += delta * delta;
+  }
+  return (distance2 <= radius * radius);
+}
+
+void SCA_NearSensor::SenseSpatialHash(KX_SensorSpatialHash &hash,
+                                      std::vector<KX_SensorSpatialHash::Entry *> &entries)
+{
+  // Same check as in NewHandleCollision, avoid the query when nothing is recorded.
+  if (!m_links || m_suspended) {
+    return;
+  }
+
+  MT_Vector3 aabbMin;
+  MT_Vector3 aabbMax;
+  GetSensedAabb(aabbMin, aabbMax);
 
+  entries.clear();
+  hash.Query(aabbMin, aabbMax, entries);
+
+  for (KX_SensorSpatialHash::Entry *entry : entries) {
+    if (FilterObject(entry->m_object->getClientInfo()) &&
+        TestSensedAabb(entry->m_aabbMin, entry->m_aabbMax)) {
+      AddCollider(entry->m_object);
+    }
+  }
+}
+
+bool SCA_NearSensor::FilterObject(KX_ClientObjectInfo *client_info)
+{
+  KX_GameObject *parent = static_cast<KX_GameObject *>(GetParent());
   KX_GameObject *gameobj = (client_info ? client_info->m_gameobject : nullptr);
 
   if (gameobj && (gameobj != parent)) {
@@ -179,6 +223,16 @@ bool SCA_NearSensor::BroadPhaseFilterCollision(PHY_IPhysicsController *ctrl1, PH
   return false;
 }
 
+// this function is called at broad phase stage to check if the two controller
+// need to interact at all. It is used for Near/Radar sensor that don't need to
+// check collision with object not included in filter
+bool SCA_NearSensor::BroadPhaseFilterCollision(PHY_IPhysicsController *ctrl1, PHY_IPhysicsController *ctrl2)
+{
+  // need the mapping from PHY_IPhysicsController to gameobjects now
+  BLI_assert(ctrl1 == m_physCtrl && ctrl2);
+  return FilterObject(static_cast<KX_ClientObjectInfo *>(ctrl2->GetNewClientInfo()));
+}
+
 bool SCA_NearSensor::NewHandleCollision(PHY_IPhysicsController *ctrl1, PHY_IPhysicsController *ctrl2, const PHY_ICollData *coll_data)
 {
   //	KX_CollisionEventManager* toucheventmgr = static_cast<KX_CollisionEventManager*>(m_eventmgr);
@@ -195,24 +249,22 @@ bool SCA_NearSensor::NewHandleCollision(PHY_IPhysicsController *ctrl1, PHY_IPhys
   // we don't want to record collision when the sensor is not active.
   if (m_links && !m_suspended &&
       gameobj /* done in BroadPhaseFilterCollision() && (gameobj != parent)*/) {
-    if (!m_colliders->SearchValue(gameobj))
-      m_colliders->Add(CM_AddRef(gameobj));
     // only take valid colliders
     // These checks are done already in BroadPhaseFilterCollision()
-    // if (client_info->m_type == KX_ClientObjectInfo::ACTOR)
-    //{
-    //	if ((m_touchedpropname.empty()) ||
-    //		(gameobj->GetProperty(m_touchedpropname)))
-    //	{
-    m_bTriggered = true;
-    m_hitObject = gameobj;
-    //	}
-    //}
+    AddCollider(gameobj);
   }
 
   return false;  // was DT_CONTINUE; but this was defined in Sumo as false
 }
 
+void SCA_NearSensor::AddCollider(KX_GameObject *gameobj)
+{
+  if (!m_colliders->SearchValue(gameobj))
+    m_colliders->Add(CM_AddRef(gameobj));
+  m_bTriggered = true;
+  m_hitObject = gameobj;
+}
+
 #ifdef WITH_PYTHON
 
 /* ------------------------------------------------------------------------- */
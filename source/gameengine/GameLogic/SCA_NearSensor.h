@@ -33,6 +33,7 @@
 #pragma once
 
 #include "KX_ClientObjectInfo.h"
+#include "KX_SensorSpatialHash.h"
 #include "SCA_CollisionSensor.h"
 
 class KX_Scene;
@@ -44,6 +45,14 @@ class SCA_NearSensor : public SCA_CollisionSensor {
 
   KX_ClientObjectInfo *m_client_info;
 
+  /// True if the objects are sensed from the spatial hash of the manager and not the physics.
+  bool m_useSpatialHash;
+
+  /// Return true if the sensor is interested in an object, it must be an actor.
+  bool FilterObject(KX_ClientObjectInfo *client_info);
+  /// Record a sensed object.
+  void AddCollider(KX_GameObject *gameobj);
+
  public:
   SCA_NearSensor(class SCA_EventManager *eventmgr,
                  class KX_GameObject *gameobj,
@@ -69,6 +78,18 @@ public:
   virtual void SetPhysCtrlRadius();
   virtual bool Evaluate();
 
+  /// Sense the objects from a spatial hash instead of the physics controller.
+  void SetUseSpatialHash(bool use);
+  /// Compute the bounding box of the sensed volume.
+  virtual void GetSensedAabb(MT_Vector3 &aabbMin, MT_Vector3 &aabbMax);
+  /// Return true if the sensed volume overlaps the bounding box of an object.
+  virtual bool TestSensedAabb(const MT_Vector3 &aabbMin, const MT_Vector3 &aabbMax);
+  /** Sense the objects of the spatial hash.
+   * \param entries Temporary array of the query, shared by the sensors to keep its capacity.
+   */
+  void SenseSpatialHash(KX_SensorSpatialHash &hash,
+                        std::vector<KX_SensorSpatialHash::Entry *> &entries);
+
   virtual void ReParent(SCA_IObject *parent);
   virtual bool NewHandleCollision(PHY_IPhysicsController *ctrl1,
                                   PHY_IPhysicsController *ctrl2,
@@ -48,7 +48,10 @@ SCA_NetworkMessageSensor::SCA_NetworkMessageSensor(
     : SCA_ISensor(gameobj, eventmgr),
       m_NetworkScene(NetworkScene),
       m_subject(subject),
+      m_subjectId(NetworkScene->RegisterName(subject)),
       m_frame_message_count(0),
+      m_messages(),
+      m_messageFrame(0),
       m_BodyList(nullptr),
       m_SubjectList(nullptr)
 {
@@ -62,6 +65,7 @@ void SCA_NetworkMessageSensor::Init()
 
 SCA_NetworkMessageSensor::~SCA_NetworkMessageSensor()
 {
+  ReleaseLists();
 }
 
 EXP_Value *SCA_NetworkMessageSensor::GetReplica()
@@ -78,6 +82,24 @@ EXP_Value *SCA_NetworkMessageSensor::GetReplica()
   return replica;
 }
 
+void SCA_NetworkMessageSensor::ProcessReplica()
+{
+  SCA_ISensor::ProcessReplica();
+
+  // The lists of the original sensor are not shared.
+  m_BodyList = nullptr;
+  m_SubjectList = nullptr;
+  m_subjectId = m_NetworkScene->RegisterName(m_subject);
+}
+
+void SCA_NetworkMessageSensor::Replace_NetworkScene(KX_NetworkMessageScene *val)
+{
+  m_NetworkScene = val;
+  m_messages = KX_NetworkMessageManager::MessageView();
+  // The name identifiers are only valid in the message manager of the scene.
+  m_subjectId = m_NetworkScene->RegisterName(m_subject);
+}
+
 /// Return true only for flank (UP and DOWN)
 bool SCA_NetworkMessageSensor::Evaluate()
 {
@@ -86,47 +108,22 @@ bool SCA_NetworkMessageSensor::Evaluate()
 
   m_IsUp = false;
 
-  if (m_BodyList) {
-    m_BodyList->Release();
-    m_BodyList = nullptr;
-  }
-
-  if (m_SubjectList) {
-    m_SubjectList->Release();
-    m_SubjectList = nullptr;
-  }
+  ReleaseLists();
 
-  std::string toname = GetParent()->GetName();
-  std::string &subject = this->m_subject;
+  /* The receiver name is only looked up, an object never used as receiver
+   * doesn't have any message. */
+  const KX_NetworkMessageManager::NameId to = m_NetworkScene->FindName(GetParent()->GetName());
 
-  const std::vector<KX_NetworkMessageManager::Message> messages = m_NetworkScene->FindMessages(
-      toname, subject);
+  m_messages = m_NetworkScene->FindMessages(to, m_subjectId);
+  m_messageFrame = m_NetworkScene->GetFrame();
 
-  m_frame_message_count = messages.size();
+  m_frame_message_count = m_messages.size();
 
-  if (!messages.empty()) {
+  if (!m_messages.empty()) {
 #ifdef NAN_NET_DEBUG
     std::cout << "SCA_NetworkMessageSensor found one or more messages" << std::endl;
 #endif
     m_IsUp = true;
-    m_BodyList = new EXP_ListValue<EXP_StringValue>();
-    m_SubjectList = new EXP_ListValue<EXP_StringValue>();
-  }
-
-  std::vector<KX_NetworkMessageManager::Message>::const_iterator mesit;
-  for (mesit = messages.begin(); mesit != messages.end(); mesit++) {
-    // save the body
-    const std::string &body = (*mesit).body;
-    // save the subject
-    const std::string &messub = (*mesit).subject;
-#ifdef NAN_NET_DEBUG
-    if (body) {
-      cout << "body [" << body << "]\n";
-    }
-#endif
-    m_BodyList->Add(new EXP_StringValue(body, "body"));
-    // Store Subject
-    m_SubjectList->Add(new EXP_StringValue(messub, "subject"));
   }
 
   result = (WasUp != m_IsUp);
@@ -139,6 +136,45 @@ bool SCA_NetworkMessageSensor::Evaluate()
   return result;
 }
 
+void SCA_NetworkMessageSensor::ReleaseLists()
+{
+  if (m_BodyList) {
+    m_BodyList->Release();
+    m_BodyList = nullptr;
+  }
+
+  if (m_SubjectList) {
+    m_SubjectList->Release();
+    m_SubjectList = nullptr;
+  }
+}
+
+void SCA_NetworkMessageSensor::BuildLists()
+{
+  m_BodyList = new EXP_ListValue<EXP_StringValue>();
+  m_SubjectList = new EXP_ListValue<EXP_StringValue>();
+
+  // The messages are cleared at the end of the frame, the lists are empty after.
+  if (m_NetworkScene->GetFrame() != m_messageFrame) {
+    return;
+  }
+
+  for (const KX_NetworkMessageManager::MessageSpan &span : m_messages.m_spans) {
+    for (const KX_NetworkMessageManager::Message &message : span) {
+      // save the body
+      const std::string body(message.body);
+      // save the subject
+      const std::string &messub = m_NetworkScene->GetName(message.subject);
+#ifdef NAN_NET_DEBUG
+      std::cout << "body [" << body << "]\n";
+#endif
+      m_BodyList->Add(new EXP_StringValue(body, "body"));
+      // Store Subject
+      m_SubjectList->Add(new EXP_StringValue(messub, "subject"));
+    }
+  }
+}
+
 /// return true for being up (no flank needed)
 bool SCA_NetworkMessageSensor::IsPositiveTrigger()
 {
@@ -199,7 +235,8 @@ PyMethodDef SCA_NetworkMessageSensor::Methods[] = {
 };
 
 PyAttributeDef SCA_NetworkMessageSensor::Attributes[] = {
-    EXP_PYATTRIBUTE_STRING_RW("subject", 0, 100, false, SCA_NetworkMessageSensor, m_subject),
+    EXP_PYATTRIBUTE_STRING_RW_CHECK(
+        "subject", 0, 100, false, SCA_NetworkMessageSensor, m_subject, CheckSubject),
     EXP_PYATTRIBUTE_INT_RO("frameMessageCount", SCA_NetworkMessageSensor, m_frame_message_count),
     EXP_PYATTRIBUTE_RO_FUNCTION("bodies", SCA_NetworkMessageSensor, pyattr_get_bodies),
     EXP_PYATTRIBUTE_RO_FUNCTION("subjects", SCA_NetworkMessageSensor, pyattr_get_subjects),
@@ -210,24 +247,27 @@ PyObject *SCA_NetworkMessageSensor::pyattr_get_bodies(EXP_PyObjectPlus *self_v,
                                                       const EXP_PYATTRIBUTE_DEF *attrdef)
 {
   SCA_NetworkMessageSensor *self = static_cast<SCA_NetworkMessageSensor *>(self_v);
-  if (self->m_BodyList) {
-    return self->m_BodyList->GetProxy();
-  }
-  else {
-    return (new EXP_ListValue<EXP_StringValue>())->NewProxy(true);
+  if (!self->m_BodyList) {
+    self->BuildLists();
   }
+  return self->m_BodyList->GetProxy();
 }
 
 PyObject *SCA_NetworkMessageSensor::pyattr_get_subjects(EXP_PyObjectPlus *self_v,
                                                         const EXP_PYATTRIBUTE_DEF *attrdef)
 {
   SCA_NetworkMessageSensor *self = static_cast<SCA_NetworkMessageSensor *>(self_v);
-  if (self->m_SubjectList) {
-    return self->m_SubjectList->GetProxy();
-  }
-  else {
-    return (new EXP_ListValue<EXP_StringValue>())->NewProxy(true);
+  if (!self->m_SubjectList) {
+    self->BuildLists();
   }
+  return self->m_SubjectList->GetProxy();
+}
+
+int SCA_NetworkMessageSensor::CheckSubject(EXP_PyObjectPlus *self, const PyAttributeDef *)
+{
+  SCA_NetworkMessageSensor *sensor = static_cast<SCA_NetworkMessageSensor *>(self);
+  sensor->m_subjectId = sensor->m_NetworkScene->RegisterName(sensor->m_subject);
+  return 0;
 }
 
 #endif  // WITH_PYTHON
@@ -31,6 +31,7 @@
  */
 #pragma once
 
+#include "KX_NetworkMessageManager.h"
 #include "SCA_ISensor.h"
 
 class KX_NetworkMessageScene;
@@ -43,15 +44,26 @@ class SCA_NetworkMessageSensor : public SCA_ISensor {
 
   // The subject we filter on.
   std::string m_subject;
+  // The interned subject, used to find the messages.
+  unsigned int m_subjectId;
 
   // The number of messages caught since the last frame.
   int m_frame_message_count;
 
   bool m_IsUp;
 
+  // The messages caught in the last evaluation.
+  KX_NetworkMessageManager::MessageView m_messages;
+  // The message frame of the caught messages, they are invalid once it changed.
+  unsigned int m_messageFrame;
+
+  // The bodies and subjects of the caught messages, only created when read from python.
   EXP_ListValue<EXP_StringValue> *m_BodyList;
   EXP_ListValue<EXP_StringValue> *m_SubjectList;
 
+  void ReleaseLists();
+  void BuildLists();
+
  public:
   SCA_NetworkMessageSensor(SCA_EventManager *eventmgr,            // our eventmanager
                            KX_NetworkMessageScene *NetworkScene,  // our scene
@@ -60,15 +72,13 @@ class SCA_NetworkMessageSensor : public SCA_ISensor {
   virtual ~SCA_NetworkMessageSensor();
 
   virtual EXP_Value *GetReplica();
+  virtual void ProcessReplica();
   virtual bool Evaluate();
   virtual bool IsPositiveTrigger();
   virtual void Init();
   void EndFrame();
 
-  virtual void Replace_NetworkScene(KX_NetworkMessageScene *val)
-  {
-    m_NetworkScene = val;
-  };
+  virtual void Replace_NetworkScene(KX_NetworkMessageScene *val);
 
 #ifdef WITH_PYTHON
 
@@ -80,6 +90,7 @@ class SCA_NetworkMessageSensor : public SCA_ISensor {
   static PyObject *pyattr_get_bodies(EXP_PyObjectPlus *self_v, const EXP_PYATTRIBUTE_DEF *attrdef);
   static PyObject *pyattr_get_subjects(EXP_PyObjectPlus *self_v,
                                        const EXP_PYATTRIBUTE_DEF *attrdef);
+  static int CheckSubject(EXP_PyObjectPlus *self, const PyAttributeDef *);
 
 #endif /* WITH_PYTHON */
 };
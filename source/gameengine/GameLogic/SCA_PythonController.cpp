@@ -41,6 +41,7 @@
 #endif  // WITH_PYTHON
 
 #include "CM_Message.h"
+#include "CM_Profiler.h"
 
 // initialize static member variables
 SCA_PythonController *SCA_PythonController::m_sCurrentController = nullptr;
@@ -54,7 +55,8 @@ SCA_PythonController::SCA_PythonController(SCA_IObject *gameobj, int mode)
       m_function_argc(0),
       m_bModified(true),
       m_debug(false),
-      m_mode(mode)
+      m_mode(mode),
+      m_profileName(nullptr)
 #ifdef WITH_PYTHON
       ,
       m_pythondictionary(nullptr)
@@ -118,6 +120,7 @@ void SCA_PythonController::SetScriptText(const std::string &text)
 void SCA_PythonController::SetScriptName(const std::string &name)
 {
   m_scriptName = name;
+  m_profileName = nullptr;
 }
 
 bool SCA_PythonController::IsTriggered(class SCA_ISensor *sensor)
@@ -347,6 +350,8 @@ bool SCA_PythonController::Import()
 
 void SCA_PythonController::Trigger(SCA_LogicManager *logicmgr)
 {
+  CM_PROFILE_SCOPE_CACHED(m_profileName, m_scriptName);
+
   m_sCurrentController = this;
 
   PyObject *excdict = nullptr;
@@ -53,6 +53,8 @@ class SCA_PythonController : public SCA_IController {
  protected:
   std::string m_scriptText;
   std::string m_scriptName;
+  /// Script name interned for the profiler scope.
+  const char *m_profileName;
 #ifdef WITH_PYTHON
   PyObject *m_pythondictionary; /* for SCA_PYEXEC_SCRIPT only */
   PyObject *m_pythonfunction;   /* for SCA_PYEXEC_MODULE only */
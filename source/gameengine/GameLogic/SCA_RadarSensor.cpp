@@ -34,6 +34,7 @@
 #include "DNA_sensor_types.h"
 
 #include "KX_GameObject.h"
+#include "MT_MinMax.h"
 #include "PHY_IMotionState.h"
 #include "PHY_IPhysicsController.h"
 
@@ -155,7 +156,7 @@ void SCA_RadarSensor::SynchronizeTransform()
   m_cone_target[1] = temp[1];
   m_cone_target[2] = temp[2];
 
-  if (m_physCtrl) {
+  if (m_physCtrl && !m_useSpatialHash) {
     PHY_IMotionState *motionState = m_physCtrl->GetMotionState();
     motionState->SetWorldPosition(trans.getOrigin());
     motionState->SetWorldOrientation(trans.getBasis());
@@ -163,6 +164,44 @@ void SCA_RadarSensor::SynchronizeTransform()
   }
 }
 
+void SCA_RadarSensor::GetSensedAabb(MT_Vector3 &aabbMin, MT_Vector3 &aabbMax)
+{
+  // The cone origin is the center of the cone, its apex is the parent position.
+  const MT_Vector3 target(m_cone_target);
+  const MT_Vector3 apex = MT_Vector3(m_cone_origin) * 2.0f - target;
+  const MT_Vector3 radius(m_coneradius, m_coneradius, m_coneradius);
+  for (unsigned short i = 0; i < 3; ++i) {
+    aabbMin[i] = MT_min(apex[i], target[i] - radius[i]);
+    aabbMax[i] = MT_max(apex[i], target[i] + radius[i]);
+  }
+}
+
+bool SCA_RadarSensor::TestSensedAabb(const MT_Vector3 &aabbMin, const MT_Vector3 &aabbMax)
+{
+  const MT_Vector3 target(m_cone_target);
+  const MT_Vector3 apex = MT_Vector3(m_cone_origin) * 2.0f - target;
+  const MT_Scalar height = m_coneheight;
+  if (height <= 0.0f) {
+    return false;
+  }
+  const MT_Vector3 axis = (target - apex) / height;
+
+  // Test the bounding sphere of the box against the cone.
+  const MT_Vector3 center = (aabbMin + aabbMax) * 0.5f;
+  const MT_Scalar radius = (aabbMax - aabbMin).length() * 0.5f;
+  const MT_Vector3 delta = center - apex;
+  const MT_Scalar t = delta.dot(axis);
+  if (t < -radius || t > height + radius) {
+    return false;
+  }
+
+  const MT_Scalar distance = (delta - axis * t).length();
+  const MT_Scalar coneRadius = m_coneradius * MT_max(MT_Scalar(0.0f), MT_min(t, height)) / height;
+  // The sphere touches the side of the cone at its radius along the normal of the side.
+  const MT_Scalar cosAngle = height / sqrt(height * height + m_coneradius * m_coneradius);
+  return (distance <= coneRadius + radius / cosAngle);
+}
+
 /* ------------------------------------------------------------------------- */
 /* Python Functions															 */
 /* ------------------------------------------------------------------------- */
@@ -74,6 +74,8 @@ class SCA_RadarSensor : public SCA_NearSensor {
   virtual ~SCA_RadarSensor();
   virtual void SynchronizeTransform();
   virtual EXP_Value *GetReplica();
+  virtual void GetSensedAabb(MT_Vector3 &aabbMin, MT_Vector3 &aabbMax);
+  virtual bool TestSensedAabb(const MT_Vector3 &aabbMin, const MT_Vector3 &aabbMax);
 
   /* --------------------------------------------------------------------- */
   /* Python interface ---------------------------------------------------- */
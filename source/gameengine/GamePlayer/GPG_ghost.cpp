@@ -120,6 +120,7 @@
 #include "windowmanager/intern/wm_window_private.h"
 
 #include "CM_Message.h"
+#include "CM_Profiler.h"
 #include "KX_Globals.h"
 #include "KX_PythonInit.h"
 #include "LA_PlayerLauncher.h"
@@ -526,6 +527,7 @@ static void usage(const std::string &program, bool isBlenderPlayer)
   CM_Message("       ignore_deprecation_warnings    1         Ignore deprecation warnings"
              << std::endl);
   CM_Message("  -p: override python main loop script");
+  CM_Message("  -t: write a Chrome trace of the frames to a file (chrome://tracing, Perfetto)");
   CM_Message(std::endl);
   CM_Message(
       "  - : all arguments after this are ignored, allowing python to access them from sys.argv");
@@ -767,6 +769,7 @@ int main(int argc,
   int validArguments = 0;
   bool samplesParFound = false;
   std::string pythonControllerFile;
+  std::string profileFile;
   uint16_t aasamples = 0;
   int alphaBackground = 0;
 
@@ -1342,6 +1345,17 @@ int main(int argc,
           pythonControllerFile = argv[i++];
           break;
         }
+        case 't': {
+          ++i;
+          if (i < validArguments) {
+            profileFile = argv[i++];
+          }
+          else {
+            error = true;
+            CM_Error("no trace file specified.");
+          }
+          break;
+        }
         default:  // not recognized
         {
           CM_Warning("unknown argument: " << argv[i++]);
@@ -1411,6 +1425,10 @@ int main(int argc,
         /* We don't want to use other windows than the one where is the 3D view */
         std::vector<wmWindow *> unused_windows = {};
 
+        if (!profileFile.empty()) {
+          CM_Profiler::Start(profileFile);
+        }
+
         do {
           // Read the Blender file
 
@@ -1766,6 +1784,9 @@ int main(int argc,
           }
         } while (!quitGame(exitcode));
 
+        // Also stops a capture started from Python.
+        CM_Profiler::Stop();
+
         /* Restore the windows we disabled during standalone runtime to free it
          * (normally) in standalone exit pipeline */
         for (wmWindow *tmp_win : unused_windows) {
@@ -32,58 +32,275 @@
 
 #include "KX_NetworkMessageManager.h"
 
-KX_NetworkMessageManager::KX_NetworkMessageManager() : m_currentList(0)
+#include <algorithm>
+#include <cstring>
+
+/// Minimal size of the blocks storing the message bodies.
+static const unsigned int bodyBlockSize = 4096;
+/// Number of names interned by the messages before the unused names are removed.
+static const unsigned int maxUnusedNames = 1024;
+
+static uint64_t span_key(KX_NetworkMessageManager::NameId to,
+                         KX_NetworkMessageManager::NameId subject)
 {
+  return (((uint64_t)to) << 32) | subject;
 }
 
-KX_NetworkMessageManager::~KX_NetworkMessageManager()
+KX_NetworkMessageManager::BodyArena::BodyArena() : m_current(0), m_used(0)
 {
-  ClearMessages();
 }
 
-void KX_NetworkMessageManager::AddMessage(KX_NetworkMessageManager::Message message)
+std::string_view KX_NetworkMessageManager::BodyArena::Store(const std::string &body)
 {
-  // Put the new message in map for the given receiver and subject.
-  m_messages[m_currentList][message.to][message.subject].push_back(message);
+  const unsigned int size = body.size();
+  if (size == 0) {
+    return std::string_view();
+  }
+
+  // Continue in the next block if the body doesn't fit in the remaining space.
+  if (m_current < m_blocks.size() && m_used > 0 && m_blocks[m_current].m_size - m_used < size) {
+    ++m_current;
+    m_used = 0;
+  }
+
+  if (m_current == m_blocks.size()) {
+    m_blocks.push_back({nullptr, 0});
+  }
+
+  // The block is empty here, it can be reallocated for a large body.
+  Block &block = m_blocks[m_current];
+  if (block.m_size - m_used < size) {
+    block.m_size = std::max(size, bodyBlockSize);
+    block.m_data.reset(new char[block.m_size]);
+  }
+
+  char *data = block.m_data.get() + m_used;
+  memcpy(data, body.data(), size);
+  m_used += size;
+
+  return std::string_view(data, size);
+}
+
+void KX_NetworkMessageManager::BodyArena::Clear()
+{
+  m_current = 0;
+  m_used = 0;
+}
+
+KX_NetworkMessageManager::MessageList::MessageList() : m_freeze(0)
+{
+}
+
+void KX_NetworkMessageManager::MessageList::Clear()
+{
+  m_messages.clear();
+  m_bodies.Clear();
+
+  // Remove the keys not set again by the last freeze.
+  for (const uint64_t key : m_oldKeys) {
+    const auto it = m_spans.find(key);
+    if (it != m_spans.end() && it->second.m_freeze != m_freeze) {
+      m_spans.erase(it);
+    }
+  }
+  for (const uint64_t key : m_keys) {
+    m_spans[key].m_span = {nullptr, nullptr};
+  }
+
+  std::swap(m_oldKeys, m_keys);
+  m_keys.clear();
 }
 
-const std::vector<KX_NetworkMessageManager::Message> KX_NetworkMessageManager::GetMessages(
-    std::string to, std::string subject)
+void KX_NetworkMessageManager::MessageList::Freeze()
 {
-  std::vector<KX_NetworkMessageManager::Message> messages;
+  ++m_freeze;
+
+  if (m_messages.empty()) {
+    return;
+  }
+
+  auto setSpan = [this](uint64_t key, const Message *begin, const Message *end) {
+    SpanEntry &entry = m_spans[key];
+    entry.m_span = {begin, end};
+    entry.m_freeze = m_freeze;
+    m_keys.push_back(key);
+  };
 
-  // look at messages without receiver.
-  std::map<std::string, std::vector<Message>> &messagesNoReceiver =
-      m_messages[1 - m_currentList][""];
-  std::map<std::string, std::vector<Message>> &messagesReceiver =
-      m_messages[1 - m_currentList][to];
-  if (subject.empty()) {
-    // Add all message without receiver and subject.
-    for (const auto &pair : messagesNoReceiver) {
-      messages.insert(messages.end(), pair.second.begin(), pair.second.end());
+  // Keep the sending order of the messages with the same receiver and subject.
+  auto less = [](const Message &message1, const Message &message2) {
+    return (message1.to < message2.to) ||
+           (message1.to == message2.to && message1.subject < message2.subject);
+  };
+  if (!std::is_sorted(m_messages.begin(), m_messages.end(), less)) {
+    std::stable_sort(m_messages.begin(), m_messages.end(), less);
+  }
+
+  const Message *end = m_messages.data() + m_messages.size();
+  for (const Message *it = m_messages.data(); it != end;) {
+    const Message *receiverEnd = it;
+    while (receiverEnd != end && receiverEnd->to == it->to) {
+      ++receiverEnd;
     }
-    // Add all message with the given receiver and no subject.
-    for (const auto &pair : messagesReceiver) {
-      messages.insert(messages.end(), pair.second.begin(), pair.second.end());
+    setSpan(span_key(it->to, AnySubject), it, receiverEnd);
+
+    while (it != receiverEnd) {
+      const Message *subjectEnd = it;
+      while (subjectEnd != receiverEnd && subjectEnd->subject == it->subject) {
+        ++subjectEnd;
+      }
+      setSpan(span_key(it->to, it->subject), it, subjectEnd);
+      it = subjectEnd;
     }
   }
+}
+
+KX_NetworkMessageManager::MessageSpan KX_NetworkMessageManager::MessageList::FindSpan(
+    NameId to, NameId subject) const
+{
+  if (to == InvalidName || subject == InvalidName) {
+    return {nullptr, nullptr};
+  }
+
+  const auto it = m_spans.find(span_key(to, subject));
+  if (it == m_spans.end()) {
+    return {nullptr, nullptr};
+  }
+
+  return it->second.m_span;
+}
+
+KX_NetworkMessageManager::KX_NetworkMessageManager()
+    : m_prunedNamesCount(0), m_currentList(0), m_frame(0)
+{
+  // The empty name is used for the messages sent to all objects.
+  RegisterName("");
+}
+
+KX_NetworkMessageManager::~KX_NetworkMessageManager()
+{
+}
+
+KX_NetworkMessageManager::NameId KX_NetworkMessageManager::InternName(const std::string &name)
+{
+  const auto it = m_nameIds.find(name);
+  if (it != m_nameIds.end()) {
+    m_names[it->second].m_frame = m_frame;
+    return it->second;
+  }
+
+  NameId id;
+  if (m_freeNames.empty()) {
+    id = m_names.size();
+    m_names.push_back({name, m_frame, false});
+  }
   else {
-    std::vector<KX_NetworkMessageManager::Message> &messagesNoReceiverSubject =
-        messagesNoReceiver[subject];
-    messages.insert(
-        messages.end(), messagesNoReceiverSubject.begin(), messagesNoReceiverSubject.end());
-    std::vector<KX_NetworkMessageManager::Message> &messagesReceiverSubject =
-        messagesReceiver[subject];
-    messages.insert(
-        messages.end(), messagesReceiverSubject.begin(), messagesReceiverSubject.end());
+    id = m_freeNames.back();
+    m_freeNames.pop_back();
+    m_names[id] = {name, m_frame, false};
   }
+  m_nameIds.emplace(name, id);
 
-  return messages;
+  return id;
+}
+
+void KX_NetworkMessageManager::PruneNames()
+{
+  for (NameId id = 0, size = m_names.size(); id < size; ++id) {
+    Name &name = m_names[id];
+    /* The messages of the current frame and of the last frame, still read by the sensors,
+     * are the only ones using the names. */
+    if (name.m_registered || name.m_frame + 1 >= m_frame || name.m_name.empty()) {
+      continue;
+    }
+
+    m_nameIds.erase(name.m_name);
+    name.m_name.clear();
+    name.m_name.shrink_to_fit();
+    m_freeNames.push_back(id);
+  }
+
+  m_prunedNamesCount = m_nameIds.size();
+}
+
+KX_NetworkMessageManager::NameId KX_NetworkMessageManager::RegisterName(const std::string &name)
+{
+  const NameId id = InternName(name);
+  m_names[id].m_registered = true;
+
+  return id;
+}
+
+KX_NetworkMessageManager::NameId KX_NetworkMessageManager::FindName(const std::string &name) const
+{
+  const auto it = m_nameIds.find(name);
+  if (it == m_nameIds.end()) {
+    return InvalidName;
+  }
+
+  return it->second;
+}
+
+const std::string &KX_NetworkMessageManager::GetName(NameId id) const
+{
+  return m_names[id].m_name;
+}
+
+void KX_NetworkMessageManager::AddMessage(const std::string &to,
+                                          SCA_IObject *from,
+                                          const std::string &subject,
+                                          const std::string &body)
+{
+  MessageList &list = m_messages[m_currentList];
+
+  Message message;
+  message.to = InternName(to);
+  message.from = from;
+  message.subject = InternName(subject);
+  message.body = list.m_bodies.Store(body);
+
+  list.m_messages.push_back(message);
+}
+
+KX_NetworkMessageManager::MessageView KX_NetworkMessageManager::GetMessages(NameId to,
+                                                                            NameId subject) const
+{
+  const MessageList &list = m_messages[1 - m_currentList];
+
+  // The empty subject matches all the messages.
+  if (subject == 0) {
+    subject = AnySubject;
+  }
+
+  MessageView view;
+  // Look at messages without receiver.
+  view.m_spans[0] = list.FindSpan(0, subject);
+  // Look at messages with the given receiver.
+  view.m_spans[1] = (to == 0) ? MessageSpan{nullptr, nullptr} : list.FindSpan(to, subject);
+
+  return view;
 }
 
 void KX_NetworkMessageManager::ClearMessages()
 {
   // Clear previous list.
-  m_messages[1 - m_currentList].clear();
+  m_messages[1 - m_currentList].Clear();
   m_currentList = 1 - m_currentList;
+  // The messages of the last frame are only read now.
+  m_messages[1 - m_currentList].Freeze();
+  ++m_frame;
+
+  // Bound the names interned by the messages, e.g. a subject containing a counter.
+  if (m_nameIds.size() > m_prunedNamesCount + maxUnusedNames) {
+    PruneNames();
+  }
+}
+
+unsigned int KX_NetworkMessageManager::GetFrame() const
+{
+  return m_frame;
+}
+
+KX_NetworkReplication &KX_NetworkMessageManager::GetReplication()
+{
+  return m_replication;
 }
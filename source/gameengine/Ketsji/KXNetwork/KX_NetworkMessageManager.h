@@ -34,51 +34,193 @@ conflicts with KX_NetworkMessageManager::SendMessage */
 #  undef SendMessage
 #endif
 
-#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "KX_NetworkReplication.h"
+
 class SCA_IObject;
 
 class KX_NetworkMessageManager {
  public:
+  /// Identifier of an interned receiver or subject name, the empty name is always 0.
+  typedef unsigned int NameId;
+
+  /// Name never interned, used for a receiver without any message.
+  static constexpr NameId InvalidName = (NameId)-1;
+
   struct Message {
     /// Receiver object(s) name.
-    std::string to;
+    NameId to;
     /// Sender game object.
     SCA_IObject *from;
     /// Message subject, used as filter.
-    std::string subject;
-    /// Message body.
-    std::string body;
+    NameId subject;
+    /// Message body, valid until the messages of the frame are cleared.
+    std::string_view body;
+  };
+
+  /// Contiguous messages of the same receiver and subject.
+  struct MessageSpan {
+    const Message *m_begin;
+    const Message *m_end;
+
+    const Message *begin() const
+    {
+      return m_begin;
+    }
+    const Message *end() const
+    {
+      return m_end;
+    }
+    unsigned int size() const
+    {
+      return (m_end - m_begin);
+    }
+  };
+
+  /// Messages sent to all objects followed by the messages sent to a receiver.
+  struct MessageView {
+    MessageSpan m_spans[2];
+
+    unsigned int size() const
+    {
+      return m_spans[0].size() + m_spans[1].size();
+    }
+    bool empty() const
+    {
+      return (size() == 0);
+    }
   };
 
  private:
+  /// Subject of the spans containing all the messages of a receiver.
+  static constexpr NameId AnySubject = (NameId)-2;
+
+  /// Storage of the message bodies never moving the stored bodies.
+  class BodyArena {
+   private:
+    struct Block {
+      std::unique_ptr<char[]> m_data;
+      unsigned int m_size;
+    };
+
+    std::vector<Block> m_blocks;
+    /// Index of the block being filled.
+    unsigned int m_current;
+    /// Used size of the block being filled.
+    unsigned int m_used;
+
+   public:
+    BodyArena();
+
+    std::string_view Store(const std::string &body);
+    /// Reuse all the blocks, invalidating the stored bodies.
+    void Clear();
+  };
+
+  struct SpanEntry {
+    MessageSpan m_span;
+    /// Number of the last freeze setting the span.
+    unsigned int m_freeze;
+  };
+
+  struct MessageList {
+    /// Messages sorted by receiver and subject once the list is not filled anymore.
+    std::vector<Message> m_messages;
+    BodyArena m_bodies;
+    /** Messages per receiver and subject, the key is the receiver in the high bits.
+     * The keys of the last two freezes are kept to avoid allocations, only the spans are
+     * reset, the older keys are removed.
+     */
+    std::unordered_map<uint64_t, SpanEntry> m_spans;
+    /// Keys set by the last freeze.
+    std::vector<uint64_t> m_keys;
+    /// Keys set by the freeze before the last one.
+    std::vector<uint64_t> m_oldKeys;
+    /// Number of freezes of the list.
+    unsigned int m_freeze;
+
+    MessageList();
+
+    void Clear();
+    /// Sort the messages and index them by receiver and subject.
+    void Freeze();
+    MessageSpan FindSpan(NameId to, NameId subject) const;
+  };
+
+  struct Name {
+    std::string m_name;
+    /// Frame of the last message using the name.
+    unsigned int m_frame;
+    /// The name is used by a sensor, it is never removed.
+    bool m_registered;
+  };
+
+  /// Interned names and their identifier.
+  std::unordered_map<std::string, NameId> m_nameIds;
+  /// Names by identifier.
+  std::vector<Name> m_names;
+  /// Identifiers of the removed names, reused by the next interned names.
+  std::vector<NameId> m_freeNames;
+  /// Number of names after the last removal of the unused names.
+  unsigned int m_prunedNamesCount;
+
   /** List of all messages, filtered by receiver object(s) name and subject name.
    * We use two lists, one handle sended message in the current frame and the other
    * is used for handle message sended in the last frame for sensors.
    */
-  std::map<std::string, std::map<std::string, std::vector<Message>>> m_messages[2];
+  MessageList m_messages[2];
 
   /** Since we use two list for the current and last frame we have to switch of
    * current message list each frame. This value is only 0 or 1.
    */
   unsigned short m_currentList;
+  /// Number of message frames, incremented by ClearMessages.
+  unsigned int m_frame;
+
+  /// Replication of the game objects with other game instances over UDP.
+  KX_NetworkReplication m_replication;
+
+  /// Intern a name used by a message, removed once no message of the last frame uses it.
+  NameId InternName(const std::string &name);
+  /// Remove the names not used by a sensor or by the messages of the last frame.
+  void PruneNames();
 
  public:
   KX_NetworkMessageManager();
   virtual ~KX_NetworkMessageManager();
 
+  /// Return the identifier of a name used by a sensor, interning the name if needed.
+  NameId RegisterName(const std::string &name);
+  /// Return the identifier of a name or InvalidName if the name was never interned.
+  NameId FindName(const std::string &name) const;
+  const std::string &GetName(NameId id) const;
+
   /** Add a message in the next message list.
-   * \param message The given message to add.
+   * \param to The receiver object(s) name.
+   * \param from The sender game object.
+   * \param subject The message subject.
+   * \param body The message body, copied in the frame message storage.
    */
-  void AddMessage(Message message);
+  void AddMessage(const std::string &to,
+                  SCA_IObject *from,
+                  const std::string &subject,
+                  const std::string &body);
   /** Get all messages for a given receiver object name and message subject.
+   * The returned messages are valid until the next call to ClearMessages.
    * \param to The object(s) name.
-   * \param subject The message subject/filter.
+   * \param subject The message subject/filter, the empty subject matches all subjects.
    */
-  const std::vector<Message> GetMessages(std::string to, std::string subject);
+  MessageView GetMessages(NameId to, NameId subject) const;
 
   /// Clear all messages
   void ClearMessages();
+  /// Number of the current message frame, the messages are valid while it doesn't change.
+  unsigned int GetFrame() const;
+
+  KX_NetworkReplication &GetReplication();
 };
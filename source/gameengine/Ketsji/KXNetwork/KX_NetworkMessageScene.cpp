@@ -41,23 +41,37 @@ KX_NetworkMessageScene::~KX_NetworkMessageScene()
 {
 }
 
-void KX_NetworkMessageScene::SendMessage(std::string to,
+void KX_NetworkMessageScene::SendMessage(const std::string &to,
                                          SCA_IObject *from,
-                                         std::string subject,
-                                         std::string body)
+                                         const std::string &subject,
+                                         const std::string &body)
 {
-  KX_NetworkMessageManager::Message message;
-  message.to = to;
-  message.from = from;
-  message.subject = subject;
-  message.body = body;
+  // Put the new message in the list of the current frame.
+  m_messageManager->AddMessage(to, from, subject, body);
+}
+
+KX_NetworkMessageManager::NameId KX_NetworkMessageScene::RegisterName(const std::string &name)
+{
+  return m_messageManager->RegisterName(name);
+}
 
-  // Put the new message in map for the given receiver and subject.
-  m_messageManager->AddMessage(message);
+KX_NetworkMessageManager::NameId KX_NetworkMessageScene::FindName(const std::string &name) const
+{
+  return m_messageManager->FindName(name);
 }
 
-const std::vector<KX_NetworkMessageManager::Message> KX_NetworkMessageScene::FindMessages(
-    std::string to, std::string subject)
+const std::string &KX_NetworkMessageScene::GetName(KX_NetworkMessageManager::NameId id) const
+{
+  return m_messageManager->GetName(id);
+}
+
+KX_NetworkMessageManager::MessageView KX_NetworkMessageScene::FindMessages(
+    KX_NetworkMessageManager::NameId to, KX_NetworkMessageManager::NameId subject)
 {
   return m_messageManager->GetMessages(to, subject);
 }
+
+unsigned int KX_NetworkMessageScene::GetFrame() const
+{
+  return m_messageManager->GetFrame();
+}
@@ -39,9 +39,7 @@ conflicts with KX_NetworkMessageScene::SendMessage */
 
 #include "KX_NetworkMessageManager.h"
 
-#include <map>
 #include <string>
-#include <vector>
 
 class SCA_IObject;
 
@@ -60,12 +58,23 @@ class KX_NetworkMessageScene {
    * \param subject The message subject, used as filter for receiver object(s).
    * \param message The body of the message.
    */
-  void SendMessage(std::string to, SCA_IObject *from, std::string subject, std::string body);
+  void SendMessage(const std::string &to,
+                   SCA_IObject *from,
+                   const std::string &subject,
+                   const std::string &body);
+
+  /// Return the identifier of a receiver or subject name, interning the name if needed.
+  KX_NetworkMessageManager::NameId RegisterName(const std::string &name);
+  /// Return the identifier of a name or InvalidName if no message used this name.
+  KX_NetworkMessageManager::NameId FindName(const std::string &name) const;
+  const std::string &GetName(KX_NetworkMessageManager::NameId id) const;
 
   /** Get all messages for a given receiver object name and message subject.
-   * \param to The object(s) name.
-   * \param subject The message subject/filter.
+   * \param to The object(s) name identifier.
+   * \param subject The message subject/filter identifier.
    */
-  const std::vector<KX_NetworkMessageManager::Message> FindMessages(std::string to,
-                                                                    std::string subject);
+  KX_NetworkMessageManager::MessageView FindMessages(KX_NetworkMessageManager::NameId to,
+                                                     KX_NetworkMessageManager::NameId subject);
+  /// Number of the message frame, the found messages are valid while it doesn't change.
+  unsigned int GetFrame() const;
 };
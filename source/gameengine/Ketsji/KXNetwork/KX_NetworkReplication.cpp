@@ -0,0 +1,357 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXNetwork/KX_NetworkReplication.cpp
+ *  \ingroup ketsjinet
+ */
+
+#include "KX_NetworkReplication.h"
+
+#include <algorithm>
+
+#include "CM_Message.h"
+#include "EXP_BoolValue.h"
+#include "EXP_FloatValue.h"
+#include "EXP_IntValue.h"
+#include "KX_GameObject.h"
+#include "KX_ReplicationPeer.h"
+#include "KX_Scene.h"
+
+KX_NetworkReplication::KX_NetworkReplication() : m_nextId(0), m_update(0)
+{
+}
+
+KX_NetworkReplication::~KX_NetworkReplication()
+{
+  Stop();
+}
+
+bool KX_NetworkReplication::StartServer(unsigned short port, double rate)
+{
+  Stop();
+
+  std::unique_ptr<KX_ReplicationServer> server(new KX_ReplicationServer());
+  if (!server->Open(port, rate)) {
+    return false;
+  }
+
+  m_server = std::move(server);
+  return true;
+}
+
+bool KX_NetworkReplication::StartClient(const std::string &host,
+                                        unsigned short port,
+                                        double delay)
+{
+  Stop();
+
+  KX_NetworkAddress address;
+  if (!KX_NetworkAddress::Resolve(host, port, address)) {
+    CM_Error("unknown replication server host \"" << host << "\".");
+    return false;
+  }
+
+  std::unique_ptr<KX_ReplicationClient> client(new KX_ReplicationClient());
+  if (!client->Open(address, delay)) {
+    return false;
+  }
+
+  m_client = std::move(client);
+  return true;
+}
+
+void KX_NetworkReplication::Stop()
+{
+  m_server.reset();
+  m_client.reset();
+  m_serverObjects.clear();
+  m_samples.clear();
+  m_clientObjects.clear();
+}
+
+bool KX_NetworkReplication::IsServer() const
+{
+  return (m_server != nullptr);
+}
+
+bool KX_NetworkReplication::IsClient() const
+{
+  return (m_client != nullptr);
+}
+
+void KX_NetworkReplication::UpdateServer(EXP_ListValue<KX_Scene> *scenes, double time)
+{
+  m_server->Receive(time);
+
+  if (!m_server->NeedSnapshot(time)) {
+    return;
+  }
+
+  ++m_update;
+
+  KX_ReplicationSnapshot snapshot;
+  KX_ReplicationLayout layout;
+  for (KX_Scene *scene : scenes) {
+    for (KX_GameObject *gameobj : scene->GetObjectList()) {
+      if (!gameobj->IsReplicated()) {
+        continue;
+      }
+
+      std::pair<std::unordered_map<KX_GameObject *, ServerObject>::iterator, bool> result =
+          m_serverObjects.emplace(gameobj, ServerObject());
+      ServerObject &object = result.first->second;
+      /* The address of a removed object can be reused by a new replica, pooled or not, the
+       * serial given by the scene to each added replica tells them apart. The new id removes
+       * the previous object on the clients. */
+      if (result.second || object.m_serial != gameobj->GetSerial()) {
+        object.m_id = ++m_nextId;
+        object.m_serial = gameobj->GetSerial();
+        object.m_layout.reset();
+      }
+      object.m_update = m_update;
+
+      KX_ReplicationState state;
+      state.m_id = object.m_id;
+      state.SetPosition(gameobj->NodeGetWorldPosition());
+      state.SetOrientation(gameobj->NodeGetWorldOrientation().getRotation());
+
+      // Only the properties of simple types are replicated.
+      layout.m_name = gameobj->GetName();
+      layout.m_propertyNames.clear();
+      layout.m_propertyTypes.clear();
+      for (const std::string &name : gameobj->GetPropertyNames()) {
+        EXP_Value *prop = gameobj->GetProperty(name);
+        KX_ReplicationLayout::PropertyType type;
+        switch (prop->GetValueType()) {
+          case VALUE_INT_TYPE: {
+            type = KX_ReplicationLayout::PROPERTY_INT;
+            break;
+          }
+          case VALUE_FLOAT_TYPE: {
+            type = KX_ReplicationLayout::PROPERTY_FLOAT;
+            break;
+          }
+          case VALUE_BOOL_TYPE: {
+            type = KX_ReplicationLayout::PROPERTY_BOOL;
+            break;
+          }
+          default: {
+            continue;
+          }
+        }
+        layout.m_propertyNames.push_back(name);
+        layout.m_propertyTypes.push_back(type);
+        state.m_properties.push_back(prop->GetNumber());
+      }
+
+      // Share the layout between the snapshots while the object keeps its name and properties.
+      if (!object.m_layout || !(*object.m_layout == layout)) {
+        object.m_layout = std::make_shared<KX_ReplicationLayout>(layout);
+      }
+      state.m_layout = object.m_layout;
+
+      snapshot.m_states.push_back(state);
+    }
+  }
+
+  // Forget the deleted objects and the objects not replicated anymore.
+  for (std::unordered_map<KX_GameObject *, ServerObject>::iterator it = m_serverObjects.begin();
+       it != m_serverObjects.end();)
+  {
+    if (it->second.m_update != m_update) {
+      it = m_serverObjects.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  std::sort(snapshot.m_states.begin(),
+            snapshot.m_states.end(),
+            [](const KX_ReplicationState &state1, const KX_ReplicationState &state2) {
+              return state1.m_id < state2.m_id;
+            });
+
+  m_server->Send(snapshot, time);
+}
+
+static void apply_property(KX_GameObject *gameobj,
+                           const std::string &name,
+                           KX_ReplicationLayout::PropertyType type,
+                           double value)
+{
+  EXP_Value *prop = gameobj->GetProperty(name);
+  if (prop && prop->GetNumber() == value) {
+    return;
+  }
+
+  EXP_Value *newprop;
+  switch (type) {
+    case KX_ReplicationLayout::PROPERTY_INT: {
+      newprop = new EXP_IntValue((cInt)value, name);
+      break;
+    }
+    case KX_ReplicationLayout::PROPERTY_FLOAT: {
+      newprop = new EXP_FloatValue((float)value, name);
+      break;
+    }
+    case KX_ReplicationLayout::PROPERTY_BOOL: {
+      newprop = new EXP_BoolValue(value != 0.0, name);
+      break;
+    }
+    default: {
+      return;
+    }
+  }
+
+  gameobj->SetProperty(name, newprop);
+  newprop->Release();
+}
+
+KX_NetworkReplication::ClientObject KX_NetworkReplication::BindClientObject(
+    const std::string &name,
+    std::unordered_multimap<std::string, std::pair<KX_GameObject *, KX_Scene *>> &unbound,
+    EXP_ListValue<KX_Scene> *scenes)
+{
+  ClientObject object = {nullptr, nullptr, 0};
+
+  // Objects present in both games, as the objects of the active layers.
+  std::unordered_multimap<std::string, std::pair<KX_GameObject *, KX_Scene *>>::iterator it =
+      unbound.find(name);
+  if (it != unbound.end()) {
+    object.m_object = it->second.first;
+    object.m_scene = it->second.second;
+    unbound.erase(it);
+    return object;
+  }
+
+  // Objects added by the server.
+  for (KX_Scene *scene : scenes) {
+    KX_GameObject *original = scene->GetInactiveList()->FindValue(name);
+    if (original) {
+      object.m_object = scene->AddReplicaObject(original, nullptr);
+      object.m_scene = scene;
+      // The object is owned by the scene.
+      object.m_object->Release();
+      return object;
+    }
+  }
+
+  CM_Warning("no replicated or inactive object named \"" << name << "\" for a server object.");
+  return object;
+}
+
+void KX_NetworkReplication::UpdateClient(EXP_ListValue<KX_Scene> *scenes, double time)
+{
+  m_client->Receive(time);
+  m_client->Interpolate(time, m_samples);
+
+  if (m_samples.empty()) {
+    return;
+  }
+
+  ++m_update;
+
+  /* The objects of the client can be deleted by its logic at any time, the bindings of the
+   * objects not in the scenes anymore are dropped and the others are skipped. */
+  std::unordered_map<KX_GameObject *, KX_Scene *> objects;
+  for (KX_Scene *scene : scenes) {
+    for (KX_GameObject *gameobj : scene->GetObjectList()) {
+      if (gameobj->IsReplicated()) {
+        objects.emplace(gameobj, scene);
+      }
+    }
+  }
+
+  for (std::unordered_map<uint32_t, ClientObject>::iterator it = m_clientObjects.begin();
+       it != m_clientObjects.end();)
+  {
+    KX_GameObject *gameobj = it->second.m_object;
+    if (gameobj && objects.erase(gameobj) == 0) {
+      it = m_clientObjects.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  std::unordered_multimap<std::string, std::pair<KX_GameObject *, KX_Scene *>> unbound;
+  for (const std::pair<KX_GameObject *const, KX_Scene *> &pair : objects) {
+    unbound.emplace(pair.first->GetName(), pair);
+  }
+
+  for (const KX_ReplicationSample &sample : m_samples) {
+    const KX_ReplicationLayout &layout = *sample.m_state->m_layout;
+    std::unordered_map<uint32_t, ClientObject>::iterator it = m_clientObjects.find(
+        sample.m_state->m_id);
+    if (it == m_clientObjects.end()) {
+      it = m_clientObjects
+               .emplace(sample.m_state->m_id, BindClientObject(layout.m_name, unbound, scenes))
+               .first;
+    }
+
+    ClientObject &object = it->second;
+    object.m_update = m_update;
+
+    KX_GameObject *gameobj = object.m_object;
+    if (!gameobj) {
+      continue;
+    }
+
+    gameobj->NodeSetWorldPosition(sample.m_position);
+    gameobj->NodeSetGlobalOrientation(MT_Matrix3x3(sample.m_orientation));
+    gameobj->NodeUpdateGS(0.0f);
+
+    for (unsigned int i = 0, size = layout.m_propertyNames.size(); i < size; ++i) {
+      apply_property(gameobj,
+                     layout.m_propertyNames[i],
+                     layout.m_propertyTypes[i],
+                     sample.m_state->m_properties[i]);
+    }
+  }
+
+  // Remove the objects removed by the server.
+  for (std::unordered_map<uint32_t, ClientObject>::iterator it = m_clientObjects.begin();
+       it != m_clientObjects.end();)
+  {
+    const ClientObject &object = it->second;
+    if (object.m_update != m_update) {
+      if (object.m_object) {
+        object.m_scene->DelayedRemoveObject(object.m_object);
+      }
+      it = m_clientObjects.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+}
+
+void KX_NetworkReplication::Update(EXP_ListValue<KX_Scene> *scenes, double time)
+{
+  if (m_server) {
+    UpdateServer(scenes, time);
+  }
+  else if (m_client) {
+    UpdateClient(scenes, time);
+  }
+}
@@ -0,0 +1,109 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_NetworkReplication.h
+ *  \ingroup ketsjinet
+ *  \brief Replication of the game objects marked as replicated between a server and clients.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "EXP_ListValue.h"
+
+class KX_GameObject;
+class KX_Scene;
+class KX_ReplicationServer;
+class KX_ReplicationClient;
+struct KX_ReplicationLayout;
+struct KX_ReplicationSample;
+
+/** The server sends the world transform and the integer, float and boolean properties of its
+ * replicated objects, identified by an id given by the server. A client binds each id to one
+ * of its replicated objects of the same name not bound yet, or adds a replica of the
+ * inactive object of this name, and removes the object when the id disappears.
+ */
+class KX_NetworkReplication {
+ private:
+  struct ServerObject {
+    uint32_t m_id;
+    /// Serial of the replica given the id, a pooled object reused by a new replica has a new one.
+    unsigned int m_serial;
+    /// Last update where the object was found.
+    unsigned int m_update;
+    std::shared_ptr<const KX_ReplicationLayout> m_layout;
+  };
+
+  struct ClientObject {
+    /// Object receiving the states of the server object, nullptr if none could be found.
+    KX_GameObject *m_object;
+    KX_Scene *m_scene;
+    /// Last update where the server object was received.
+    unsigned int m_update;
+  };
+
+  std::unique_ptr<KX_ReplicationServer> m_server;
+  std::unique_ptr<KX_ReplicationClient> m_client;
+
+  std::unordered_map<KX_GameObject *, ServerObject> m_serverObjects;
+  uint32_t m_nextId;
+  unsigned int m_update;
+
+  std::vector<KX_ReplicationSample> m_samples;
+  /// Objects of the client per server id.
+  std::unordered_map<uint32_t, ClientObject> m_clientObjects;
+
+  /** Find the object receiving a new server object, an unbound replicated object of the same
+   * name or a replica of the inactive object of this name.
+   */
+  ClientObject BindClientObject(
+      const std::string &name,
+      std::unordered_multimap<std::string, std::pair<KX_GameObject *, KX_Scene *>> &unbound,
+      EXP_ListValue<KX_Scene> *scenes);
+
+  void UpdateServer(EXP_ListValue<KX_Scene> *scenes, double time);
+  void UpdateClient(EXP_ListValue<KX_Scene> *scenes, double time);
+
+ public:
+  KX_NetworkReplication();
+  ~KX_NetworkReplication();
+
+  /** Send the replicated objects to the clients.
+   * \param rate The number of snapshots sent per second.
+   */
+  bool StartServer(unsigned short port, double rate);
+  /** Receive the replicated objects from a server.
+   * \param delay The time in the past at which the objects are shown.
+   */
+  bool StartClient(const std::string &host, unsigned short port, double delay);
+  void Stop();
+
+  bool IsServer() const;
+  bool IsClient() const;
+
+  /// Send or receive the objects, called once per frame after the logic and the physics.
+  void Update(EXP_ListValue<KX_Scene> *scenes, double time);
+};
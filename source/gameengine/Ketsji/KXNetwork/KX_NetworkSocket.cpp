@@ -0,0 +1,238 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXNetwork/KX_NetworkSocket.cpp
+ *  \ingroup ketsjinet
+ */
+
+#include "KX_NetworkSocket.h"
+
+#ifdef WIN32
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#  define NATIVE_SOCKET(sock) ((SOCKET)(sock))
+#else
+#  include <arpa/inet.h>
+#  include <fcntl.h>
+#  include <netdb.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#  define NATIVE_SOCKET(sock) ((int)(sock))
+#endif
+
+#include <cstring>
+
+#include "CM_Message.h"
+
+static const intptr_t invalidSocket = -1;
+
+#ifdef WIN32
+/// Initialize Winsock once for the whole program.
+static bool init_sockets()
+{
+  static const bool initialized = []() {
+    WSADATA data;
+    return (WSAStartup(MAKEWORD(2, 2), &data) == 0);
+  }();
+  return initialized;
+}
+#endif
+
+KX_NetworkAddress::KX_NetworkAddress() : m_host(0), m_port(0)
+{
+}
+
+bool KX_NetworkAddress::Resolve(const std::string &host,
+                                uint16_t port,
+                                KX_NetworkAddress &address)
+{
+#ifdef WIN32
+  if (!init_sockets()) {
+    return false;
+  }
+#endif
+
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  addrinfo *result = nullptr;
+  if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+    return false;
+  }
+
+  address.m_host = ((sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
+  address.m_port = port;
+  freeaddrinfo(result);
+
+  return true;
+}
+
+std::string KX_NetworkAddress::GetText() const
+{
+  const uint8_t *bytes = (const uint8_t *)&m_host;
+  return std::to_string(bytes[0]) + "." + std::to_string(bytes[1]) + "." +
+         std::to_string(bytes[2]) + "." + std::to_string(bytes[3]) + ":" +
+         std::to_string(m_port);
+}
+
+bool KX_NetworkAddress::operator==(const KX_NetworkAddress &other) const
+{
+  return (m_host == other.m_host && m_port == other.m_port);
+}
+
+KX_NetworkSocket::KX_NetworkSocket() : m_socket(invalidSocket)
+{
+}
+
+KX_NetworkSocket::~KX_NetworkSocket()
+{
+  Close();
+}
+
+bool KX_NetworkSocket::Open(uint16_t port)
+{
+  Close();
+
+#ifdef WIN32
+  if (!init_sockets()) {
+    CM_Error("can't initialize Winsock.");
+    return false;
+  }
+  SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock == INVALID_SOCKET) {
+    CM_Error("can't create UDP socket.");
+    return false;
+  }
+#else
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0) {
+    CM_Error("can't create UDP socket.");
+    return false;
+  }
+#endif
+
+  m_socket = (intptr_t)sock;
+
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+
+  if (bind(sock, (const sockaddr *)&address, sizeof(address)) != 0) {
+    CM_Error("can't bind UDP socket to port " << port << ".");
+    Close();
+    return false;
+  }
+
+#ifdef WIN32
+  u_long nonBlocking = 1;
+  const bool success = (ioctlsocket(sock, FIONBIO, &nonBlocking) == 0);
+#else
+  const bool success = (fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK) != -1);
+#endif
+  if (!success) {
+    CM_Error("can't set UDP socket non blocking.");
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+void KX_NetworkSocket::Close()
+{
+  if (m_socket == invalidSocket) {
+    return;
+  }
+
+#ifdef WIN32
+  closesocket(NATIVE_SOCKET(m_socket));
+#else
+  close(NATIVE_SOCKET(m_socket));
+#endif
+  m_socket = invalidSocket;
+}
+
+bool KX_NetworkSocket::IsOpen() const
+{
+  return (m_socket != invalidSocket);
+}
+
+uint16_t KX_NetworkSocket::GetPort() const
+{
+  if (m_socket == invalidSocket) {
+    return 0;
+  }
+
+  sockaddr_in address;
+  socklen_t addressSize = sizeof(address);
+  if (getsockname(NATIVE_SOCKET(m_socket), (sockaddr *)&address, &addressSize) != 0) {
+    return 0;
+  }
+
+  return ntohs(address.sin_port);
+}
+
+bool KX_NetworkSocket::Send(const KX_NetworkAddress &address, const uint8_t *data, size_t size)
+{
+  if (m_socket == invalidSocket || size > MaxPacketSize) {
+    return false;
+  }
+
+  sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_addr.s_addr = address.m_host;
+  to.sin_port = htons(address.m_port);
+
+  const int sent = sendto(NATIVE_SOCKET(m_socket),
+                          (const char *)data,
+                          (int)size,
+                          0,
+                          (const sockaddr *)&to,
+                          sizeof(to));
+  return (sent == (int)size);
+}
+
+int KX_NetworkSocket::Receive(KX_NetworkAddress &address, uint8_t *data, size_t size)
+{
+  if (m_socket == invalidSocket) {
+    return -1;
+  }
+
+  sockaddr_in from;
+  socklen_t fromSize = sizeof(from);
+  const int received = recvfrom(
+      NATIVE_SOCKET(m_socket), (char *)data, (int)size, 0, (sockaddr *)&from, &fromSize);
+  if (received < 0) {
+    return -1;
+  }
+
+  address.m_host = from.sin_addr.s_addr;
+  address.m_port = ntohs(from.sin_port);
+
+  return received;
+}
@@ -0,0 +1,76 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_NetworkSocket.h
+ *  \ingroup ketsjinet
+ *  \brief Non blocking IPv4 UDP socket.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct KX_NetworkAddress {
+  /// IPv4 address in network byte order.
+  uint32_t m_host;
+  /// Port in host byte order.
+  uint16_t m_port;
+
+  KX_NetworkAddress();
+
+  /// Resolve a host name or a dotted address, return false if the host is unknown.
+  static bool Resolve(const std::string &host, uint16_t port, KX_NetworkAddress &address);
+
+  std::string GetText() const;
+
+  bool operator==(const KX_NetworkAddress &other) const;
+};
+
+class KX_NetworkSocket {
+ private:
+  /// Native socket handle, an int or a SOCKET.
+  intptr_t m_socket;
+
+ public:
+  /// Largest UDP packet payload.
+  static const size_t MaxPacketSize = 65507;
+
+  KX_NetworkSocket();
+  ~KX_NetworkSocket();
+
+  /** Open the socket listening on the port of all the interfaces.
+   * \param port The port, 0 to use any free port.
+   */
+  bool Open(uint16_t port);
+  void Close();
+  bool IsOpen() const;
+  /// Return the local port of the socket, useful when opened on any free port.
+  uint16_t GetPort() const;
+
+  bool Send(const KX_NetworkAddress &address, const uint8_t *data, size_t size);
+  /** Receive a pending packet.
+   * \return The packet size or -1 if no packet was received.
+   */
+  int Receive(KX_NetworkAddress &address, uint8_t *data, size_t size);
+};
@@ -0,0 +1,244 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXNetwork/KX_NetworkStream.cpp
+ *  \ingroup ketsjinet
+ */
+
+#include "KX_NetworkStream.h"
+
+#include <cstring>
+
+/// Longest string accepted in a packet.
+static const uint64_t maxStringSize = 1024;
+
+KX_NetworkWriter::KX_NetworkWriter()
+{
+}
+
+KX_NetworkWriter::~KX_NetworkWriter()
+{
+}
+
+const std::vector<uint8_t> &KX_NetworkWriter::GetData() const
+{
+  return m_data;
+}
+
+void KX_NetworkWriter::Clear()
+{
+  m_data.clear();
+}
+
+void KX_NetworkWriter::WriteUInt8(uint8_t value)
+{
+  m_data.push_back(value);
+}
+
+void KX_NetworkWriter::WriteUInt16(uint16_t value)
+{
+  m_data.push_back(value & 0xFF);
+  m_data.push_back(value >> 8);
+}
+
+void KX_NetworkWriter::WriteUInt32(uint32_t value)
+{
+  for (unsigned short i = 0; i < 4; ++i) {
+    m_data.push_back((value >> (i * 8)) & 0xFF);
+  }
+}
+
+void KX_NetworkWriter::WriteInt16(int16_t value)
+{
+  WriteUInt16((uint16_t)value);
+}
+
+void KX_NetworkWriter::WriteFloat(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  WriteUInt32(bits);
+}
+
+void KX_NetworkWriter::WriteDouble(double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  WriteUInt32(bits & 0xFFFFFFFF);
+  WriteUInt32(bits >> 32);
+}
+
+void KX_NetworkWriter::WriteVarUInt(uint64_t value)
+{
+  while (value >= 0x80) {
+    m_data.push_back((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  m_data.push_back(value);
+}
+
+void KX_NetworkWriter::WriteVarInt(int64_t value)
+{
+  WriteVarUInt(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void KX_NetworkWriter::WriteString(const std::string &value)
+{
+  WriteVarUInt(value.size());
+  m_data.insert(m_data.end(), value.begin(), value.end());
+}
+
+void KX_NetworkWriter::WriteBytes(const uint8_t *data, size_t size)
+{
+  m_data.insert(m_data.end(), data, data + size);
+}
+
+KX_NetworkReader::KX_NetworkReader(const uint8_t *data, size_t size)
+    : m_data(data), m_size(size), m_pos(0), m_error(false)
+{
+}
+
+KX_NetworkReader::~KX_NetworkReader()
+{
+}
+
+bool KX_NetworkReader::Check(size_t size)
+{
+  if (m_error || (m_size - m_pos) < size) {
+    m_error = true;
+    return false;
+  }
+  return true;
+}
+
+bool KX_NetworkReader::HasError() const
+{
+  return m_error;
+}
+
+bool KX_NetworkReader::IsEnd() const
+{
+  return (!m_error && m_pos == m_size);
+}
+
+uint8_t KX_NetworkReader::ReadUInt8()
+{
+  if (!Check(1)) {
+    return 0;
+  }
+  return m_data[m_pos++];
+}
+
+uint16_t KX_NetworkReader::ReadUInt16()
+{
+  if (!Check(2)) {
+    return 0;
+  }
+  const uint16_t value = m_data[m_pos] | (m_data[m_pos + 1] << 8);
+  m_pos += 2;
+  return value;
+}
+
+uint32_t KX_NetworkReader::ReadUInt32()
+{
+  if (!Check(4)) {
+    return 0;
+  }
+  uint32_t value = 0;
+  for (unsigned short i = 0; i < 4; ++i) {
+    value |= (uint32_t)m_data[m_pos++] << (i * 8);
+  }
+  return value;
+}
+
+int16_t KX_NetworkReader::ReadInt16()
+{
+  return (int16_t)ReadUInt16();
+}
+
+float KX_NetworkReader::ReadFloat()
+{
+  const uint32_t bits = ReadUInt32();
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+double KX_NetworkReader::ReadDouble()
+{
+  const uint64_t low = ReadUInt32();
+  const uint64_t bits = low | ((uint64_t)ReadUInt32() << 32);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint64_t KX_NetworkReader::ReadVarUInt()
+{
+  uint64_t value = 0;
+  for (unsigned short shift = 0; shift < 64; shift += 7) {
+    const uint8_t byte = ReadUInt8();
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return value;
+    }
+  }
+
+  // More than 10 bytes.
+  m_error = true;
+  return 0;
+}
+
+int64_t KX_NetworkReader::ReadVarInt()
+{
+  const uint64_t value = ReadVarUInt();
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+std::string KX_NetworkReader::ReadString()
+{
+  const uint64_t size = ReadVarUInt();
+  if (size > maxStringSize || !Check(size)) {
+    m_error = true;
+    return "";
+  }
+
+  const std::string value((const char *)m_data + m_pos, size);
+  m_pos += size;
+  return value;
+}
+
+const uint8_t *KX_NetworkReader::ReadBytes(size_t size)
+{
+  if (!Check(size)) {
+    return nullptr;
+  }
+
+  const uint8_t *data = m_data + m_pos;
+  m_pos += size;
+  return data;
+}
+
+size_t KX_NetworkReader::GetRemainingSize() const
+{
+  return (m_error) ? 0 : (m_size - m_pos);
+}
@@ -0,0 +1,89 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_NetworkStream.h
+ *  \ingroup ketsjinet
+ *  \brief Little endian serialization of the network packets.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class KX_NetworkWriter {
+ private:
+  std::vector<uint8_t> m_data;
+
+ public:
+  KX_NetworkWriter();
+  ~KX_NetworkWriter();
+
+  const std::vector<uint8_t> &GetData() const;
+  void Clear();
+
+  void WriteUInt8(uint8_t value);
+  void WriteUInt16(uint16_t value);
+  void WriteUInt32(uint32_t value);
+  void WriteInt16(int16_t value);
+  void WriteFloat(float value);
+  void WriteDouble(double value);
+  /// Write an unsigned integer in 7 bits groups, small values use less bytes.
+  void WriteVarUInt(uint64_t value);
+  /// Write a signed integer zigzag encoded, small absolute values use less bytes.
+  void WriteVarInt(int64_t value);
+  void WriteString(const std::string &value);
+  void WriteBytes(const uint8_t *data, size_t size);
+};
+
+/// Reader of a packet, all the reads after an overflow return zero and set the error flag.
+class KX_NetworkReader {
+ private:
+  const uint8_t *m_data;
+  size_t m_size;
+  size_t m_pos;
+  bool m_error;
+
+  bool Check(size_t size);
+
+ public:
+  KX_NetworkReader(const uint8_t *data, size_t size);
+  ~KX_NetworkReader();
+
+  bool HasError() const;
+  /// Return true if all the data was read without error.
+  bool IsEnd() const;
+
+  uint8_t ReadUInt8();
+  uint16_t ReadUInt16();
+  uint32_t ReadUInt32();
+  int16_t ReadInt16();
+  float ReadFloat();
+  double ReadDouble();
+  uint64_t ReadVarUInt();
+  int64_t ReadVarInt();
+  std::string ReadString();
+  /// Return the address of the next size bytes, nullptr after an overflow.
+  const uint8_t *ReadBytes(size_t size);
+  size_t GetRemainingSize() const;
+};
@@ -0,0 +1,577 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXNetwork/KX_ReplicationPeer.cpp
+ *  \ingroup ketsjinet
+ */
+
+#include "KX_ReplicationPeer.h"
+
+#include <algorithm>
+
+#include "CM_Message.h"
+#include "MT_MinMax.h"
+
+/// Packet header: magic, version and packet type.
+static const uint16_t packetMagic = 0x4742;
+static const uint8_t packetVersion = 2;
+
+enum PacketType : uint8_t {
+  /// Client request to receive the snapshots, resent until a snapshot is received.
+  PACKET_CONNECT = 0,
+  /// Client or server leaving.
+  PACKET_DISCONNECT,
+  /// Server snapshot: sequence, baseline sequence, time and object records.
+  PACKET_SNAPSHOT,
+  /// Client acknowledgement of a snapshot sequence.
+  PACKET_ACK,
+  /// Part of a snapshot: sequence, fragment index, fragment count and the snapshot data part.
+  PACKET_FRAGMENT
+};
+
+/// Largest packet sent, below the usual MTU of the internet paths with the IP and UDP headers.
+static const unsigned int maxPacketSize = 1200;
+/// Size of the packet and fragment headers.
+static const unsigned int packetHeaderSize = 4;
+static const unsigned int fragmentHeaderSize = packetHeaderSize + 8;
+/// Limit of fragments of a snapshot, larger snapshots are not sent.
+static const unsigned int maxFragments = 256;
+
+/// Number of sent or received snapshots kept as baselines.
+static const unsigned int historySize = 32;
+static const unsigned int maxClients = 64;
+/// Time without packets before a peer is considered gone.
+static const double connectionTimeout = 5.0;
+static const double connectInterval = 0.5;
+/// Weight of a new sample in the estimation of the server clock offset.
+static const double timeOffsetSmoothing = 0.1;
+
+static void write_header(KX_NetworkWriter &writer, uint8_t type)
+{
+  writer.Clear();
+  writer.WriteUInt16(packetMagic);
+  writer.WriteUInt8(packetVersion);
+  writer.WriteUInt8(type);
+}
+
+/// Return false if the packet doesn't come from a peer of the same version.
+static bool read_header(KX_NetworkReader &reader, uint8_t &type)
+{
+  const uint16_t magic = reader.ReadUInt16();
+  const uint8_t version = reader.ReadUInt8();
+  type = reader.ReadUInt8();
+  return (!reader.HasError() && magic == packetMagic && version == packetVersion);
+}
+
+KX_ReplicationServer::KX_ReplicationServer()
+    : m_sequence(0),
+      m_sendInterval(0.0),
+      m_lastSendTime(0.0),
+      m_buffer(KX_NetworkSocket::MaxPacketSize),
+      m_sizeWarning(false)
+{
+}
+
+KX_ReplicationServer::~KX_ReplicationServer()
+{
+  Close();
+}
+
+bool KX_ReplicationServer::Open(uint16_t port, double rate)
+{
+  if (!m_socket.Open(port)) {
+    return false;
+  }
+
+  m_sendInterval = 1.0 / MT_max(rate, 1.0);
+  m_lastSendTime = -m_sendInterval;
+
+  CM_Message("Replication server listening on port " << m_socket.GetPort() << ".");
+
+  return true;
+}
+
+void KX_ReplicationServer::Close()
+{
+  if (!m_socket.IsOpen()) {
+    return;
+  }
+
+  for (const Client &client : m_clients) {
+    SendPacket(client.m_address, PACKET_DISCONNECT);
+  }
+  m_clients.clear();
+  m_history.clear();
+  m_socket.Close();
+}
+
+KX_ReplicationServer::Client *KX_ReplicationServer::FindClient(const KX_NetworkAddress &address)
+{
+  for (Client &client : m_clients) {
+    if (client.m_address == address) {
+      return &client;
+    }
+  }
+  return nullptr;
+}
+
+const KX_ReplicationSnapshot *KX_ReplicationServer::FindSnapshot(uint32_t sequence) const
+{
+  for (const KX_ReplicationSnapshot &snapshot : m_history) {
+    if (snapshot.m_sequence == sequence) {
+      return &snapshot;
+    }
+  }
+  return nullptr;
+}
+
+void KX_ReplicationServer::SendPacket(const KX_NetworkAddress &address, uint8_t type)
+{
+  write_header(m_writer, type);
+  const std::vector<uint8_t> &data = m_writer.GetData();
+  m_socket.Send(address, data.data(), data.size());
+}
+
+void KX_ReplicationServer::Receive(double time)
+{
+  KX_NetworkAddress address;
+  int size;
+  while ((size = m_socket.Receive(address, m_buffer.data(), m_buffer.size())) >= 0) {
+    KX_NetworkReader reader(m_buffer.data(), size);
+    uint8_t type;
+    if (!read_header(reader, type)) {
+      continue;
+    }
+
+    Client *client = FindClient(address);
+    switch (type) {
+      case PACKET_CONNECT: {
+        if (!client) {
+          if (m_clients.size() >= maxClients) {
+            break;
+          }
+          m_clients.push_back(Client());
+          client = &m_clients.back();
+          client->m_address = address;
+          CM_Message("Replication client " << address.GetText() << " connected.");
+        }
+        // The client has no baseline, the next snapshot is complete.
+        client->m_ackSequence = 0;
+        client->m_lastReceiveTime = time;
+        break;
+      }
+      case PACKET_DISCONNECT: {
+        if (client) {
+          CM_Message("Replication client " << address.GetText() << " disconnected.");
+          m_clients.erase(m_clients.begin() + (client - m_clients.data()));
+        }
+        break;
+      }
+      case PACKET_ACK: {
+        const uint32_t sequence = reader.ReadUInt32();
+        if (client && !reader.HasError() && sequence <= m_sequence &&
+            sequence > client->m_ackSequence) {
+          client->m_ackSequence = sequence;
+        }
+        if (client) {
+          client->m_lastReceiveTime = time;
+        }
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+
+  // Forget the clients gone without notification.
+  for (std::vector<Client>::iterator it = m_clients.begin(); it != m_clients.end();) {
+    if ((time - it->m_lastReceiveTime) > connectionTimeout) {
+      CM_Message("Replication client " << it->m_address.GetText() << " timed out.");
+      it = m_clients.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+}
+
+bool KX_ReplicationServer::NeedSnapshot(double time) const
+{
+  return (m_socket.IsOpen() && (time - m_lastSendTime) >= m_sendInterval);
+}
+
+void KX_ReplicationServer::Send(KX_ReplicationSnapshot &snapshot, double time)
+{
+  // Keep the send times on the interval grid, unless the frames are too long.
+  m_lastSendTime = ((time - m_lastSendTime) < 2.0 * m_sendInterval) ?
+                       m_lastSendTime + m_sendInterval :
+                       time;
+
+  snapshot.m_sequence = ++m_sequence;
+  snapshot.m_time = time;
+
+  for (const Client &client : m_clients) {
+    // The baseline is too old when the client didn't acknowledge the recent snapshots.
+    const KX_ReplicationSnapshot *baseline = FindSnapshot(client.m_ackSequence);
+
+    write_header(m_writer, PACKET_SNAPSHOT);
+    m_writer.WriteUInt32(snapshot.m_sequence);
+    m_writer.WriteUInt32(baseline ? baseline->m_sequence : 0);
+    m_writer.WriteDouble(snapshot.m_time);
+    snapshot.Write(baseline, m_writer);
+
+    const std::vector<uint8_t> &data = m_writer.GetData();
+    if (data.size() <= maxPacketSize) {
+      m_socket.Send(client.m_address, data.data(), data.size());
+      continue;
+    }
+
+    if ((data.size() - packetHeaderSize) > maxFragments * (maxPacketSize - fragmentHeaderSize)) {
+      if (!m_sizeWarning) {
+        CM_Warning("replication snapshot of " << data.size()
+                                              << " bytes is too large for the fragments.");
+        m_sizeWarning = true;
+      }
+      continue;
+    }
+    SendFragments(client.m_address, snapshot.m_sequence, data);
+  }
+
+  m_history.push_back(snapshot);
+  if (m_history.size() > historySize) {
+    m_history.pop_front();
+  }
+}
+
+void KX_ReplicationServer::SendFragments(const KX_NetworkAddress &address,
+                                         uint32_t sequence,
+                                         const std::vector<uint8_t> &data)
+{
+  // The fragments carry the snapshot packet without its header.
+  const unsigned int fragmentSize = maxPacketSize - fragmentHeaderSize;
+  const unsigned int size = data.size() - packetHeaderSize;
+  const unsigned int numFragments = (size + fragmentSize - 1) / fragmentSize;
+
+  for (unsigned int i = 0; i < numFragments; ++i) {
+    const unsigned int offset = i * fragmentSize;
+    write_header(m_fragmentWriter, PACKET_FRAGMENT);
+    m_fragmentWriter.WriteUInt32(sequence);
+    m_fragmentWriter.WriteUInt16(i);
+    m_fragmentWriter.WriteUInt16(numFragments);
+    m_fragmentWriter.WriteBytes(data.data() + packetHeaderSize + offset,
+                                MT_min(fragmentSize, size - offset));
+
+    const std::vector<uint8_t> &fragment = m_fragmentWriter.GetData();
+    m_socket.Send(address, fragment.data(), fragment.size());
+  }
+}
+
+unsigned int KX_ReplicationServer::GetNumClients() const
+{
+  return m_clients.size();
+}
+
+uint16_t KX_ReplicationServer::GetPort() const
+{
+  return m_socket.GetPort();
+}
+
+KX_ReplicationClient::KX_ReplicationClient()
+    : m_connected(false),
+      m_lastConnectTime(0.0),
+      m_lastReceiveTime(0.0),
+      m_timeOffset(0.0),
+      m_interpolationDelay(0.0),
+      m_buffer(KX_NetworkSocket::MaxPacketSize),
+      m_fragmentSequence(0),
+      m_numReceivedFragments(0)
+{
+}
+
+KX_ReplicationClient::~KX_ReplicationClient()
+{
+  Close();
+}
+
+bool KX_ReplicationClient::Open(const KX_NetworkAddress &server, double interpolationDelay)
+{
+  // Any local port, the server answers to the sender address.
+  if (!m_socket.Open(0)) {
+    return false;
+  }
+
+  m_server = server;
+  m_interpolationDelay = interpolationDelay;
+  m_connected = false;
+  // Connect at the first update.
+  m_lastConnectTime = -connectInterval;
+
+  CM_Message("Replication client connecting to " << server.GetText() << ".");
+
+  return true;
+}
+
+void KX_ReplicationClient::Close()
+{
+  if (!m_socket.IsOpen()) {
+    return;
+  }
+
+  SendPacket(PACKET_DISCONNECT, 0);
+  m_snapshots.clear();
+  m_connected = false;
+  m_socket.Close();
+}
+
+void KX_ReplicationClient::SendPacket(uint8_t type, uint32_t sequence)
+{
+  write_header(m_writer, type);
+  if (type == PACKET_ACK) {
+    m_writer.WriteUInt32(sequence);
+  }
+  const std::vector<uint8_t> &data = m_writer.GetData();
+  m_socket.Send(m_server, data.data(), data.size());
+}
+
+void KX_ReplicationClient::Disconnect()
+{
+  m_connected = false;
+  m_snapshots.clear();
+  m_fragments.clear();
+  m_numReceivedFragments = 0;
+}
+
+void KX_ReplicationClient::ReceiveSnapshot(KX_NetworkReader &reader, double time)
+{
+  const uint32_t sequence = reader.ReadUInt32();
+  const uint32_t baselineSequence = reader.ReadUInt32();
+  const double serverTime = reader.ReadDouble();
+  if (reader.HasError()) {
+    return;
+  }
+
+  // Ignore the late and duplicated packets.
+  if (!m_snapshots.empty() && sequence <= m_snapshots.back().m_sequence) {
+    return;
+  }
+
+  const KX_ReplicationSnapshot *baseline = nullptr;
+  if (baselineSequence != 0) {
+    for (const KX_ReplicationSnapshot &snapshot : m_snapshots) {
+      if (snapshot.m_sequence == baselineSequence) {
+        baseline = &snapshot;
+        break;
+      }
+    }
+    // The baseline was dropped, wait for a snapshot against a newer acknowledgement.
+    if (!baseline) {
+      return;
+    }
+  }
+
+  KX_ReplicationSnapshot snapshot;
+  snapshot.m_sequence = sequence;
+  snapshot.m_time = serverTime;
+  if (!snapshot.Read(baseline, reader)) {
+    CM_Warning("invalid replication snapshot " << sequence << " received.");
+    return;
+  }
+
+  const double offset = serverTime - time;
+  if (m_snapshots.empty()) {
+    m_timeOffset = offset;
+  }
+  else {
+    m_timeOffset += (offset - m_timeOffset) * timeOffsetSmoothing;
+  }
+
+  m_snapshots.push_back(std::move(snapshot));
+  if (m_snapshots.size() > historySize) {
+    m_snapshots.pop_front();
+  }
+
+  if (!m_connected) {
+    CM_Message("Replication client connected to " << m_server.GetText() << ".");
+    m_connected = true;
+  }
+
+  SendPacket(PACKET_ACK, sequence);
+}
+
+void KX_ReplicationClient::ReceiveFragment(KX_NetworkReader &reader, double time)
+{
+  const uint32_t sequence = reader.ReadUInt32();
+  const unsigned int index = reader.ReadUInt16();
+  const unsigned int numFragments = reader.ReadUInt16();
+  const size_t size = reader.GetRemainingSize();
+  const uint8_t *data = reader.ReadBytes(size);
+  if (reader.HasError() || size == 0 || index >= numFragments || numFragments > maxFragments) {
+    return;
+  }
+
+  // Ignore the fragments of the late snapshots.
+  if ((!m_snapshots.empty() && sequence <= m_snapshots.back().m_sequence) ||
+      (!m_fragments.empty() && sequence < m_fragmentSequence))
+  {
+    return;
+  }
+
+  // A newer snapshot drops the fragments of the incomplete one.
+  if (m_fragments.empty() || sequence != m_fragmentSequence) {
+    m_fragmentSequence = sequence;
+    m_fragments.clear();
+    m_fragments.resize(numFragments);
+    m_numReceivedFragments = 0;
+  }
+
+  std::vector<uint8_t> &fragment = m_fragments[index];
+  if (numFragments != m_fragments.size() || !fragment.empty()) {
+    return;
+  }
+  fragment.assign(data, data + size);
+
+  if (++m_numReceivedFragments < numFragments) {
+    return;
+  }
+
+  m_fragmentData.clear();
+  for (const std::vector<uint8_t> &part : m_fragments) {
+    m_fragmentData.insert(m_fragmentData.end(), part.begin(), part.end());
+  }
+  m_fragments.clear();
+  m_numReceivedFragments = 0;
+
+  KX_NetworkReader snapshotReader(m_fragmentData.data(), m_fragmentData.size());
+  ReceiveSnapshot(snapshotReader, time);
+}
+
+void KX_ReplicationClient::Receive(double time)
+{
+  if (!m_socket.IsOpen()) {
+    return;
+  }
+
+  KX_NetworkAddress address;
+  int size;
+  while ((size = m_socket.Receive(address, m_buffer.data(), m_buffer.size())) >= 0) {
+    // Only the server is listened.
+    if (!(address == m_server)) {
+      continue;
+    }
+
+    KX_NetworkReader reader(m_buffer.data(), size);
+    uint8_t type;
+    if (!read_header(reader, type)) {
+      continue;
+    }
+
+    m_lastReceiveTime = time;
+
+    switch (type) {
+      case PACKET_SNAPSHOT: {
+        ReceiveSnapshot(reader, time);
+        break;
+      }
+      case PACKET_FRAGMENT: {
+        ReceiveFragment(reader, time);
+        break;
+      }
+      case PACKET_DISCONNECT: {
+        CM_Message("Replication server " << m_server.GetText() << " closed.");
+        Disconnect();
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+
+  if (m_connected && (time - m_lastReceiveTime) > connectionTimeout) {
+    CM_Message("Replication server " << m_server.GetText() << " timed out.");
+    Disconnect();
+  }
+
+  if (!m_connected && (time - m_lastConnectTime) >= connectInterval) {
+    SendPacket(PACKET_CONNECT, 0);
+    m_lastConnectTime = time;
+  }
+}
+
+void KX_ReplicationClient::Interpolate(double time,
+                                       std::vector<KX_ReplicationSample> &samples) const
+{
+  samples.clear();
+
+  if (m_snapshots.empty()) {
+    return;
+  }
+
+  const double renderTime = time + m_timeOffset - m_interpolationDelay;
+
+  // Find the snapshots around the render time, without extrapolation.
+  const KX_ReplicationSnapshot *from = &m_snapshots.front();
+  const KX_ReplicationSnapshot *to = &m_snapshots.back();
+  if (renderTime >= to->m_time) {
+    from = to;
+  }
+  else if (renderTime <= from->m_time) {
+    to = from;
+  }
+  else {
+    for (unsigned int i = 1, size = m_snapshots.size(); i < size; ++i) {
+      if (m_snapshots[i].m_time >= renderTime) {
+        from = &m_snapshots[i - 1];
+        to = &m_snapshots[i];
+        break;
+      }
+    }
+  }
+
+  const double duration = to->m_time - from->m_time;
+  const MT_Scalar factor = (duration > 0.0) ? (renderTime - from->m_time) / duration : 1.0f;
+
+  samples.reserve(to->m_states.size());
+  for (const KX_ReplicationState &toState : to->m_states) {
+    const KX_ReplicationState *fromState = from->FindState(toState.m_id);
+
+    KX_ReplicationSample sample;
+    if (fromState && fromState->m_layout == toState.m_layout) {
+      sample.m_state = fromState;
+      sample.m_position = fromState->GetPosition().lerp(toState.GetPosition(), factor);
+      sample.m_orientation = fromState->GetOrientation().slerp(toState.GetOrientation(), factor);
+    }
+    else {
+      // New object in the last snapshot.
+      sample.m_state = &toState;
+      sample.m_position = toState.GetPosition();
+      sample.m_orientation = toState.GetOrientation();
+    }
+    samples.push_back(sample);
+  }
+}
+
+bool KX_ReplicationClient::IsConnected() const
+{
+  return m_connected;
+}
@@ -0,0 +1,149 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_ReplicationPeer.h
+ *  \ingroup ketsjinet
+ *  \brief Server and client exchanging the snapshots of the replicated objects over UDP.
+ *
+ * The server sends at a fixed rate the snapshot of its objects to each client as a delta
+ * from the last snapshot acknowledged by this client. The clients acknowledge every
+ * snapshot received and interpolate between the received snapshots slightly in the past
+ * to hide the network jitter and the packet loss. The snapshots larger than a packet fitting
+ * the usual MTU are split in fragments, a snapshot missing a fragment is lost.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "KX_NetworkSocket.h"
+#include "KX_NetworkStream.h"
+#include "KX_ReplicationSnapshot.h"
+
+class KX_ReplicationServer {
+ private:
+  struct Client {
+    KX_NetworkAddress m_address;
+    /// Last snapshot received by the client, 0 if none.
+    uint32_t m_ackSequence;
+    double m_lastReceiveTime;
+  };
+
+  KX_NetworkSocket m_socket;
+  std::vector<Client> m_clients;
+  /// Last sent snapshots, used as baselines of the deltas.
+  std::deque<KX_ReplicationSnapshot> m_history;
+  uint32_t m_sequence;
+  double m_sendInterval;
+  double m_lastSendTime;
+  KX_NetworkWriter m_writer;
+  KX_NetworkWriter m_fragmentWriter;
+  std::vector<uint8_t> m_buffer;
+  bool m_sizeWarning;
+
+  Client *FindClient(const KX_NetworkAddress &address);
+  const KX_ReplicationSnapshot *FindSnapshot(uint32_t sequence) const;
+  void SendPacket(const KX_NetworkAddress &address, uint8_t type);
+  /// Send a snapshot packet too large for the MTU in fragments.
+  void SendFragments(const KX_NetworkAddress &address,
+                     uint32_t sequence,
+                     const std::vector<uint8_t> &data);
+
+ public:
+  KX_ReplicationServer();
+  ~KX_ReplicationServer();
+
+  /** Start listening for the clients.
+   * \param rate The number of snapshots sent per second.
+   */
+  bool Open(uint16_t port, double rate);
+  /// Notify the clients and close the socket.
+  void Close();
+
+  /// Handle the connections and the acknowledgements of the clients.
+  void Receive(double time);
+  /// Return true if a snapshot must be sent at this time.
+  bool NeedSnapshot(double time) const;
+  /// Send the snapshot to all the clients, its sequence is set by the server.
+  void Send(KX_ReplicationSnapshot &snapshot, double time);
+
+  unsigned int GetNumClients() const;
+  /// Return the port listened by the server.
+  uint16_t GetPort() const;
+};
+
+/// Interpolated transform of a replicated object.
+struct KX_ReplicationSample {
+  /// State holding the layout and the properties.
+  const KX_ReplicationState *m_state;
+  MT_Vector3 m_position;
+  MT_Quaternion m_orientation;
+};
+
+class KX_ReplicationClient {
+ private:
+  KX_NetworkSocket m_socket;
+  KX_NetworkAddress m_server;
+  /// Received snapshots with increasing sequences.
+  std::deque<KX_ReplicationSnapshot> m_snapshots;
+  bool m_connected;
+  double m_lastConnectTime;
+  double m_lastReceiveTime;
+  /// Estimation of the server time minus the local time.
+  double m_timeOffset;
+  /// Time in the past at which the objects are shown.
+  double m_interpolationDelay;
+  KX_NetworkWriter m_writer;
+  std::vector<uint8_t> m_buffer;
+  /// Sequence of the fragmented snapshot being received.
+  uint32_t m_fragmentSequence;
+  /// Received fragments of the snapshot, empty for the missing ones.
+  std::vector<std::vector<uint8_t>> m_fragments;
+  unsigned int m_numReceivedFragments;
+  std::vector<uint8_t> m_fragmentData;
+
+  void SendPacket(uint8_t type, uint32_t sequence);
+  void ReceiveSnapshot(KX_NetworkReader &reader, double time);
+  /// Store a fragment and receive the snapshot once all its fragments are received.
+  void ReceiveFragment(KX_NetworkReader &reader, double time);
+  void Disconnect();
+
+ public:
+  KX_ReplicationClient();
+  ~KX_ReplicationClient();
+
+  /** Start connecting to a server.
+   * \param interpolationDelay The time in the past at which the objects are shown, it should
+   * be larger than twice the server snapshot interval.
+   */
+  bool Open(const KX_NetworkAddress &server, double interpolationDelay);
+  /// Notify the server and close the socket.
+  void Close();
+
+  /// Receive the snapshots and keep the connection alive.
+  void Receive(double time);
+  /// Compute the states of the objects at the local time, valid until the next Receive.
+  void Interpolate(double time, std::vector<KX_ReplicationSample> &samples) const;
+
+  bool IsConnected() const;
+};
@@ -0,0 +1,411 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KXNetwork/KX_ReplicationSnapshot.cpp
+ *  \ingroup ketsjinet
+ */
+
+#include "KX_ReplicationSnapshot.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "KX_NetworkStream.h"
+#include "MT_MinMax.h"
+
+/// Content of an object record.
+enum RecordFlag : uint8_t {
+  RECORD_CREATE = (1 << 0),
+  RECORD_REMOVE = (1 << 1),
+  RECORD_POSITION = (1 << 2),
+  RECORD_ORIENTATION = (1 << 3),
+  RECORD_PROPERTIES = (1 << 4)
+};
+
+/// Limit of properties per object in a packet.
+static const uint64_t maxProperties = 256;
+/// Scale of the quaternion components in [-1/sqrt(2), 1/sqrt(2)].
+static const double orientationScale = 32767.0 * M_SQRT2;
+
+const float KX_ReplicationState::PositionStep = 1.0f / 1024.0f;
+
+bool KX_ReplicationLayout::operator==(const KX_ReplicationLayout &other) const
+{
+  return (m_name == other.m_name && m_propertyNames == other.m_propertyNames &&
+          m_propertyTypes == other.m_propertyTypes);
+}
+
+void KX_ReplicationState::SetPosition(const MT_Vector3 &position)
+{
+  static const double maxPosition = 2147483647.0;
+  for (unsigned short i = 0; i < 3; ++i) {
+    const double value = std::round((double)position[i] / PositionStep);
+    m_position[i] = (int32_t)MT_max(-maxPosition, MT_min(value, maxPosition));
+  }
+}
+
+MT_Vector3 KX_ReplicationState::GetPosition() const
+{
+  return MT_Vector3(
+      m_position[0] * PositionStep, m_position[1] * PositionStep, m_position[2] * PositionStep);
+}
+
+void KX_ReplicationState::SetOrientation(const MT_Quaternion &orientation)
+{
+  const MT_Scalar length = orientation.length();
+  const MT_Quaternion quat = (length > MT_EPSILON) ? MT_Quaternion(orientation / length) :
+                                                     MT_Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+
+  m_orientationIndex = 0;
+  for (unsigned short i = 1; i < 4; ++i) {
+    if (std::fabs(quat[i]) > std::fabs(quat[m_orientationIndex])) {
+      m_orientationIndex = i;
+    }
+  }
+
+  // q and -q are the same rotation, the largest component is made positive to be deduced.
+  const double sign = (quat[m_orientationIndex] < 0.0f) ? -1.0 : 1.0;
+  for (unsigned short i = 0, j = 0; i < 4; ++i) {
+    if (i != m_orientationIndex) {
+      const double value = std::round(quat[i] * sign * orientationScale);
+      m_orientation[j++] = (int16_t)MT_max(-32767.0, MT_min(value, 32767.0));
+    }
+  }
+}
+
+MT_Quaternion KX_ReplicationState::GetOrientation() const
+{
+  MT_Quaternion quat;
+  double sum = 0.0;
+  for (unsigned short i = 0, j = 0; i < 4; ++i) {
+    if (i != m_orientationIndex) {
+      const double value = m_orientation[j++] / orientationScale;
+      quat[i] = value;
+      sum += value * value;
+    }
+  }
+  quat[m_orientationIndex] = std::sqrt(MT_max(0.0, 1.0 - sum));
+
+  return quat;
+}
+
+static void write_property(KX_ReplicationLayout::PropertyType type,
+                           double value,
+                           KX_NetworkWriter &writer)
+{
+  switch (type) {
+    case KX_ReplicationLayout::PROPERTY_INT: {
+      writer.WriteVarInt((int64_t)value);
+      break;
+    }
+    case KX_ReplicationLayout::PROPERTY_FLOAT: {
+      writer.WriteFloat((float)value);
+      break;
+    }
+    case KX_ReplicationLayout::PROPERTY_BOOL: {
+      writer.WriteUInt8(value != 0.0);
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+}
+
+static double read_property(KX_ReplicationLayout::PropertyType type, KX_NetworkReader &reader)
+{
+  switch (type) {
+    case KX_ReplicationLayout::PROPERTY_INT: {
+      return (double)reader.ReadVarInt();
+    }
+    case KX_ReplicationLayout::PROPERTY_FLOAT: {
+      return reader.ReadFloat();
+    }
+    case KX_ReplicationLayout::PROPERTY_BOOL: {
+      return (reader.ReadUInt8() != 0) ? 1.0 : 0.0;
+    }
+    default: {
+      return 0.0;
+    }
+  }
+}
+
+static void write_orientation(const KX_ReplicationState &state, KX_NetworkWriter &writer)
+{
+  writer.WriteUInt8(state.m_orientationIndex);
+  for (unsigned short i = 0; i < 3; ++i) {
+    writer.WriteInt16(state.m_orientation[i]);
+  }
+}
+
+static bool read_orientation(KX_ReplicationState &state, KX_NetworkReader &reader)
+{
+  state.m_orientationIndex = reader.ReadUInt8();
+  for (unsigned short i = 0; i < 3; ++i) {
+    state.m_orientation[i] = reader.ReadInt16();
+  }
+  return (state.m_orientationIndex < 4);
+}
+
+/// Write a new object with its layout and all its values.
+static void write_create(const KX_ReplicationState &state, KX_NetworkWriter &writer)
+{
+  writer.WriteVarUInt(state.m_id);
+  writer.WriteUInt8(RECORD_CREATE);
+
+  const KX_ReplicationLayout &layout = *state.m_layout;
+  writer.WriteString(layout.m_name);
+  writer.WriteVarUInt(layout.m_propertyNames.size());
+  for (unsigned int i = 0, size = layout.m_propertyNames.size(); i < size; ++i) {
+    writer.WriteString(layout.m_propertyNames[i]);
+    writer.WriteUInt8(layout.m_propertyTypes[i]);
+  }
+
+  for (unsigned short i = 0; i < 3; ++i) {
+    writer.WriteVarInt(state.m_position[i]);
+  }
+  write_orientation(state, writer);
+  for (unsigned int i = 0, size = state.m_properties.size(); i < size; ++i) {
+    write_property(layout.m_propertyTypes[i], state.m_properties[i], writer);
+  }
+}
+
+/// Write the values changed since the baseline state.
+static void write_delta(const KX_ReplicationState &state,
+                        const KX_ReplicationState &base,
+                        KX_NetworkWriter &writer)
+{
+  const KX_ReplicationLayout &layout = *state.m_layout;
+
+  uint8_t flags = 0;
+  if (!std::equal(state.m_position, state.m_position + 3, base.m_position)) {
+    flags |= RECORD_POSITION;
+  }
+  if (state.m_orientationIndex != base.m_orientationIndex ||
+      !std::equal(state.m_orientation, state.m_orientation + 3, base.m_orientation))
+  {
+    flags |= RECORD_ORIENTATION;
+  }
+  unsigned int numChanged = 0;
+  for (unsigned int i = 0, size = state.m_properties.size(); i < size; ++i) {
+    if (state.m_properties[i] != base.m_properties[i]) {
+      ++numChanged;
+    }
+  }
+  if (numChanged > 0) {
+    flags |= RECORD_PROPERTIES;
+  }
+
+  // Unchanged objects are copied from the baseline by the receiver.
+  if (flags == 0) {
+    return;
+  }
+
+  writer.WriteVarUInt(state.m_id);
+  writer.WriteUInt8(flags);
+
+  if (flags & RECORD_POSITION) {
+    for (unsigned short i = 0; i < 3; ++i) {
+      writer.WriteVarInt((int64_t)state.m_position[i] - base.m_position[i]);
+    }
+  }
+  if (flags & RECORD_ORIENTATION) {
+    write_orientation(state, writer);
+  }
+  if (flags & RECORD_PROPERTIES) {
+    writer.WriteVarUInt(numChanged);
+    for (unsigned int i = 0, size = state.m_properties.size(); i < size; ++i) {
+      if (state.m_properties[i] != base.m_properties[i]) {
+        writer.WriteVarUInt(i);
+        write_property(layout.m_propertyTypes[i], state.m_properties[i], writer);
+      }
+    }
+  }
+}
+
+KX_ReplicationSnapshot::KX_ReplicationSnapshot() : m_sequence(0), m_time(0.0)
+{
+}
+
+KX_ReplicationSnapshot::~KX_ReplicationSnapshot()
+{
+}
+
+const KX_ReplicationState *KX_ReplicationSnapshot::FindState(uint32_t id) const
+{
+  std::vector<KX_ReplicationState>::const_iterator it = std::lower_bound(
+      m_states.begin(),
+      m_states.end(),
+      id,
+      [](const KX_ReplicationState &state, uint32_t id) { return state.m_id < id; });
+  if (it != m_states.end() && it->m_id == id) {
+    return &*it;
+  }
+  return nullptr;
+}
+
+void KX_ReplicationSnapshot::Write(const KX_ReplicationSnapshot *baseline,
+                                   KX_NetworkWriter &writer) const
+{
+  static const std::vector<KX_ReplicationState> emptyStates;
+  const std::vector<KX_ReplicationState> &baseStates = baseline ? baseline->m_states :
+                                                                  emptyStates;
+
+  // Merge the two lists sorted by identifier.
+  std::vector<KX_ReplicationState>::const_iterator it = m_states.begin();
+  std::vector<KX_ReplicationState>::const_iterator baseIt = baseStates.begin();
+  while (it != m_states.end() || baseIt != baseStates.end()) {
+    if (it == m_states.end() || (baseIt != baseStates.end() && baseIt->m_id < it->m_id)) {
+      writer.WriteVarUInt(baseIt->m_id);
+      writer.WriteUInt8(RECORD_REMOVE);
+      ++baseIt;
+    }
+    else if (baseIt == baseStates.end() || it->m_id < baseIt->m_id) {
+      write_create(*it, writer);
+      ++it;
+    }
+    else {
+      // The object changed of name or properties.
+      if (it->m_layout != baseIt->m_layout && !(*it->m_layout == *baseIt->m_layout)) {
+        write_create(*it, writer);
+      }
+      else {
+        write_delta(*it, *baseIt, writer);
+      }
+      ++it;
+      ++baseIt;
+    }
+  }
+}
+
+bool KX_ReplicationSnapshot::Read(const KX_ReplicationSnapshot *baseline,
+                                  KX_NetworkReader &reader)
+{
+  static const std::vector<KX_ReplicationState> emptyStates;
+  const std::vector<KX_ReplicationState> &baseStates = baseline ? baseline->m_states :
+                                                                  emptyStates;
+  std::vector<KX_ReplicationState>::const_iterator baseIt = baseStates.begin();
+
+  std::vector<KX_ReplicationState> states;
+  states.reserve(baseStates.size());
+
+  bool first = true;
+  uint32_t lastId = 0;
+  while (!reader.IsEnd()) {
+    const uint64_t id = reader.ReadVarUInt();
+    const uint8_t flags = reader.ReadUInt8();
+    // The records are sorted by identifier.
+    if (reader.HasError() || id > UINT32_MAX || (!first && id <= lastId)) {
+      return false;
+    }
+    first = false;
+    lastId = id;
+
+    // Keep the unchanged objects.
+    for (; baseIt != baseStates.end() && baseIt->m_id < id; ++baseIt) {
+      states.push_back(*baseIt);
+    }
+
+    const KX_ReplicationState *base = nullptr;
+    if (baseIt != baseStates.end() && baseIt->m_id == id) {
+      base = &*baseIt;
+      ++baseIt;
+    }
+
+    if (flags & RECORD_REMOVE) {
+      if (!base) {
+        return false;
+      }
+      continue;
+    }
+
+    if (flags & RECORD_CREATE) {
+      std::shared_ptr<KX_ReplicationLayout> layout = std::make_shared<KX_ReplicationLayout>();
+      layout->m_name = reader.ReadString();
+      const uint64_t numProperties = reader.ReadVarUInt();
+      if (numProperties > maxProperties) {
+        return false;
+      }
+      for (unsigned int i = 0; i < numProperties; ++i) {
+        layout->m_propertyNames.push_back(reader.ReadString());
+        const uint8_t type = reader.ReadUInt8();
+        if (type >= KX_ReplicationLayout::PROPERTY_MAX) {
+          return false;
+        }
+        layout->m_propertyTypes.push_back((KX_ReplicationLayout::PropertyType)type);
+      }
+
+      KX_ReplicationState state;
+      state.m_id = id;
+      state.m_layout = layout;
+      for (unsigned short i = 0; i < 3; ++i) {
+        state.m_position[i] = (int32_t)reader.ReadVarInt();
+      }
+      if (!read_orientation(state, reader)) {
+        return false;
+      }
+      for (unsigned int i = 0; i < numProperties; ++i) {
+        state.m_properties.push_back(read_property(layout->m_propertyTypes[i], reader));
+      }
+      states.push_back(state);
+    }
+    else {
+      if (!base) {
+        return false;
+      }
+
+      KX_ReplicationState state = *base;
+      if (flags & RECORD_POSITION) {
+        for (unsigned short i = 0; i < 3; ++i) {
+          state.m_position[i] = (int32_t)(state.m_position[i] + reader.ReadVarInt());
+        }
+      }
+      if ((flags & RECORD_ORIENTATION) && !read_orientation(state, reader)) {
+        return false;
+      }
+      if (flags & RECORD_PROPERTIES) {
+        const uint64_t numChanged = reader.ReadVarUInt();
+        if (numChanged > state.m_properties.size()) {
+          return false;
+        }
+        for (unsigned int i = 0; i < numChanged; ++i) {
+          const uint64_t index = reader.ReadVarUInt();
+          if (index >= state.m_properties.size()) {
+            return false;
+          }
+          state.m_properties[index] = read_property(state.m_layout->m_propertyTypes[index],
+                                                    reader);
+        }
+      }
+      states.push_back(state);
+    }
+
+    if (reader.HasError()) {
+      return false;
+    }
+  }
+
+  states.insert(states.end(), baseIt, baseStates.end());
+  m_states = std::move(states);
+
+  return !reader.HasError();
+}
@@ -0,0 +1,101 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_ReplicationSnapshot.h
+ *  \ingroup ketsjinet
+ *  \brief Quantized states of the replicated objects and their delta encoding.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MT_Quaternion.h"
+#include "MT_Vector3.h"
+
+class KX_NetworkReader;
+class KX_NetworkWriter;
+
+/// Name and properties of a replicated object, sent when the object appears or changes.
+struct KX_ReplicationLayout {
+  enum PropertyType : uint8_t {
+    PROPERTY_INT = 0,
+    PROPERTY_FLOAT,
+    PROPERTY_BOOL,
+    PROPERTY_MAX
+  };
+
+  std::string m_name;
+  std::vector<std::string> m_propertyNames;
+  std::vector<PropertyType> m_propertyTypes;
+
+  bool operator==(const KX_ReplicationLayout &other) const;
+};
+
+/// Quantized world transform and properties of a replicated object.
+struct KX_ReplicationState {
+  /// Position quantization step.
+  static const float PositionStep;
+
+  /// Identifier of the object given by the server.
+  uint32_t m_id;
+  std::shared_ptr<const KX_ReplicationLayout> m_layout;
+  int32_t m_position[3];
+  /// The three smallest components of the unit quaternion.
+  int16_t m_orientation[3];
+  /// Index of the largest component, deduced from the three others.
+  uint8_t m_orientationIndex;
+  /// Property values, integers and booleans are exact in a double.
+  std::vector<double> m_properties;
+
+  void SetPosition(const MT_Vector3 &position);
+  MT_Vector3 GetPosition() const;
+  void SetOrientation(const MT_Quaternion &orientation);
+  MT_Quaternion GetOrientation() const;
+};
+
+/// States of all the replicated objects at a server frame.
+class KX_ReplicationSnapshot {
+ public:
+  uint32_t m_sequence;
+  /// Server frame time.
+  double m_time;
+  /// States sorted by identifier.
+  std::vector<KX_ReplicationState> m_states;
+
+  KX_ReplicationSnapshot();
+  ~KX_ReplicationSnapshot();
+
+  const KX_ReplicationState *FindState(uint32_t id) const;
+
+  /** Write the objects changed since the baseline, the objects removed and the new objects.
+   * \param baseline The snapshot known by the receiver, nullptr to write all the objects.
+   */
+  void Write(const KX_ReplicationSnapshot *baseline, KX_NetworkWriter &writer) const;
+  /** Read the states written against the baseline until the end of the reader.
+   * \return False if the data is invalid.
+   */
+  bool Read(const KX_ReplicationSnapshot *baseline, KX_NetworkReader &reader);
+};
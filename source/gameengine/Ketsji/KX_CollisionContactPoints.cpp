@@ -204,16 +204,40 @@ std::string KX_CollisionContactPointList::GetName()
   return "KX_CollisionContactPointList";
 }
 
+void KX_CollisionContactPointList::AddCollData(const PHY_ICollData *collData, bool firstObject)
+{
+  m_otherCollData.emplace_back(collData, firstObject);
+}
+
 KX_CollisionContactPoint *KX_CollisionContactPointList::GetCollisionContactPoint(
     unsigned int index)
 {
   // All contact point infos.
-  return (new KX_CollisionContactPoint(m_collData, index, m_firstObject));
+  if (index < m_collData->GetNumContacts()) {
+    return (new KX_CollisionContactPoint(m_collData, index, m_firstObject));
+  }
+
+  // The points of the other manifolds follow the points of the first.
+  index -= m_collData->GetNumContacts();
+  for (const std::pair<const PHY_ICollData *, bool> &other : m_otherCollData) {
+    const unsigned int numContacts = other.first->GetNumContacts();
+    if (index < numContacts) {
+      return (new KX_CollisionContactPoint(other.first, index, other.second));
+    }
+    index -= numContacts;
+  }
+
+  // The list wrapper only asks for the indices below the number of points.
+  return nullptr;
 }
 
 unsigned int KX_CollisionContactPointList::GetNumCollisionContactPoint()
 {
-  return m_collData->GetNumContacts();
+  unsigned int numContacts = m_collData->GetNumContacts();
+  for (const std::pair<const PHY_ICollData *, bool> &other : m_otherCollData) {
+    numContacts += other.first->GetNumContacts();
+  }
+  return numContacts;
 }
 
 const PHY_ICollData *KX_CollisionContactPointList::GetCollData()
@@ -26,6 +26,9 @@
 
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "EXP_ListWrapper.h"
 #include "EXP_Value.h"
 
@@ -76,11 +79,16 @@ class KX_CollisionContactPointList
   const PHY_ICollData *m_collData;
   /// The object is the first in the pair or the second ?
   bool m_firstObject;
+  /// The contact points of the other manifolds of the pair, e.g. for compound shapes.
+  std::vector<std::pair<const PHY_ICollData *, bool>> m_otherCollData;
 
  public:
   KX_CollisionContactPointList(const PHY_ICollData *collData, bool firstObject);
   virtual ~KX_CollisionContactPointList();
 
+  /// Append the contact points of another manifold of the same pair.
+  void AddCollData(const PHY_ICollData *collData, bool firstObject);
+
   virtual std::string GetName();
 
   KX_CollisionContactPoint *GetCollisionContactPoint(unsigned int index);
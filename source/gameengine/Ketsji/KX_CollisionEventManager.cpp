@@ -31,14 +31,28 @@
 
 #include "KX_CollisionEventManager.h"
 
+#include <algorithm>
+
 #include "KX_CollisionContactPoints.h"
+#include "KX_Scene.h"
 #include "PHY_IPhysicsController.h"
 #include "PHY_IPhysicsEnvironment.h"
+#include "SCA_NearSensor.h"
+
+/// Size of the cells of the spatial hash, in the range of the usual sensor distances.
+static const float spatialHashCellSize = 4.0f;
 
 KX_CollisionEventManager::KX_CollisionEventManager(class SCA_LogicManager *logicmgr,
-                                                   PHY_IPhysicsEnvironment *physEnv)
-    : SCA_EventManager(logicmgr, TOUCH_EVENTMGR), m_physEnv(physEnv)
+                                                   PHY_IPhysicsEnvironment *physEnv,
+                                                   KX_Scene *scene,
+                                                   bool useSpatialHash)
+    : SCA_EventManager(logicmgr, TOUCH_EVENTMGR), m_physEnv(physEnv), m_scene(scene)
 {
+  if (useSpatialHash) {
+    m_spatialHash.reset(new KX_SensorSpatialHash(spatialHashCellSize));
+    m_scene->SetSensorSpatialHash(m_spatialHash.get());
+  }
+
   m_physEnv->AddCollisionCallback(
       PHY_OBJECT_RESPONSE, KX_CollisionEventManager::newCollisionResponse, this);
   m_physEnv->AddCollisionCallback(
@@ -49,6 +63,9 @@ KX_CollisionEventManager::KX_CollisionEventManager(class SCA_LogicManager *logic
 
 KX_CollisionEventManager::~KX_CollisionEventManager()
 {
+  if (m_spatialHash) {
+    m_scene->SetSensorSpatialHash(nullptr);
+  }
   RemoveNewCollisions();
 }
 
@@ -62,7 +79,10 @@ bool KX_CollisionEventManager::NewHandleCollision(PHY_IPhysicsController *ctrl1,
                                                   const PHY_ICollData *coll_data,
                                                   bool first)
 {
-  m_newCollisions.insert(NewCollision(ctrl1, ctrl2, coll_data, first));
+  const unsigned int step = m_physEnv->GetCollisionStep();
+  const unsigned int index = m_newCollisions.size();
+  m_newCollisions.emplace_back(ctrl1, ctrl2, coll_data, first, step, index);
+  m_newCollisions.emplace_back(ctrl2, ctrl1, coll_data, !first, step, index);
 
   return false;
 }
@@ -142,9 +162,27 @@ bool KX_CollisionEventManager::newBroadphaseResponse(void *client_data,
   return true;
 }
 
+bool KX_CollisionEventManager::UseSpatialHash(SCA_ISensor *sensor) const
+{
+  const SCA_ISensor::sensortype type = sensor->GetSensorType();
+  return m_spatialHash && (type == SCA_ISensor::ST_NEAR || type == SCA_ISensor::ST_RADAR);
+}
+
 bool KX_CollisionEventManager::RegisterSensor(SCA_ISensor *sensor)
 {
   if (SCA_EventManager::RegisterSensor(sensor)) {
+    if (UseSpatialHash(sensor)) {
+      // the ghost object of the sensor is not added to the physics
+      static_cast<SCA_NearSensor *>(sensor)->SetUseSpatialHash(true);
+      return true;
+    }
+
+    const SCA_ISensor::sensortype type = sensor->GetSensorType();
+    if (type == SCA_ISensor::ST_NEAR || type == SCA_ISensor::ST_RADAR) {
+      // the sensor can come from a scene using the spatial hash
+      static_cast<SCA_NearSensor *>(sensor)->SetUseSpatialHash(false);
+    }
+
     SCA_CollisionSensor *collisionsensor = static_cast<SCA_CollisionSensor *>(sensor);
     // the sensor was effectively inserted, register it
     collisionsensor->RegisterSumo(this);
@@ -157,6 +195,10 @@ bool KX_CollisionEventManager::RegisterSensor(SCA_ISensor *sensor)
 bool KX_CollisionEventManager::RemoveSensor(SCA_ISensor *sensor)
 {
   if (SCA_EventManager::RemoveSensor(sensor)) {
+    if (UseSpatialHash(sensor)) {
+      return true;
+    }
+
     SCA_CollisionSensor *collisionsensor = static_cast<SCA_CollisionSensor *>(sensor);
     // the sensor was effectively removed, unregister it
     collisionsensor->UnregisterSumo(this);
@@ -179,40 +221,65 @@ void KX_CollisionEventManager::NextFrame()
     static_cast<SCA_CollisionSensor *>(sensor)->SynchronizeTransform();
   }
 
-  for (const NewCollision &collision : m_newCollisions) {
-    // Controllers
-    PHY_IPhysicsController *ctrl1 = collision.first;
-    PHY_IPhysicsController *ctrl2 = collision.second;
-    // Sensor iterator
-    std::list<SCA_ISensor *>::iterator sit;
+  if (m_spatialHash) {
+    /* Move the objects whose transform changed in the grid once, then sense them for all
+     * the Near and Radar sensors. */
+    m_spatialHash->Update(m_scene->GetObjectList());
+    for (SCA_ISensor *sensor : m_sensors) {
+      if (UseSpatialHash(sensor)) {
+        static_cast<SCA_NearSensor *>(sensor)->SenseSpatialHash(*m_spatialHash,
+                                                                m_spatialHashEntries);
+      }
+    }
+  }
 
-    // First client info
+  // Group the collisions per object, the reports of the last step of a pair end its run.
+  std::sort(m_newCollisions.begin(), m_newCollisions.end());
+
+  for (unsigned int i = 0, size = m_newCollisions.size(); i < size;) {
+    PHY_IPhysicsController *ctrl = m_newCollisions[i].ctrl;
     KX_ClientObjectInfo *client_info = static_cast<KX_ClientObjectInfo *>(
-        ctrl1->GetNewClientInfo());
-    // First gameobject
-    KX_GameObject *kxObj1 = KX_GameObject::GetClientObject(client_info);
-    // Invoke sensor response for each object
-    if (client_info) {
-      for (sit = client_info->m_sensors.begin(); sit != client_info->m_sensors.end(); ++sit) {
-        static_cast<SCA_CollisionSensor *>(*sit)->NewHandleCollision(ctrl1, ctrl2, nullptr);
+        ctrl->GetNewClientInfo());
+    KX_GameObject *gameobj = KX_GameObject::GetClientObject(client_info);
+
+    // Dispatch the batch of collisions of this object, once per collider.
+    while (i < size && m_newCollisions[i].ctrl == ctrl) {
+      PHY_IPhysicsController *colliderCtrl = m_newCollisions[i].collider;
+      unsigned int end = i;
+      while (end < size && m_newCollisions[end].ctrl == ctrl &&
+             m_newCollisions[end].collider == colliderCtrl) {
+        ++end;
+      }
+
+      /* Skip the reports of the same pair from the previous physics steps, the manifolds of
+       * the last step, at the end of the run, are merged in one contact point list. */
+      const unsigned int lastStep = m_newCollisions[end - 1].step;
+      unsigned int begin = end - 1;
+      while (begin > i && m_newCollisions[begin - 1].step == lastStep) {
+        --begin;
+      }
+      i = end;
+
+      // Invoke sensor response for the object
+      if (client_info) {
+        for (SCA_ISensor *sensor : client_info->m_sensors) {
+          static_cast<SCA_CollisionSensor *>(sensor)->NewHandleCollision(
+              ctrl, colliderCtrl, nullptr);
+        }
       }
-    }
 
-    // Second client info
-    client_info = static_cast<KX_ClientObjectInfo *>(ctrl2->GetNewClientInfo());
-    // Second gameobject
-    KX_GameObject *kxObj2 = KX_GameObject::GetClientObject(client_info);
-    if (client_info) {
-      for (sit = client_info->m_sensors.begin(); sit != client_info->m_sensors.end(); ++sit) {
-        static_cast<SCA_CollisionSensor *>(*sit)->NewHandleCollision(ctrl2, ctrl1, nullptr);
+      // Run python callbacks
+      KX_GameObject *collider = KX_GameObject::GetClientObject(
+          static_cast<KX_ClientObjectInfo *>(colliderCtrl->GetNewClientInfo()));
+      if (gameobj && collider) {
+        KX_CollisionContactPointList contactPointList(m_newCollisions[begin].colldata,
+                                                      m_newCollisions[begin].isFirst);
+        for (unsigned int j = begin + 1; j < end; ++j) {
+          contactPointList.AddCollData(m_newCollisions[j].colldata, m_newCollisions[j].isFirst);
+        }
+        gameobj->RunCollisionCallbacks(collider, contactPointList);
       }
     }
-    // Run python callbacks
-    const PHY_ICollData *colldata = collision.colldata;
-    KX_CollisionContactPointList contactPointList0 = KX_CollisionContactPointList(colldata, collision.isFirst);
-    KX_CollisionContactPointList contactPointList1 = KX_CollisionContactPointList(colldata, !collision.isFirst);
-    kxObj1->RunCollisionCallbacks(kxObj2, contactPointList0);
-    kxObj2->RunCollisionCallbacks(kxObj1, contactPointList1);
   }
 
   for (SCA_ISensor *sensor : m_sensors) {
@@ -220,6 +287,7 @@ void KX_CollisionEventManager::NextFrame()
   }
 
   RemoveNewCollisions();
+  m_physEnv->ClearCollisionData();
 }
 
 SCA_LogicManager *KX_CollisionEventManager::GetLogicManager()
@@ -232,30 +300,28 @@ PHY_IPhysicsEnvironment *KX_CollisionEventManager::GetPhysicsEnvironment()
   return m_physEnv;
 }
 
-KX_CollisionEventManager::NewCollision::NewCollision(PHY_IPhysicsController *_first,
-                                                     PHY_IPhysicsController *_second,
+KX_CollisionEventManager::NewCollision::NewCollision(PHY_IPhysicsController *_ctrl,
+                                                     PHY_IPhysicsController *_collider,
                                                      const PHY_ICollData *_colldata,
-                                                     bool _isfirst)
-    : first(_first), second(_second), colldata(_colldata), isFirst(_isfirst)
-{
-}
-
-KX_CollisionEventManager::NewCollision::NewCollision(const NewCollision &to_copy)
-    : first(to_copy.first), second(to_copy.second), colldata(to_copy.colldata), isFirst(to_copy.isFirst)
+                                                     bool _isfirst,
+                                                     unsigned int _step,
+                                                     unsigned int _index)
+    : ctrl(_ctrl),
+      collider(_collider),
+      colldata(_colldata),
+      isFirst(_isfirst),
+      step(_step),
+      index(_index)
 {
 }
 
 bool KX_CollisionEventManager::NewCollision::operator<(const NewCollision &other) const
 {
-  // see strict weak ordering: https://support.microsoft.com/en-us/kb/949171
-  if (first == other.first) {
-    if (second == other.second) {
-      if (colldata == other.colldata) {
-        return isFirst < other.isFirst;
-      }
-      return colldata < other.colldata;
+  if (ctrl == other.ctrl) {
+    if (collider == other.collider) {
+      return index < other.index;
     }
-    return second < other.second;
+    return collider < other.collider;
   }
-  return first < other.first;
+  return ctrl < other.ctrl;
 }
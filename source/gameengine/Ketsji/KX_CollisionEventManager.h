@@ -31,45 +31,61 @@
 
 #pragma once
 
-#include <set>
+#include <memory>
 #include <vector>
 
 #include "KX_GameObject.h"
+#include "KX_SensorSpatialHash.h"
 #include "SCA_CollisionSensor.h"
 #include "SCA_EventManager.h"
 
 class SCA_ISensor;
 class PHY_IPhysicsEnvironment;
+class KX_Scene;
 
 class KX_CollisionEventManager : public SCA_EventManager {
   /**
-   * Contains two colliding objects and the first contact point.
+   * A collision seen from one of the colliding objects, each collision reported by the physics
+   * is recorded once for both objects. The collision data is owned by the physics environment
+   * and valid until the end of the frame.
    */
   class NewCollision {
    public:
-    PHY_IPhysicsController *first;
-    PHY_IPhysicsController *second;
+    /// The controller of the object receiving the collision.
+    PHY_IPhysicsController *ctrl;
+    /// The controller of the other object.
+    PHY_IPhysicsController *collider;
     const PHY_ICollData *colldata;
     bool isFirst;
+    /// Physics step of the report, only the reports of the last step of a pair are kept.
+    unsigned int step;
+    /// Report order of the collision in the frame.
+    unsigned int index;
 
-    /**
-     * Creates a copy of the given PHY_ICollData; freeing that copy should be done by the owner of
-     * the NewCollision object.
-     *
-     * This allows us to efficiently store NewCollision objects in a std::set without creating more
-     * copies of colldata, as the NewCollision copy constructor reuses the pointer and doesn't
-     * clone it again. */
-    NewCollision(PHY_IPhysicsController *first,
-                 PHY_IPhysicsController *second,
+    NewCollision(PHY_IPhysicsController *ctrl,
+                 PHY_IPhysicsController *collider,
                  const PHY_ICollData *colldata,
-                 bool isFirst);
-    NewCollision(const NewCollision &to_copy);
+                 bool isFirst,
+                 unsigned int step,
+                 unsigned int index);
     bool operator<(const NewCollision &other) const;
   };
 
   PHY_IPhysicsEnvironment *m_physEnv;
+  KX_Scene *m_scene;
 
-  std::set<NewCollision> m_newCollisions;
+  /** Grid of the actor objects sensed by the Near and Radar sensors in one pass per frame,
+   * nullptr if these sensors use their ghost objects in the physics.
+   */
+  std::unique_ptr<KX_SensorSpatialHash> m_spatialHash;
+  /// Query result shared by the sensors.
+  std::vector<KX_SensorSpatialHash::Entry *> m_spatialHashEntries;
+
+  /** Collisions of the frame, sorted in NextFrame to batch them per object and remove the
+   * duplicated pairs reported by the physics steps of the frame. The capacity is kept
+   * between the frames.
+   */
+  std::vector<NewCollision> m_newCollisions;
 
   static bool newCollisionResponse(void *client_data,
                                    PHY_IPhysicsController *ctrl1,
@@ -90,8 +106,17 @@ class KX_CollisionEventManager : public SCA_EventManager {
 
   void RemoveNewCollisions();
 
+  /// Return true if the sensor is a Near or Radar sensor using the spatial hash.
+  bool UseSpatialHash(SCA_ISensor *sensor) const;
+
  public:
-  KX_CollisionEventManager(class SCA_LogicManager *logicmgr, PHY_IPhysicsEnvironment *physEnv);
+  /** \param useSpatialHash Sense the objects of the Near and Radar sensors from a grid
+   * updated each frame instead of the physics broadphase.
+   */
+  KX_CollisionEventManager(class SCA_LogicManager *logicmgr,
+                           PHY_IPhysicsEnvironment *physEnv,
+                           KX_Scene *scene,
+                           bool useSpatialHash);
   virtual ~KX_CollisionEventManager();
 
   virtual void NextFrame();
@@ -38,6 +38,9 @@
 
 #include "KX_GameObject.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "BKE_lib_id.h"
 #include "BKE_mball.h"
 #include "BKE_modifier.h"
@@ -49,6 +52,7 @@
 #include "BL_Action.h"
 #include "BL_ActionManager.h"
 #include "BL_SceneConverter.h"
+#include "CM_Profiler.h"
 #include "KX_ClientObjectInfo.h"
 #include "KX_CollisionContactPoints.h"
 #include "KX_Globals.h"
@@ -61,6 +65,7 @@
 #include "KX_PyMath.h"
 #include "KX_PythonComponent.h"
 #include "KX_RayCast.h"
+#include "SCA_IActuator.h"
 #include "SCA_ISensor.h"
 #include "SG_Controller.h"
 
@@ -86,6 +91,8 @@ KX_GameObject::KX_GameObject()
       m_visibleAtGameStart(false),   // eevee
       m_forceIgnoreParentTx(false),  // eevee
       m_previousLodLevel(-1),        // eevee
+      m_instancedRender(false),      // eevee
+      m_inactiveLayer(false),        // eevee
       m_layer(0),
       m_lodManager(nullptr),
       m_currentLodLevel(0),
@@ -95,10 +102,13 @@ KX_GameObject::KX_GameObject()
       m_objectColor(1.0f, 1.0f, 1.0f, 1.0f),
       m_bVisible(true),
       m_bOccluder(false),
+      m_replicated(false),
       m_pPhysicsController(nullptr),
       m_pSGNode(nullptr),
       m_pInstanceObjects(nullptr),
       m_pDupliGroupObject(nullptr),
+      m_poolOriginal(nullptr),
+      m_serial(0),
       m_actionManager(nullptr)
 #ifdef WITH_PYTHON
       ,
@@ -142,13 +152,14 @@ KX_GameObject::~KX_GameObject()
 
   Object *ob = GetBlenderObject();
 
-  if (ob) {
+  if (ob && !m_instancedRender) {
     if (ob->gameflag & OB_OVERLAY_COLLECTION) {
       ob->gameflag &= ~OB_OVERLAY_COLLECTION;
     }
   }
 
-  if (m_pSGNode) {
+  // The instanced blender object is owned by the scene.
+  if (m_pSGNode && !m_instancedRender) {
     KX_Scene *scene = GetScene();
 
     if (scene->m_isRuntime) {
@@ -248,10 +259,18 @@ void KX_GameObject::SyncTransformWithDepsgraph()
 void KX_GameObject::ForceIgnoreParentTx()
 {
   m_forceIgnoreParentTx = true;
+  if (!m_inactiveLayer) {
+    GetScene()->AddDirtyTransformObject(this);
+  }
 }
 
 void KX_GameObject::TagForTransformUpdate(bool is_overlay_pass, bool is_last_render_pass)
 {
+  // Instanced replicas are drawn from the scene instance buffers.
+  if (m_instancedRender) {
+    return;
+  }
+
   float object_to_world[4][4];
   NodeGetWorldTransform().getValue(&object_to_world[0][0]);
   bool staticObject = true;
@@ -336,6 +355,10 @@ void KX_GameObject::TagForTransformUpdate(bool is_overlay_pass, bool is_last_ren
 
 void KX_GameObject::TagForTransformUpdateEvaluated()
 {
+  if (m_instancedRender) {
+    return;
+  }
+
   float object_to_world[4][4];
   NodeGetWorldTransform().getValue(&object_to_world[0][0]);
 
@@ -616,6 +639,53 @@ void KX_GameObject::SetIsReplicaObject()
   m_isReplica = true;
 }
 
+bool KX_GameObject::IsInstancedRender() const
+{
+  return m_instancedRender;
+}
+
+bool KX_GameObject::IsInstancedRenderCandidate() const
+{
+  /* The instances are only drawn by the game render loop, the viewport render draws
+   * each blender object. */
+  if (KX_GetActiveEngine()->UseViewportRender()) {
+    return false;
+  }
+
+  Object *ob = m_pBlenderObject;
+  /* Deformed, LOD and overlay objects need their own blender object. */
+  return (ob && (ob->gameflag & OB_INSTANCED_RENDER) && ob->type == OB_MESH && !m_lodManager &&
+          !(ob->gameflag & OB_OVERLAY_COLLECTION) &&
+          !(ob->parent && ob->parent->type == OB_ARMATURE));
+}
+
+void KX_GameObject::SetInactiveLayer(bool inactive)
+{
+  m_inactiveLayer = inactive;
+}
+
+bool KX_GameObject::IsInactiveLayer() const
+{
+  return m_inactiveLayer;
+}
+
+bool KX_GameObject::NeedTransformSync()
+{
+  if (m_instancedRender) {
+    return false;
+  }
+
+  if (m_forceIgnoreParentTx || GetSGNode()->IsDirty(SG_Node::DIRTY_RENDER)) {
+    return true;
+  }
+
+  Object *ob_orig = GetBlenderObject();
+  /* The evaluated transform of these objects is set back from the depsgraph or
+   * can't be stored in the original object. */
+  return ob_orig && ((ob_orig->transflag & OB_TRANSFLAG_OVERRIDE_GAME_PRIORITY) ||
+                     !GetScene()->OrigObCanBeTransformedInRealtime(ob_orig));
+}
+
 float *KX_GameObject::GetPrevObjectMatToWorld()
 {
   return (float *)m_prevobject_to_world;
@@ -638,7 +708,40 @@ std::string KX_GameObject::GetName()
 /* Set the name of the value */
 void KX_GameObject::SetName(const std::string &name)
 {
+  if (name == m_name) {
+    return;
+  }
+
   m_name = name;
+
+#ifdef WITH_PYTHON
+  if (m_components) {
+    for (KX_PythonComponent *comp : m_components) {
+      comp->ResetProfileName();
+    }
+  }
+#endif  // WITH_PYTHON
+
+  // Update the entry of the object in the name index of the lists still containing it.
+  for (auto it = m_nameIndexReferences.begin(); it != m_nameIndexReferences.end();) {
+    EXP_BaseListValue *list = (*it)->m_list;
+    if (list && list->RenameValue(this)) {
+      ++it;
+    }
+    else {
+      it = m_nameIndexReferences.erase(it);
+    }
+  }
+}
+
+void KX_GameObject::AddNameIndexReference(
+    const std::shared_ptr<EXP_NameIndexReference> &reference)
+{
+  if (std::find(m_nameIndexReferences.begin(), m_nameIndexReferences.end(), reference) ==
+      m_nameIndexReferences.end())
+  {
+    m_nameIndexReferences.push_back(reference);
+  }
 }
 
 PHY_IPhysicsController *KX_GameObject::GetPhysicsController()
@@ -917,8 +1020,19 @@ void KX_GameObject::ProcessReplica()
 {
   KX_PythonProxy::ProcessReplica();
 
-  ReplicateBlenderObject();
-  GetScene()->GetBlenderSceneConverter()->RegisterGameObject(this, m_pBlenderObject);
+  // The replica is not in the lists of the original object.
+  m_nameIndexReferences.clear();
+
+  if (IsInstancedRenderCandidate()) {
+    /* Share the instanced blender object of the scene, the replica is drawn
+     * from the scene instance buffers. */
+    m_pBlenderObject = GetScene()->EnsureInstancedBlenderObject(m_pBlenderObject);
+    m_instancedRender = true;
+  }
+  else {
+    ReplicateBlenderObject();
+    GetScene()->GetBlenderSceneConverter()->RegisterGameObject(this, m_pBlenderObject);
+  }
 
   if (m_lodManager) {
     m_lodManager->AddRef();
@@ -932,6 +1046,9 @@ void KX_GameObject::ProcessReplica()
    * See KX_Scene::DupliGroupRecurse. */
   m_pDupliGroupObject = nullptr;
   m_pInstanceObjects = nullptr;
+  m_poolOriginal = nullptr;
+  m_serial = 0;
+  m_inactiveLayer = false;
   m_pClient_info = new KX_ClientObjectInfo(*m_pClient_info);
   m_pClient_info->m_gameobject = this;
   m_actionManager = nullptr;
@@ -997,6 +1114,13 @@ bool KX_GameObject::IsDynamicsSuspended() const
   return false;
 }
 
+bool KX_GameObject::IsSleeping() const
+{
+  if (m_pPhysicsController)
+    return m_pPhysicsController->IsSleeping();
+  return false;
+}
+
 float KX_GameObject::getLinearDamping() const
 {
   if (m_pPhysicsController)
@@ -1065,8 +1189,11 @@ void KX_GameObject::ApplyMovement(const MT_Vector3 &dloc, bool local)
 
 void KX_GameObject::ApplyRotation(const MT_Vector3 &drot, bool local)
 {
-  MT_Matrix3x3 rotmat(drot);
+  ApplyRotation(MT_Matrix3x3(drot), local);
+}
 
+void KX_GameObject::ApplyRotation(const MT_Matrix3x3 &rotmat, bool local)
+{
   GetSGNode()->RelativeRotate(rotmat, local);
 
   if (m_pPhysicsController) {  // (IsDynamic())
@@ -1185,8 +1312,8 @@ void KX_GameObject::UpdateLod(const MT_Vector3 &cam_pos, float lodfactor)
 
 void KX_GameObject::UpdateActivity(float distance)
 {
-  // Manage physics culling.
-  if (m_activityCullingInfo.m_flags & ActivityCullingInfo::ACTIVITY_PHYSICS) {
+  // Manage physics culling, a sleeping object costs nothing to the simulation.
+  if ((m_activityCullingInfo.m_flags & ActivityCullingInfo::ACTIVITY_PHYSICS) && !IsSleeping()) {
     if (distance > m_activityCullingInfo.m_physicsRadius) {
       SuspendPhysics(false, false);
     }
@@ -1208,6 +1335,11 @@ void KX_GameObject::UpdateActivity(float distance)
 
 void KX_GameObject::UpdateTransform()
 {
+  // The new transform is sent to the depsgraph at the next render pass.
+  if (!m_inactiveLayer) {
+    GetScene()->AddDirtyTransformObject(this);
+  }
+
   // HACK: saves function call for dynamic object, they are handled differently
   if (m_pPhysicsController && !m_pPhysicsController->IsDynamic())
     m_pPhysicsController->SetTransform();
@@ -1273,7 +1405,8 @@ static void setVisible_recursive(SG_Node *node, bool v)
 void KX_GameObject::SetVisible(bool v, bool recursive)
 {
   Object *ob = GetBlenderObject();
-  if (ob) {
+  // Instanced replicas are not drawn when invisible, the shared base stays hidden.
+  if (ob && !m_instancedRender) {
     Scene *scene = GetScene()->GetBlenderScene();
     ViewLayer *view_layer = BKE_view_layer_default_view(scene);
     Base *base = BKE_view_layer_base_find(view_layer, ob);
@@ -1300,6 +1433,11 @@ void KX_GameObject::SetVisible(bool v, bool recursive)
   }
 
   m_bVisible = v;
+
+  // The instance is added to or removed from the scene instance buffers at the next render.
+  if (m_instancedRender && !m_inactiveLayer) {
+    GetScene()->AddDirtyTransformObject(this);
+  }
 }
 
 static void setOccluder_recursive(SG_Node *node, bool v)
@@ -1394,12 +1532,15 @@ void KX_GameObject::SetObjectColor(const MT_Vector4 &rgbavec)
 {
   m_objectColor = rgbavec;
   Object *ob_orig = GetBlenderObject();
-  if (ob_orig && GetScene()->OrigObCanBeTransformedInRealtime(ob_orig) &&
+  if (ob_orig && !m_instancedRender && GetScene()->OrigObCanBeTransformedInRealtime(ob_orig) &&
       ELEM(ob_orig->type, OB_MESH, OB_CURVES_LEGACY, OB_SURF, OB_FONT, OB_MBALL)) {
     copy_v4_v4(ob_orig->color, m_objectColor.getValue());
     DEG_id_tag_update(&ob_orig->id, ID_RECALC_SHADING | ID_RECALC_TRANSFORM);
     WM_main_add_notifier(NC_OBJECT | ND_DRAW, &ob_orig->id);
   }
+  else if (m_instancedRender && !m_inactiveLayer) {
+    GetScene()->AddDirtyTransformObject(this);
+  }
 }
 
 const MT_Vector4 &KX_GameObject::GetObjectColor()
@@ -1808,6 +1949,105 @@ void KX_GameObject::RunOnRemoveCallbacks()
 #endif  // WITH PYTHON
 }
 
+void KX_GameObject::SetPoolOriginal(KX_GameObject *original)
+{
+  m_poolOriginal = original;
+}
+
+KX_GameObject *KX_GameObject::GetPoolOriginal() const
+{
+  return m_poolOriginal;
+}
+
+unsigned int KX_GameObject::GetSerial() const
+{
+  return m_serial;
+}
+
+void KX_GameObject::SetSerial(unsigned int serial)
+{
+  m_serial = serial;
+}
+
+void KX_GameObject::SuspendToPool()
+{
+#ifdef WITH_PYTHON
+  RunOnRemoveCallbacks();
+  Py_CLEAR(m_removeCallbacks);
+
+  if (m_collisionCallbacks) {
+    UnregisterCollisionCallbacks();
+    Py_CLEAR(m_collisionCallbacks);
+  }
+
+  if (m_attr_dict) {
+    PyDict_Clear(m_attr_dict);
+  }
+#endif  // WITH_PYTHON
+
+  /* The python reference can be kept in script lists, the next use of the replica
+   * will create a new proxy. */
+  InvalidateProxy();
+
+  // The actions of the previous use are stopped and freed.
+  if (m_actionManager) {
+    delete m_actionManager;
+    m_actionManager = nullptr;
+  }
+
+  // A parked replica is no longer a valid target for the logic of other objects.
+  for (SCA_IActuator *actuator : m_registeredActuators) {
+    actuator->UnlinkObject(this);
+  }
+  m_registeredActuators.clear();
+  for (SCA_IObject *object : m_registeredObjects) {
+    object->UnlinkObject(this);
+  }
+  m_registeredObjects.clear();
+
+  SuspendLogic();
+  SuspendPhysics(true, false);
+  SetVisible(false, false);
+}
+
+void KX_GameObject::RestoreFromPool(KX_GameObject *original)
+{
+  // Reset the game properties to the ones of the original object.
+  ClearProperties();
+  for (const std::string &name : original->GetPropertyNames()) {
+    EXP_Value *prop = original->GetProperty(name)->GetReplica();
+    SetProperty(name, prop);
+    prop->Release();
+  }
+
+#ifdef WITH_PYTHON
+  if (original->m_attr_dict) {
+    if (m_attr_dict) {
+      PyDict_Update(m_attr_dict, original->m_attr_dict);
+    }
+    else {
+      m_attr_dict = PyDict_Copy(original->m_attr_dict);
+    }
+  }
+#endif  // WITH_PYTHON
+
+  // As for a new replica the blender object is visible.
+  SetVisible(true, false);
+
+  RestorePhysics(false);
+  SynchronizeTransform();
+  if (m_pPhysicsController) {
+    m_pPhysicsController->SetLinearVelocity(MT_Vector3(0.0f, 0.0f, 0.0f), false);
+    m_pPhysicsController->SetAngularVelocity(MT_Vector3(0.0f, 0.0f, 0.0f), false);
+  }
+
+  ResumeLogic();
+  ResetState();
+  for (SCA_ISensor *sensor : m_sensors) {
+    sensor->Init();
+  }
+}
+
 /* Suspend/ resume: for the dynamic behavior, there is a simple
  * method. For the residual motion, there is not. I wonder what the
  * correct solution is for Sumo. Remove from the motion-update tree?
@@ -1896,6 +2136,7 @@ void KX_GameObject::Update()
   if (!m_logicSuspended) {
     if (m_components) {
       for (KX_PythonComponent *comp : m_components) {
+        CM_PROFILE_SCOPE_CACHED(comp->GetProfileName(), GetName() + " " + comp->GetName());
         comp->Update();
       }
     }
@@ -2218,6 +2459,7 @@ PyMethodDef KX_GameObject::Methods[] = {
 
     EXP_PYMETHODTABLE_KEYWORDS(KX_GameObject, rayCastTo),
     EXP_PYMETHODTABLE_KEYWORDS(KX_GameObject, rayCast),
+    EXP_PYMETHODTABLE_KEYWORDS(KX_GameObject, rayCastBatch),
     EXP_PYMETHODTABLE_O(KX_GameObject, getDistanceTo),
     EXP_PYMETHODTABLE_O(KX_GameObject, getVectTo),
     EXP_PYMETHODTABLE_KEYWORDS(KX_GameObject, sendMessage),
@@ -2262,6 +2504,7 @@ PyAttributeDef KX_GameObject::Attributes[] = {
     EXP_PYATTRIBUTE_RW_FUNCTION("layer", KX_GameObject, pyattr_get_layer, pyattr_set_layer),
     EXP_PYATTRIBUTE_RW_FUNCTION("visible", KX_GameObject, pyattr_get_visible, pyattr_set_visible),
     EXP_PYATTRIBUTE_BOOL_RW("occlusion", KX_GameObject, m_bOccluder),
+    EXP_PYATTRIBUTE_BOOL_RW("replicated", KX_GameObject, m_replicated),
 
     EXP_PYATTRIBUTE_RW_FUNCTION("physicsCullingRadius",
                                 KX_GameObject,
@@ -4871,6 +5114,200 @@ EXP_PYMETHODDEF_DOC(
     return none_tuple_3();
 }
 
+EXP_PYMETHODDEF_DOC(
+    KX_GameObject,
+    rayCastBatch,
+    "rayCastBatch(objto, objfrom, prop, face, xray, mask): cast a batch of rays and return the "
+    "hit objects, points and normals\n"
+    " objto = buffer of the ray end points, like a NumPy array of shape (n, 3)\n"
+    " objfrom = buffer of the ray start points, a single point or None for the object center\n"
+    " prop, face, xray = same as rayCast\n"
+    " mask = collision mask of all rays or buffer of the collision mask of each ray\n"
+    "Returns a tuple (objects, indices, points, normals), indices[i] is the index in objects of "
+    "the object hit by the ray i or -1, points and normals are float buffers of shape (n, 3).\n")
+{
+  PyObject *pyto;
+  PyObject *pyfrom = Py_None;
+  PyObject *pymask = nullptr;
+  const char *propName = "";
+  int face = 0, xray = 0;
+
+  static const char *kwlist[] = {"objto", "objfrom", "prop", "face", "xray", "mask", nullptr};
+  if (!PyArg_ParseTupleAndKeywords(args,
+                                   kwds,
+                                   "O|OsiiO:rayCastBatch",
+                                   const_cast<char **>(kwlist),
+                                   &pyto,
+                                   &pyfrom,
+                                   &propName,
+                                   &face,
+                                   &xray,
+                                   &pymask)) {
+    return nullptr;  // Python sets a simple error
+  }
+
+  std::vector<float> toValues;
+  if (!PyFloatBufferTo(pyto, toValues, "gameOb.rayCastBatch(objto, ...): KX_GameObject")) {
+    return nullptr;
+  }
+  if (toValues.size() % 3 != 0) {
+    PyErr_SetString(PyExc_ValueError,
+                    "gameOb.rayCastBatch(objto, ...): KX_GameObject, objto must contain 3D points");
+    return nullptr;
+  }
+
+  const unsigned int numRays = toValues.size() / 3;
+
+  std::vector<float> fromValues;
+  MT_Vector3 fromPoint;
+  if (pyfrom == Py_None) {
+    fromPoint = NodeGetWorldPosition();
+  }
+  else if (!PyVecTo(pyfrom, fromPoint)) {
+    PyErr_Clear();
+
+    if (!PyFloatBufferTo(pyfrom, fromValues, "gameOb.rayCastBatch(objto, objfrom, ...)")) {
+      return nullptr;
+    }
+    if (fromValues.size() != toValues.size()) {
+      PyErr_SetString(PyExc_ValueError,
+                      "gameOb.rayCastBatch(objto, objfrom, ...): KX_GameObject, objfrom must be "
+                      "None, a vector or contain as many points as objto");
+      return nullptr;
+    }
+  }
+
+  const int maxMask = (1 << OB_MAX_COL_MASKS) - 1;
+  int mask = maxMask;
+  std::vector<int> masks;
+  if (pymask && PyLong_Check(pymask)) {
+    mask = PyLong_AsLong(pymask);
+  }
+  else if (pymask) {
+    if (!PyIntBufferTo(pymask, masks, "gameOb.rayCastBatch(..., mask): KX_GameObject")) {
+      return nullptr;
+    }
+    if (masks.size() != numRays) {
+      PyErr_SetString(PyExc_ValueError,
+                      "gameOb.rayCastBatch(..., mask): KX_GameObject, mask must be an int or "
+                      "contain as many masks as rays");
+      return nullptr;
+    }
+  }
+
+  for (unsigned int i = 0, size = (masks.empty() ? 1 : numRays); i < size; ++i) {
+    const int rayMask = masks.empty() ? mask : masks[i];
+    if (rayMask == 0 || rayMask & ~maxMask) {
+      PyErr_Format(PyExc_TypeError,
+                   "gameOb.rayCastBatch(..., mask): KX_GameObject, mask argument to rayCastBatch "
+                   "must be int bitfields, 0 < mask < %i",
+                   (1 << OB_MAX_COL_MASKS));
+      return nullptr;
+    }
+  }
+
+  PHY_IPhysicsEnvironment *pe = GetScene()->GetPhysicsEnvironment();
+  PHY_IPhysicsController *spc = GetPhysicsController();
+  KX_GameObject *parent = GetParent();
+  if (!spc && parent)
+    spc = parent->GetPhysicsController();
+
+  /* Gather the rays with a length, each one has its own callback and data receiving the hit,
+   * the filters only read the game objects and can be run on the physics threads. */
+  std::vector<unsigned int> rayIndices;
+  std::vector<MT_Vector3> fromPoints;
+  std::vector<MT_Vector3> toPoints;
+  std::vector<RayCastData> rayDatas;
+  rayIndices.reserve(numRays);
+  fromPoints.reserve(numRays);
+  toPoints.reserve(numRays);
+  rayDatas.reserve(numRays);
+
+  for (unsigned int i = 0; i < numRays; ++i) {
+    const MT_Vector3 from = fromValues.empty() ? fromPoint : MT_Vector3(&fromValues[i * 3]);
+    const MT_Vector3 to(&toValues[i * 3]);
+    if (MT_fuzzyZero(to - from)) {
+      continue;
+    }
+
+    rayIndices.push_back(i);
+    fromPoints.push_back(from);
+    toPoints.push_back(to);
+    rayDatas.emplace_back(propName, xray, masks.empty() ? mask : masks[i]);
+  }
+
+  const unsigned int numTestedRays = rayIndices.size();
+  std::vector<KX_RayCast::Callback<KX_GameObject, RayCastData>> callbacks;
+  std::vector<PHY_IRayCastFilterCallback *> filterCallbacks(numTestedRays);
+  std::vector<PHY_IPhysicsController *> hitControllers(numTestedRays, nullptr);
+  callbacks.reserve(numTestedRays);
+  for (unsigned int i = 0; i < numTestedRays; ++i) {
+    callbacks.emplace_back(this, spc, &rayDatas[i], face, false);
+    filterCallbacks[i] = &callbacks[i];
+  }
+
+  if (pe && numTestedRays > 0) {
+    pe->RayTestBatch(filterCallbacks.data(),
+                     fromPoints.data(),
+                     toPoints.data(),
+                     hitControllers.data(),
+                     numTestedRays);
+  }
+
+  int *indices;
+  float *points;
+  float *normals;
+  PyObject *pyindices = PyBufferNew('i', numRays, 1, (void **)&indices);
+  PyObject *pypoints = PyBufferNew('f', numRays, 3, (void **)&points);
+  PyObject *pynormals = PyBufferNew('f', numRays, 3, (void **)&normals);
+  PyObject *pyobjects = PyList_New(0);
+  if (!pyindices || !pypoints || !pynormals || !pyobjects) {
+    Py_XDECREF(pyindices);
+    Py_XDECREF(pypoints);
+    Py_XDECREF(pynormals);
+    Py_XDECREF(pyobjects);
+    return nullptr;
+  }
+
+  std::fill(indices, indices + numRays, -1);
+
+  // Accept the hits as rayCast does and list each hit object once.
+  std::unordered_map<KX_GameObject *, int> objectIndices;
+  for (unsigned int i = 0; i < numTestedRays; ++i) {
+    PHY_IPhysicsController *hitController = hitControllers[i];
+    if (!hitController) {
+      continue;
+    }
+
+    KX_ClientObjectInfo *info = static_cast<KX_ClientObjectInfo *>(
+        hitController->GetNewClientInfo());
+    if (!info) {
+      continue;
+    }
+
+    KX_RayCast::Callback<KX_GameObject, RayCastData> &callback = callbacks[i];
+    callback.RayHit(info);
+    KX_GameObject *hitObject = rayDatas[i].m_hitObject;
+    if (!hitObject) {
+      continue;
+    }
+
+    const auto it = objectIndices.emplace(hitObject, objectIndices.size());
+    if (it.second) {
+      PyObject *pyobject = hitObject->GetProxy();
+      PyList_Append(pyobjects, pyobject);
+      Py_DECREF(pyobject);
+    }
+
+    const unsigned int ray = rayIndices[i];
+    indices[ray] = it.first->second;
+    callback.m_hitPoint.getValue(&points[ray * 3]);
+    callback.m_hitNormal.getValue(&normals[ray * 3]);
+  }
+
+  return Py_BuildValue("NNNN", pyobjects, pyindices, pypoints, pynormals);
+}
+
 EXP_PYMETHODDEF_DOC(KX_GameObject,
                     sendMessage,
                     "sendMessage(subject, [body, to])\n"
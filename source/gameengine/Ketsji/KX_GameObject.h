@@ -110,10 +110,16 @@ class KX_GameObject : public SCA_IObject {
   bool m_visibleAtGameStart;
   bool m_forceIgnoreParentTx;
   short m_previousLodLevel;
+  /// The replica shares the instanced blender object of the scene.
+  bool m_instancedRender;
+  /// The object is in an inactive layer and is never synchronized with the depsgraph.
+  bool m_inactiveLayer;
   /* END OF EEVEE INTEGRATION */
 
   KX_ClientObjectInfo *m_pClient_info;
   std::string m_name;
+  /// Name indexed lists containing the object, updated when it is renamed.
+  std::vector<std::shared_ptr<EXP_NameIndexReference>> m_nameIndexReferences;
   int m_layer;
   std::vector<RAS_MeshObject *> m_meshes;
   KX_LodManager *m_lodManager;
@@ -128,6 +134,8 @@ class KX_GameObject : public SCA_IObject {
   // culled = while rendering, depending on camera
   bool m_bVisible;
   bool m_bOccluder;
+  /// Transform and properties sent by a replication server or received by a client.
+  bool m_replicated;
 
   // Object activity culling settings converted from blender objects.
   ActivityCullingInfo m_activityCullingInfo;
@@ -138,6 +146,14 @@ class KX_GameObject : public SCA_IObject {
   EXP_ListValue<KX_GameObject> *m_pInstanceObjects;
   KX_GameObject *m_pDupliGroupObject;
 
+  /// Original object whose scene pool receives this replica when it is removed.
+  KX_GameObject *m_poolOriginal;
+
+  /** Number given by the scene to the replica each time it is added, unique in the scene.
+   * 0 for the converted objects and the removed replicas.
+   */
+  unsigned int m_serial;
+
   // The action manager is used to play/stop/update actions
   BL_ActionManager *m_actionManager;
 
@@ -168,6 +184,16 @@ class KX_GameObject : public SCA_IObject {
   void SetIsReplicaObject();
   float *GetPrevObjectMatToWorld();
   BL_ActionManager *GetActionManagerNoCreate();
+  bool IsInstancedRender() const;
+  /// Return true if the replicas of this object can be drawn as instances.
+  bool IsInstancedRenderCandidate() const;
+  void SetInactiveLayer(bool inactive);
+  bool IsInactiveLayer() const;
+  /** Return true if the object transform must still be sent to the depsgraph in the next
+   * render pass: it was not sent in all render passes, its children must be compensated or
+   * the depsgraph overrides it every frame.
+   */
+  bool NeedTransformSync();
   /* END OF EEVEE INTEGRATION */
 
   /**
@@ -369,6 +395,8 @@ class KX_GameObject : public SCA_IObject {
    */
   virtual void SetName(const std::string &name);
 
+  virtual void AddNameIndexReference(const std::shared_ptr<EXP_NameIndexReference> &reference);
+
   /**
    * Inherited from KX_PythonProxy -- return a new copy of this
    * instance allocated on the heap. Ownership of the new
@@ -546,6 +574,9 @@ class KX_GameObject : public SCA_IObject {
 
   bool IsDynamicsSuspended() const;
 
+  /// Is the physics object put to sleep by the simulation ?
+  bool IsSleeping() const;
+
   /**
    * Check if this object has a vertex parent relationship
    */
@@ -574,6 +605,7 @@ class KX_GameObject : public SCA_IObject {
   void ApplyTorque(const MT_Vector3 &torque, bool local);
 
   void ApplyRotation(const MT_Vector3 &drot, bool local);
+  void ApplyRotation(const MT_Matrix3x3 &rotmat, bool local);
 
   void ApplyMovement(const MT_Vector3 &dloc, bool local);
 
@@ -707,6 +739,14 @@ class KX_GameObject : public SCA_IObject {
    */
   void SetOccluder(bool v, bool recursive);
 
+  /**
+   * Is this object replicated over the network?
+   */
+  inline bool IsReplicated() const
+  {
+    return m_replicated;
+  }
+
   /**
    * Change the layer of the object (when it is added in another layer
    * than the original layer)
@@ -743,6 +783,25 @@ class KX_GameObject : public SCA_IObject {
   /* Run the registered python callbacks when the KX_GameObject is removed. */
   void RunOnRemoveCallbacks();
 
+  /**
+   * \section Object pooling methods.
+   */
+
+  void SetPoolOriginal(KX_GameObject *original);
+  KX_GameObject *GetPoolOriginal() const;
+  /// Return the number identifying the replica in its scene, see KX_Scene::AddReplicaObject.
+  unsigned int GetSerial() const;
+  void SetSerial(unsigned int serial);
+  /** Disable a replica which is kept in a scene object pool instead of being freed:
+   * run the remove callbacks, drop the per-instance python data and actions, unlink the
+   * logic bricks of other objects using it and suspend its logic, physics and visibility.
+   */
+  void SuspendToPool();
+  /** Enable back a replica taken from a scene object pool, its properties, python
+   * attributes, logic state and visibility are reset from the original object.
+   */
+  void RestoreFromPool(KX_GameObject *original);
+
   /**
    * Stop making progress
    */
@@ -829,6 +888,7 @@ class KX_GameObject : public SCA_IObject {
   EXP_PYMETHOD_NOARGS(KX_GameObject, EndObject);
   EXP_PYMETHOD_DOC(KX_GameObject, rayCastTo);
   EXP_PYMETHOD_DOC(KX_GameObject, rayCast);
+  EXP_PYMETHOD_DOC(KX_GameObject, rayCastBatch);
   EXP_PYMETHOD_DOC_O(KX_GameObject, getDistanceTo);
   EXP_PYMETHOD_DOC_O(KX_GameObject, getVectTo);
   EXP_PYMETHOD_DOC(KX_GameObject, sendMessage);
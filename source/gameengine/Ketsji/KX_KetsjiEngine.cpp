@@ -38,11 +38,13 @@
 
 #include <boost/format.hpp>
 
+#include "BLI_task.h"
 #include "DRW_render.h"
 #include "GPU_matrix.h"
 
 #include "BL_Converter.h"
 #include "BL_SceneConverter.h"
+#include "CM_Profiler.h"
 #include "DEV_Joystick.h"  // for DEV_Joystick::HandleEvents
 #include "KX_Camera.h"
 #include "KX_Globals.h"
@@ -161,6 +163,8 @@ KX_KetsjiEngine::KX_KetsjiEngine(KX_ISystem *system,
 
   m_scenes = new EXP_ListValue<KX_Scene>();
   m_renderingCameras = {};
+
+  m_physicsPool = BLI_task_pool_create(nullptr, TASK_PRIORITY_HIGH);
 }
 
 /**
@@ -173,6 +177,8 @@ KX_KetsjiEngine::~KX_KetsjiEngine()
 #endif
 
   m_scenes->Release();
+
+  BLI_task_pool_free(m_physicsPool);
 }
 
 /* EEVEE integration */
@@ -302,6 +308,9 @@ void KX_KetsjiEngine::EndFrame()
   // Go to next profiling measurement, time spent after this call is shown in the next frame.
   m_logger.NextMeasurement();
 
+  // Write the scopes of the frame to the trace file.
+  CM_Profiler::Flush();
+
   m_logger.StartLog(tc_rasterizer);
   m_rasterizer->EndFrame();
 
@@ -347,6 +356,9 @@ void KX_KetsjiEngine::EndFrameViewportRender()
   // Go to next profiling measurement, time spent after this call is shown in the next frame.
   m_logger.NextMeasurement();
 
+  // Write the scopes of the frame to the trace file.
+  CM_Profiler::Flush();
+
   m_logger.StartLog(tc_rasterizer);
   // m_rasterizer->EndFrame();
 
@@ -445,8 +457,35 @@ KX_KetsjiEngine::FrameTimes KX_KetsjiEngine::GetFrameTimes()
   return times;
 }
 
+static void proceed_physics_thread_func(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  KX_KetsjiEngine::PhysicsTaskData *task = (KX_KetsjiEngine::PhysicsTaskData *)taskdata;
+
+  CM_PROFILE_SCOPE("Physics");
+
+  task->scene->GetPhysicsEnvironment()->ProceedDeltaTime(
+      task->curtime, task->timestep, task->framestep);
+}
+
+bool KX_KetsjiEngine::HasSameGlobalPhysicsSettings() const
+{
+  if (m_scenes->GetCount() == 0) {
+    return true;
+  }
+
+  PHY_IPhysicsEnvironment *physEnv = m_scenes->GetFront()->GetPhysicsEnvironment();
+  for (KX_Scene *scene : m_scenes) {
+    if (!physEnv->HasSameGlobalSettings(scene->GetPhysicsEnvironment())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool KX_KetsjiEngine::NextFrame()
 {
+  CM_PROFILE_SCOPE("NextFrame");
+
   m_logger.StartLog(tc_services);
 
   const FrameTimes times = GetFrameTimes();
@@ -484,8 +523,21 @@ bool KX_KetsjiEngine::NextFrame()
     }
 #endif  // WITH_SDL
 
+    // The tasks are pushed while iterating, their data must not be moved.
+    m_physicsTasks.reserve(m_scenes->GetCount());
+
+    /* The physics settings of Bullet are process globals read during the step. The independent
+     * scenes are stepped on worker threads only if all the scenes use the same settings, they
+     * are then set once here before any task is pushed. */
+    const bool concurrentPhysics = HasSameGlobalPhysicsSettings();
+    if (concurrentPhysics && m_scenes->GetCount() > 0) {
+      m_scenes->GetFront()->GetPhysicsEnvironment()->ApplyGlobalSettings();
+    }
+
     // for each scene, call the proceed functions
     for (KX_Scene *scene : m_scenes) {
+      CM_PROFILE_SCOPE_NAME(scene->GetName());
+
       /* Suspension holds the physics and logic processing for an
        * entire scene. Objects can be suspended individually, and
        * the settings for that precede the logic and physics
@@ -503,7 +555,10 @@ bool KX_KetsjiEngine::NextFrame()
 
       // Process sensors, and controllers
       m_logger.StartLog(tc_logic);
-      scene->LogicBeginFrame(m_frameTime, times.framestep);
+      {
+        CM_PROFILE_SCOPE("Logic");
+        scene->LogicBeginFrame(m_frameTime, times.framestep);
+      }
 
       // Scenegraph needs to be updated again, because Logic Controllers
       // can affect the local matrices.
@@ -514,9 +569,12 @@ bool KX_KetsjiEngine::NextFrame()
 
       // Do some cleanup work for this logic frame
       m_logger.StartLog(tc_logic);
-      scene->LogicUpdateFrame(m_frameTime);
+      {
+        CM_PROFILE_SCOPE("Actuators");
+        scene->LogicUpdateFrame(m_frameTime, times.framestep);
 
-      scene->LogicEndFrame();
+        scene->LogicEndFrame();
+      }
 
       // Actuators can affect the scenegraph
       m_logger.StartLog(tc_scenegraph);
@@ -524,14 +582,32 @@ bool KX_KetsjiEngine::NextFrame()
 
       m_logger.StartLog(tc_physics);
 
-      // Perform physics calculations on the scene. This can involve
-      // many iterations of the physics solver.
-      scene->GetPhysicsEnvironment()->ProceedDeltaTime(
-          m_frameTime, times.timestep, times.framestep);  // m_deltatimerealDeltaTime);
+      /* The physics of an independent scene is stepped on a worker thread while
+       * the logic of the next scenes runs, the scene graph is updated after the join. */
+      if (scene->GetIndependentPhysics() && concurrentPhysics) {
+        m_physicsTasks.push_back({scene, m_frameTime, times.timestep, times.framestep});
+        BLI_task_pool_push(
+            m_physicsPool, proceed_physics_thread_func, &m_physicsTasks.back(), false, nullptr);
+        m_logger.StartLog(tc_services);
+        continue;
+      }
 
-      /* No need to call sofbody update more than 1 time */
-      if (i == times.frames - 1) {
-        scene->GetPhysicsEnvironment()->UpdateSoftBodies();
+      {
+        CM_PROFILE_SCOPE("Physics");
+
+        if (!concurrentPhysics) {
+          scene->GetPhysicsEnvironment()->ApplyGlobalSettings();
+        }
+
+        // Perform physics calculations on the scene. This can involve
+        // many iterations of the physics solver.
+        scene->GetPhysicsEnvironment()->ProceedDeltaTime(
+            m_frameTime, times.timestep, times.framestep);  // m_deltatimerealDeltaTime);
+
+        /* No need to call sofbody update more than 1 time */
+        if (i == times.frames - 1) {
+          scene->GetPhysicsEnvironment()->UpdateSoftBodies();
+        }
       }
 
       m_logger.StartLog(tc_scenegraph);
@@ -540,6 +616,27 @@ bool KX_KetsjiEngine::NextFrame()
       m_logger.StartLog(tc_services);
     }
 
+    if (!m_physicsTasks.empty()) {
+      m_logger.StartLog(tc_physics);
+      {
+        CM_PROFILE_SCOPE("Wait Physics");
+        BLI_task_pool_work_and_wait(m_physicsPool);
+      }
+
+      for (const PhysicsTaskData &task : m_physicsTasks) {
+        if (i == times.frames - 1) {
+          task.scene->GetPhysicsEnvironment()->UpdateSoftBodies();
+        }
+
+        m_logger.StartLog(tc_scenegraph);
+        task.scene->UpdateParents(m_frameTime);
+        m_logger.StartLog(tc_physics);
+      }
+      m_physicsTasks.clear();
+
+      m_logger.StartLog(tc_services);
+    }
+
     m_logger.StartLog(tc_network);
     m_networkMessageManager->ClearMessages();
 
@@ -551,6 +648,13 @@ bool KX_KetsjiEngine::NextFrame()
     ProcessScheduledScenes();
   }
 
+  // Send or receive the replicated objects once the logic and the physics are done.
+  m_logger.StartLog(tc_network);
+  {
+    CM_PROFILE_SCOPE("Replication");
+    m_networkMessageManager->GetReplication().Update(m_scenes, m_frameTime);
+  }
+
   // Start logging time spent outside main loop
   m_logger.StartLog(tc_outside);
 
@@ -740,6 +844,8 @@ bool KX_KetsjiEngine::GetFrameRenderData(std::vector<FrameRenderData> &frameData
 
 void KX_KetsjiEngine::Render()
 {
+  CM_PROFILE_SCOPE("Render");
+
   m_logger.StartLog(tc_rasterizer);
 
   BeginFrame();
@@ -904,6 +1010,8 @@ void KX_KetsjiEngine::GetSceneViewport(KX_Scene *scene,
 
 void KX_KetsjiEngine::UpdateAnimations(KX_Scene *scene)
 {
+  CM_PROFILE_SCOPE("Animations");
+
   // Handle the animations independently of the logic time step
   if (m_flags & RESTRICT_ANIMATION) {
     double anim_timestep = 1.0 / scene->GetAnimationFPS();
@@ -1009,6 +1117,9 @@ void KX_KetsjiEngine::RenderCamera(KX_Scene *scene,
                                    unsigned short pass)
 {
   KX_Camera *rendercam = cameraFrameData.m_renderCamera;
+
+  CM_PROFILE_SCOPE_NAME(scene->GetName() + " " + rendercam->GetName());
+
   // KX_Camera *cullingcam = cameraFrameData.m_cullingCamera;
   // const RAS_Rect &area = cameraFrameData.m_area;
   const RAS_Rect &viewport = cameraFrameData.m_viewport;
@@ -1155,6 +1266,7 @@ void KX_KetsjiEngine::PostProcessScene(KX_Scene *scene)
     scene->GetCameraList()->Add(CM_AddRef(activecam));
     scene->SetActiveCamera(activecam);
     scene->GetObjectList()->Add(CM_AddRef(activecam));
+    scene->AddDirtyTransformObject(activecam);
     scene->GetRootParentList()->Add(CM_AddRef(activecam));
     // done with activecam
     activecam->Release();
@@ -1230,6 +1342,45 @@ void KX_KetsjiEngine::RenderDebugProperties()
           MT_Vector2(xcoord + (int)(2.2 * profile_indent), ycoord), boxSize, white);
       ycoord += const_ysize;
     }
+
+    // Number of objects sent to the depsgraph in the last render pass.
+    unsigned int syncedObjects = 0;
+    for (KX_Scene *scene : m_scenes) {
+      syncedObjects += scene->GetTransformSyncCount();
+    }
+    debugDraw.RenderText2D("Synced:", MT_Vector2(xcoord + const_xindent, ycoord), white);
+    debugtxt = (boost::format("%d objects") % syncedObjects).str();
+    debugDraw.RenderText2D(
+        debugtxt, MT_Vector2(xcoord + const_xindent + profile_indent, ycoord), white);
+    ycoord += const_ysize;
+
+    // Number of Fh spring rays tested in the last physics step.
+    unsigned int fhRays = 0;
+    for (KX_Scene *scene : m_scenes) {
+      PHY_IPhysicsEnvironment *physEnv = scene->GetPhysicsEnvironment();
+      if (physEnv) {
+        fhRays += physEnv->GetNumFhRays();
+      }
+    }
+    debugDraw.RenderText2D("Fh Rays:", MT_Vector2(xcoord + const_xindent, ycoord), white);
+    debugtxt = (boost::format("%d per step") % fhRays).str();
+    debugDraw.RenderText2D(
+        debugtxt, MT_Vector2(xcoord + const_xindent + profile_indent, ycoord), white);
+    ycoord += const_ysize;
+
+    // Number of bodies sleeping, skipped by the transform synchronization.
+    unsigned int sleepingObjects = 0;
+    for (KX_Scene *scene : m_scenes) {
+      PHY_IPhysicsEnvironment *physEnv = scene->GetPhysicsEnvironment();
+      if (physEnv) {
+        sleepingObjects += physEnv->GetNumSleepingControllers();
+      }
+    }
+    debugDraw.RenderText2D("Sleeping:", MT_Vector2(xcoord + const_xindent, ycoord), white);
+    debugtxt = (boost::format("%d objects") % sleepingObjects).str();
+    debugDraw.RenderText2D(
+        debugtxt, MT_Vector2(xcoord + const_xindent + profile_indent, ycoord), white);
+    ycoord += const_ysize;
   }
   // Add the ymargin for titles below the other section of debug info
   ycoord += title_y_top_margin;
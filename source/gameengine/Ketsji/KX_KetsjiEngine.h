@@ -50,6 +50,7 @@ class KX_NetworkMessageManager;
 class RAS_ICanvas;
 class RAS_FrameBuffer;
 class SCA_IInputDevice;
+struct TaskPool;
 
 enum class KX_ExitRequest {
   NO_REQUEST = 0,
@@ -93,6 +94,14 @@ class KX_KetsjiEngine {
     CAMERA_OVERRIDE = (1 << 7)
   };
 
+  /// Data of a physics task, the physics of an independent scene stepped on a worker thread.
+  struct PhysicsTaskData {
+    KX_Scene *scene;
+    double curtime;
+    double timestep;
+    double framestep;
+  };
+
  private:
   struct CameraRenderData {
     CameraRenderData(KX_Camera *rendercam,
@@ -154,6 +163,10 @@ class KX_KetsjiEngine {
     double framestep;
   };
 
+  /// Pool stepping the physics of the independent scenes concurrently.
+  TaskPool *m_physicsPool;
+  std::vector<PhysicsTaskData> m_physicsTasks;
+
   CM_Clock m_clock;
 
   /// Lists of scenes scheduled to be removed at the end of the frame.
@@ -284,6 +297,8 @@ class KX_KetsjiEngine {
 
   void BeginFrame();
   FrameTimes GetFrameTimes();
+  /// Return true if all the scenes share the process wide physics settings.
+  bool HasSameGlobalPhysicsSettings() const;
 
  public:
   KX_KetsjiEngine(KX_ISystem *system,
@@ -0,0 +1,461 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KX_NativeComponentManager.cpp
+ *  \ingroup ketsji
+ */
+
+#include "KX_NativeComponentManager.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+#include "DNA_python_proxy_types.h"
+
+#include "CM_Message.h"
+#include "CM_Profiler.h"
+#include "KX_GameObject.h"
+#include "KX_Scene.h"
+
+/// Module of the python classes declaring the native components for the editor.
+static const char *native_component_module = "bge_extras.components";
+
+/// Below this number of components a system is updated without threads.
+static const int native_component_min_iter_per_thread = 1024;
+
+static const PythonProxyProperty *find_property(const PythonProxy *pp,
+                                                const char *name,
+                                                short type)
+{
+  for (const PythonProxyProperty *prop = (const PythonProxyProperty *)pp->properties.first; prop;
+       prop = prop->next)
+  {
+    if (prop->type == type && STREQ(prop->name, name)) {
+      return prop;
+    }
+  }
+  return nullptr;
+}
+
+static float get_float_property(const PythonProxy *pp, const char *name, float defaultvalue)
+{
+  const PythonProxyProperty *prop = find_property(pp, name, PPROP_TYPE_FLOAT);
+  return prop ? prop->floatval : defaultvalue;
+}
+
+static bool get_bool_property(const PythonProxy *pp, const char *name, bool defaultvalue)
+{
+  const PythonProxyProperty *prop = find_property(pp, name, PPROP_TYPE_BOOLEAN);
+  return prop ? (prop->boolval != 0) : defaultvalue;
+}
+
+static MT_Vector3 get_vec3_property(const PythonProxy *pp,
+                                    const char *name,
+                                    const MT_Vector3 &defaultvalue)
+{
+  const PythonProxyProperty *prop = find_property(pp, name, PPROP_TYPE_VEC3);
+  return prop ? MT_Vector3(prop->vec) : defaultvalue;
+}
+
+static Object *get_object_property(const PythonProxy *pp, const char *name)
+{
+  const PythonProxyProperty *prop = find_property(pp, name, PPROP_TYPE_OBJECT);
+  return prop ? prop->object : nullptr;
+}
+
+static void init_parallel_settings(TaskParallelSettings *settings, int size)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->min_iter_per_thread = native_component_min_iter_per_thread;
+  settings->use_threading = (size > settings->min_iter_per_thread);
+}
+
+KX_NativeComponentSystem::KX_NativeComponentSystem() : m_profileName(nullptr)
+{
+}
+
+KX_NativeComponentSystem::~KX_NativeComponentSystem()
+{
+}
+
+const char *&KX_NativeComponentSystem::GetProfileName()
+{
+  return m_profileName;
+}
+
+void KX_NativeComponentSystem::Start(KX_GameObject *gameobj, const PythonProxy *pp)
+{
+  if (!m_indices.emplace(gameobj, m_objects.size()).second) {
+    CM_Warning("object \"" << gameobj->GetName() << "\" has more than one " << GetName()
+                           << " component, only the first is used.");
+    return;
+  }
+
+  m_objects.push_back(gameobj);
+  StartData(pp);
+}
+
+void KX_NativeComponentSystem::Dispose(KX_GameObject *gameobj)
+{
+  std::unordered_map<KX_GameObject *, unsigned int>::iterator it = m_indices.find(gameobj);
+  if (it == m_indices.end()) {
+    return;
+  }
+
+  // The last component fills the hole to keep the arrays contiguous.
+  const unsigned int index = it->second;
+  const unsigned int last = m_objects.size() - 1;
+  m_indices.erase(it);
+  if (index != last) {
+    KX_GameObject *lastobj = m_objects[last];
+    m_objects[index] = lastobj;
+    m_indices[lastobj] = index;
+    MoveData(last, index);
+  }
+  m_objects.pop_back();
+  PopData();
+}
+
+void KX_NativeComponentSystem::UnlinkObject(KX_GameObject *UNUSED(gameobj))
+{
+}
+
+/** Rotate the object at a constant angular speed.
+ * Arguments: "Speed" (Vector 3D, euler angles per second), "Local" (Boolean).
+ */
+class KX_RotatorSystem : public KX_NativeComponentSystem {
+ private:
+  std::vector<MT_Vector3> m_speeds;
+  std::vector<char> m_locals;
+  /// Rotation of the frame, computed for all the components before being applied.
+  std::vector<MT_Matrix3x3> m_rotations;
+
+  struct UpdateData {
+    const MT_Vector3 *speeds;
+    MT_Matrix3x3 *rotations;
+    float deltatime;
+  };
+
+  static void UpdateFunc(void *__restrict userdata,
+                         const int iter,
+                         const TaskParallelTLS *__restrict UNUSED(tls))
+  {
+    UpdateData *data = (UpdateData *)userdata;
+    data->rotations[iter].setEuler(data->speeds[iter] * data->deltatime);
+  }
+
+ protected:
+  virtual void StartData(const PythonProxy *pp)
+  {
+    m_speeds.push_back(get_vec3_property(pp, "Speed", MT_Vector3(0.0f, 0.0f, 1.0f)));
+    m_locals.push_back(get_bool_property(pp, "Local", true));
+  }
+
+  virtual void MoveData(unsigned int from, unsigned int to)
+  {
+    m_speeds[to] = m_speeds[from];
+    m_locals[to] = m_locals[from];
+  }
+
+  virtual void PopData()
+  {
+    m_speeds.pop_back();
+    m_locals.pop_back();
+  }
+
+ public:
+  virtual std::string GetName() const
+  {
+    return "Rotator";
+  }
+
+  virtual void Update(KX_Scene *UNUSED(scene), float deltatime)
+  {
+    const int size = m_objects.size();
+    m_rotations.resize(size);
+
+    UpdateData data = {m_speeds.data(), m_rotations.data(), deltatime};
+    TaskParallelSettings settings;
+    init_parallel_settings(&settings, size);
+    BLI_task_parallel_range(0, size, &data, UpdateFunc, &settings);
+
+    // The scene graph and the physics are not thread safe.
+    for (int i = 0; i < size; ++i) {
+      KX_GameObject *gameobj = m_objects[i];
+      if (!gameobj->IsLogicSuspended()) {
+        gameobj->ApplyRotation(m_rotations[i], m_locals[i]);
+      }
+    }
+  }
+};
+
+/** Move the object smoothly to the position of a target object.
+ * Arguments: "Target" (Object), "Speed" (Float, the higher the faster, zero to stick to the
+ * target), "Offset" (Vector 3D, in world space).
+ */
+class KX_FollowerSystem : public KX_NativeComponentSystem {
+ private:
+  /// Blender object of the target, cleared once the target is removed.
+  std::vector<Object *> m_targetObjects;
+  /// Game object of the target, found again at each update while it is not converted.
+  std::vector<KX_GameObject *> m_targets;
+  std::vector<float> m_speeds;
+  std::vector<MT_Vector3> m_offsets;
+  /// Position of the frame, computed for all the components before being applied.
+  std::vector<MT_Vector3> m_positions;
+
+  struct UpdateData {
+    KX_GameObject *const *objects;
+    KX_GameObject *const *targets;
+    const float *speeds;
+    const MT_Vector3 *offsets;
+    MT_Vector3 *positions;
+    float deltatime;
+  };
+
+  static void UpdateFunc(void *__restrict userdata,
+                         const int iter,
+                         const TaskParallelTLS *__restrict UNUSED(tls))
+  {
+    UpdateData *data = (UpdateData *)userdata;
+    const MT_Vector3 &position = data->objects[iter]->NodeGetWorldPosition();
+    KX_GameObject *target = data->targets[iter];
+    if (!target) {
+      data->positions[iter] = position;
+      return;
+    }
+
+    const MT_Vector3 goal = target->NodeGetWorldPosition() + data->offsets[iter];
+    const float speed = data->speeds[iter];
+    // Exponential smoothing independent of the frame rate.
+    const float factor = (speed > 0.0f) ? 1.0f - expf(-speed * data->deltatime) : 1.0f;
+    data->positions[iter] = position + (goal - position) * factor;
+  }
+
+ protected:
+  virtual void StartData(const PythonProxy *pp)
+  {
+    m_targetObjects.push_back(get_object_property(pp, "Target"));
+    m_targets.push_back(nullptr);
+    m_speeds.push_back(get_float_property(pp, "Speed", 5.0f));
+    m_offsets.push_back(get_vec3_property(pp, "Offset", MT_Vector3(0.0f, 0.0f, 0.0f)));
+  }
+
+  virtual void MoveData(unsigned int from, unsigned int to)
+  {
+    m_targetObjects[to] = m_targetObjects[from];
+    m_targets[to] = m_targets[from];
+    m_speeds[to] = m_speeds[from];
+    m_offsets[to] = m_offsets[from];
+  }
+
+  virtual void PopData()
+  {
+    m_targetObjects.pop_back();
+    m_targets.pop_back();
+    m_speeds.pop_back();
+    m_offsets.pop_back();
+  }
+
+ public:
+  virtual std::string GetName() const
+  {
+    return "Follower";
+  }
+
+  virtual void UnlinkObject(KX_GameObject *gameobj)
+  {
+    // A removed target is never found again, the component stops following.
+    for (unsigned int i = 0, size = m_targets.size(); i < size; ++i) {
+      if (m_targets[i] == gameobj) {
+        m_targets[i] = nullptr;
+        m_targetObjects[i] = nullptr;
+      }
+    }
+  }
+
+  virtual void Update(KX_Scene *scene, float deltatime)
+  {
+    const int size = m_objects.size();
+    for (int i = 0; i < size; ++i) {
+      if (!m_targets[i] && m_targetObjects[i]) {
+        KX_GameObject *target = scene->GetGameObjectFromObject(m_targetObjects[i]);
+        // The object of an inactive layer is only the template of the added objects.
+        if (target && !target->IsInactiveLayer()) {
+          m_targets[i] = target;
+        }
+      }
+    }
+
+    m_positions.resize(size);
+
+    UpdateData data = {m_objects.data(),
+                       m_targets.data(),
+                       m_speeds.data(),
+                       m_offsets.data(),
+                       m_positions.data(),
+                       deltatime};
+    TaskParallelSettings settings;
+    init_parallel_settings(&settings, size);
+    BLI_task_parallel_range(0, size, &data, UpdateFunc, &settings);
+
+    for (int i = 0; i < size; ++i) {
+      KX_GameObject *gameobj = m_objects[i];
+      if (m_targets[i] && !gameobj->IsLogicSuspended()) {
+        gameobj->NodeSetWorldPosition(m_positions[i]);
+        gameobj->NodeUpdateGS(0.0f);
+      }
+    }
+  }
+};
+
+/** Remove the object after a delay.
+ * Arguments: "Time" (Float, in seconds).
+ */
+class KX_LifetimeSystem : public KX_NativeComponentSystem {
+ private:
+  /// Remaining time of each component, FLT_MAX once the object removal is requested.
+  std::vector<float> m_times;
+
+ protected:
+  virtual void StartData(const PythonProxy *pp)
+  {
+    m_times.push_back(get_float_property(pp, "Time", 1.0f));
+  }
+
+  virtual void MoveData(unsigned int from, unsigned int to)
+  {
+    m_times[to] = m_times[from];
+  }
+
+  virtual void PopData()
+  {
+    m_times.pop_back();
+  }
+
+ public:
+  virtual std::string GetName() const
+  {
+    return "Lifetime";
+  }
+
+  virtual void Update(KX_Scene *scene, float deltatime)
+  {
+    for (unsigned int i = 0, size = m_objects.size(); i < size; ++i) {
+      KX_GameObject *gameobj = m_objects[i];
+      if (gameobj->IsLogicSuspended()) {
+        continue;
+      }
+
+      m_times[i] -= deltatime;
+      // The object is removed at the end of the frame, the arrays are not modified here.
+      if (m_times[i] <= 0.0f) {
+        scene->DelayedRemoveObject(gameobj);
+        m_times[i] = FLT_MAX;
+      }
+    }
+  }
+};
+
+KX_NativeComponentManager::KX_NativeComponentManager()
+{
+  m_systems.emplace_back(new KX_RotatorSystem());
+  m_systems.emplace_back(new KX_FollowerSystem());
+  m_systems.emplace_back(new KX_LifetimeSystem());
+}
+
+KX_NativeComponentManager::KX_NativeComponentManager(
+    const KX_NativeComponentManager &UNUSED(other))
+    : KX_NativeComponentManager()
+{
+}
+
+KX_NativeComponentManager::~KX_NativeComponentManager()
+{
+}
+
+bool KX_NativeComponentManager::Convert(KX_GameObject *gameobj, const PythonProxy *pp)
+{
+  if (!STREQ(pp->module, native_component_module)) {
+    return false;
+  }
+
+  for (std::unique_ptr<KX_NativeComponentSystem> &system : m_systems) {
+    if (system->GetName() == pp->name) {
+      m_prototypes[gameobj].emplace_back(system.get(), pp);
+      return true;
+    }
+  }
+
+  CM_Error("object \"" << gameobj->GetName() << "\" uses an unknown native component \""
+                       << pp->module << "." << pp->name << "\".");
+  return true;
+}
+
+void KX_NativeComponentManager::Register(KX_GameObject *gameobj)
+{
+  std::unordered_map<KX_GameObject *, PrototypeList>::const_iterator it = m_prototypes.find(
+      gameobj);
+  if (it == m_prototypes.end()) {
+    return;
+  }
+
+  for (const std::pair<KX_NativeComponentSystem *, const PythonProxy *> &prototype : it->second)
+  {
+    prototype.first->Start(gameobj, prototype.second);
+  }
+}
+
+void KX_NativeComponentManager::Replicate(KX_GameObject *original, KX_GameObject *replica)
+{
+  std::unordered_map<KX_GameObject *, PrototypeList>::const_iterator it = m_prototypes.find(
+      original);
+  if (it == m_prototypes.end()) {
+    return;
+  }
+
+  // Copy before the insertion which can invalidate the iterator.
+  const PrototypeList prototypes = it->second;
+  m_prototypes[replica] = prototypes;
+  Register(replica);
+}
+
+void KX_NativeComponentManager::Unregister(KX_GameObject *gameobj)
+{
+  for (std::unique_ptr<KX_NativeComponentSystem> &system : m_systems) {
+    system->Dispose(gameobj);
+    system->UnlinkObject(gameobj);
+  }
+  m_prototypes.erase(gameobj);
+}
+
+void KX_NativeComponentManager::Update(KX_Scene *scene, double framestep)
+{
+  const float deltatime = (float)framestep;
+  for (std::unique_ptr<KX_NativeComponentSystem> &system : m_systems) {
+    CM_PROFILE_SCOPE_CACHED(system->GetProfileName(), system->GetName());
+    system->Update(scene, deltatime);
+  }
+}
@@ -0,0 +1,104 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_NativeComponentManager.h
+ *  \ingroup ketsji
+ *  \brief Components implemented in C++ and updated per type.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class KX_GameObject;
+class KX_Scene;
+struct PythonProxy;
+
+/** All the components of a native type. The data of the components is stored per field in
+ * arrays indexed as m_objects, the components are updated in one loop per type.
+ */
+class KX_NativeComponentSystem {
+ protected:
+  std::vector<KX_GameObject *> m_objects;
+  /// Index of the component of each object in the arrays.
+  std::unordered_map<KX_GameObject *, unsigned int> m_indices;
+  /// Name interned for the profiler scope of the update.
+  const char *m_profileName;
+
+  /// Append the data of a new component initialized from its arguments.
+  virtual void StartData(const PythonProxy *pp) = 0;
+  /// Move the data of the last component to the index of a disposed component.
+  virtual void MoveData(unsigned int from, unsigned int to) = 0;
+  virtual void PopData() = 0;
+
+ public:
+  KX_NativeComponentSystem();
+  virtual ~KX_NativeComponentSystem();
+
+  /// Name of the component class in the bge_extras.components module.
+  virtual std::string GetName() const = 0;
+  const char *&GetProfileName();
+
+  void Start(KX_GameObject *gameobj, const PythonProxy *pp);
+  void Dispose(KX_GameObject *gameobj);
+  /// Called when an object is removed from the scene, the systems must forget it.
+  virtual void UnlinkObject(KX_GameObject *gameobj);
+
+  virtual void Update(KX_Scene *scene, float deltatime) = 0;
+};
+
+/** Create and update the native components of the objects of a scene.
+ * A component of the .blend using a class of the bge_extras.components module is not
+ * imported in python but converted to a native component, its arguments are read from the
+ * component properties as for a python component.
+ */
+class KX_NativeComponentManager {
+ private:
+  typedef std::vector<std::pair<KX_NativeComponentSystem *, const PythonProxy *>> PrototypeList;
+
+  std::vector<std::unique_ptr<KX_NativeComponentSystem>> m_systems;
+  /// Components of the converted and replicated objects.
+  std::unordered_map<KX_GameObject *, PrototypeList> m_prototypes;
+
+ public:
+  KX_NativeComponentManager();
+  /// The systems are not shared, a copy starts without components.
+  KX_NativeComponentManager(const KX_NativeComponentManager &other);
+  ~KX_NativeComponentManager();
+
+  /** Store a component of a converted object if it is native.
+   * \return True if the component is native and must not be imported in python.
+   */
+  bool Convert(KX_GameObject *gameobj, const PythonProxy *pp);
+  /// Start the native components of an active object.
+  void Register(KX_GameObject *gameobj);
+  /// Start on a replica the native components of its original object.
+  void Replicate(KX_GameObject *original, KX_GameObject *replica);
+  /// Dispose the native components of a removed object.
+  void Unregister(KX_GameObject *gameobj);
+
+  /// Update all the components, framestep is the game time elapsed since the last logic frame.
+  void Update(KX_Scene *scene, double framestep);
+};
@@ -103,6 +103,12 @@ PyDoc_STRVAR(gPySetSolverDamping__doc__,
 PyDoc_STRVAR(gPySetSolverType__doc__,
              "setSolverType(int solverType)\n"
              "Very experimental, not recommended");
+PyDoc_STRVAR(gPySetNumThreads__doc__,
+             "setNumThreads(int numThreads)\n"
+             "This sets the number of threads used by the scenes using threaded physics");
+PyDoc_STRVAR(gPyGetNumThreads__doc__,
+             "getNumThreads()\n"
+             "This returns the number of threads used by the scenes using threaded physics");
 
 PyDoc_STRVAR(gPyCreateConstraint__doc__,
              "createConstraint(ob1,ob2,float restLength,float restitution,float damping)\n"
@@ -367,6 +373,28 @@ static PyObject *gPySetSolverType(PyObject *self, PyObject *args, PyObject *kwds
   Py_RETURN_NONE;
 }
 
+static PyObject *gPySetNumThreads(PyObject *self, PyObject *args, PyObject *kwds)
+{
+  int numThreads;
+  if (PyArg_ParseTuple(args, "i", &numThreads)) {
+    if (KX_GetPhysicsEnvironment()) {
+      KX_GetPhysicsEnvironment()->SetNumThreads(numThreads);
+    }
+  }
+  else {
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+
+static PyObject *gPyGetNumThreads(PyObject *, PyObject *)
+{
+  if (KX_GetPhysicsEnvironment()) {
+    return PyLong_FromLong(KX_GetPhysicsEnvironment()->GetNumThreads());
+  }
+  return PyLong_FromLong(1);
+}
+
 static PyObject *gPyGetVehicleConstraint(PyObject *self, PyObject *args, PyObject *kwds)
 {
 #  if defined(_WIN64)
@@ -665,6 +693,15 @@ static struct PyMethodDef physicsconstraints_methods[] = {
      METH_VARARGS,
      (const char *)gPySetSolverType__doc__},
 
+    {"setNumThreads",
+     (PyCFunction)gPySetNumThreads,
+     METH_VARARGS,
+     (const char *)gPySetNumThreads__doc__},
+    {"getNumThreads",
+     (PyCFunction)gPyGetNumThreads,
+     METH_NOARGS,
+     (const char *)gPyGetNumThreads__doc__},
+
     {"createConstraint",
      (PyCFunction)gPyCreateConstraint,
      METH_VARARGS | METH_KEYWORDS,
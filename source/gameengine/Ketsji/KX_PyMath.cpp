@@ -38,6 +38,10 @@
 
 #  include "KX_PyMath.h"
 
+#  include <cstring>
+
+#  include "BLI_utildefines.h"
+
 #  include "EXP_ListValue.h"
 #  include "EXP_Python.h"
 #  include "MT_Matrix4x4.h"
@@ -208,4 +212,221 @@ PyObject *PyColorFromVector(const MT_Vector3 &vec)
 #  endif
 }
 
+/// Return the format character of a buffer of single items, 0 for other formats.
+static char buffer_format(const Py_buffer &buffer)
+{
+  const char *format = buffer.format ? buffer.format : "B";
+  // Skip the native byte order and size characters.
+  if (ELEM(format[0], '@', '=')) {
+    ++format;
+  }
+
+  return (format[0] != '\0' && format[1] == '\0') ? format[0] : 0;
+}
+
+template<class T> static void buffer_read(const Py_buffer &buffer, std::vector<T> &values)
+{
+  const Py_ssize_t size = buffer.len / buffer.itemsize;
+  values.resize(size);
+
+  const char format = buffer_format(buffer);
+  for (Py_ssize_t i = 0; i < size; ++i) {
+    const char *item = (const char *)buffer.buf + i * buffer.itemsize;
+    switch (format) {
+      case 'f': {
+        values[i] = *(const float *)item;
+        break;
+      }
+      case 'd': {
+        values[i] = *(const double *)item;
+        break;
+      }
+      case 'b':
+      case 'h':
+      case 'i':
+      case 'l':
+      case 'q':
+      case 'n': {
+        switch (buffer.itemsize) {
+          case 1: {
+            values[i] = *(const int8_t *)item;
+            break;
+          }
+          case 2: {
+            values[i] = *(const int16_t *)item;
+            break;
+          }
+          case 4: {
+            values[i] = *(const int32_t *)item;
+            break;
+          }
+          default: {
+            values[i] = *(const int64_t *)item;
+            break;
+          }
+        }
+        break;
+      }
+      default: {
+        switch (buffer.itemsize) {
+          case 1: {
+            values[i] = *(const uint8_t *)item;
+            break;
+          }
+          case 2: {
+            values[i] = *(const uint16_t *)item;
+            break;
+          }
+          case 4: {
+            values[i] = *(const uint32_t *)item;
+            break;
+          }
+          default: {
+            values[i] = *(const uint64_t *)item;
+            break;
+          }
+        }
+        break;
+      }
+    }
+  }
+}
+
+/// Read a C contiguous buffer whose format is one of the given formats.
+template<class T>
+static bool buffer_to(PyObject *pyval,
+                      std::vector<T> &values,
+                      const char *formats,
+                      const char *type_name,
+                      const char *error_prefix)
+{
+  if (!PyObject_CheckBuffer(pyval)) {
+    PyErr_Format(PyExc_TypeError,
+                 "%s, expected an object supporting the buffer protocol, not %.200s",
+                 error_prefix,
+                 Py_TYPE(pyval)->tp_name);
+    return false;
+  }
+
+  Py_buffer buffer;
+  // Without strides the exporter fails for non C contiguous data.
+  if (PyObject_GetBuffer(pyval, &buffer, PyBUF_ND | PyBUF_FORMAT) == -1) {
+    return false;
+  }
+
+  const char format = buffer_format(buffer);
+  if (format == 0 || !strchr(formats, format)) {
+    PyErr_Format(PyExc_TypeError,
+                 "%s, expected a buffer of %s, not of format '%s'",
+                 error_prefix,
+                 type_name,
+                 buffer.format ? buffer.format : "B");
+    PyBuffer_Release(&buffer);
+    return false;
+  }
+
+  buffer_read(buffer, values);
+  PyBuffer_Release(&buffer);
+
+  return true;
+}
+
+bool PyFloatBufferTo(PyObject *pyval, std::vector<float> &values, const char *error_prefix)
+{
+  return buffer_to(pyval, values, "fd", "floats", error_prefix);
+}
+
+bool PyIntBufferTo(PyObject *pyval, std::vector<int> &values, const char *error_prefix)
+{
+  return buffer_to(pyval, values, "bBhHiIlLqQnN", "integers", error_prefix);
+}
+
+bool PyFloatBufferGetWritable(PyObject *pyval,
+                              Py_ssize_t size,
+                              Py_buffer &buffer,
+                              const char *error_prefix)
+{
+  if (!PyObject_CheckBuffer(pyval)) {
+    PyErr_Format(PyExc_TypeError,
+                 "%s, expected an object supporting the buffer protocol, not %.200s",
+                 error_prefix,
+                 Py_TYPE(pyval)->tp_name);
+    return false;
+  }
+
+  if (PyObject_GetBuffer(pyval, &buffer, PyBUF_ND | PyBUF_WRITABLE | PyBUF_FORMAT) == -1) {
+    return false;
+  }
+
+  const char format = buffer_format(buffer);
+  if (!ELEM(format, 'f', 'd')) {
+    PyErr_Format(PyExc_TypeError,
+                 "%s, expected a buffer of floats, not of format '%s'",
+                 error_prefix,
+                 buffer.format ? buffer.format : "B");
+    PyBuffer_Release(&buffer);
+    return false;
+  }
+
+  if (buffer.len / buffer.itemsize != size) {
+    PyErr_Format(PyExc_ValueError,
+                 "%s, expected a buffer of %zd floats, not %zd",
+                 error_prefix,
+                 size,
+                 buffer.len / buffer.itemsize);
+    PyBuffer_Release(&buffer);
+    return false;
+  }
+
+  return true;
+}
+
+void PyFloatBufferWrite(Py_buffer &buffer, const std::vector<float> &values)
+{
+  if (buffer_format(buffer) == 'f') {
+    memcpy(buffer.buf, values.data(), values.size() * sizeof(float));
+    return;
+  }
+
+  double *items = (double *)buffer.buf;
+  for (unsigned int i = 0, size = values.size(); i < size; ++i) {
+    items[i] = values[i];
+  }
+}
+
+PyObject *PyBufferNew(char format, Py_ssize_t rows, Py_ssize_t columns, void **data)
+{
+  BLI_assert(ELEM(format, 'f', 'i'));
+
+  const Py_ssize_t size = rows * columns;
+  // float and int are both 4 bytes, as their struct format.
+  PyObject *bytes = PyByteArray_FromStringAndSize(nullptr, size * 4);
+  if (!bytes) {
+    return nullptr;
+  }
+
+  char *buf = PyByteArray_AS_STRING(bytes);
+  memset(buf, 0, size * 4);
+  *data = buf;
+
+  PyObject *view = PyMemoryView_FromObject(bytes);
+  Py_DECREF(bytes);
+  if (!view) {
+    return nullptr;
+  }
+
+  const char formatStr[2] = {format, '\0'};
+  PyObject *result;
+  // A memory view can't be cast to a shape containing zero.
+  if (columns == 1 || size == 0) {
+    result = PyObject_CallMethod(view, "cast", "s", formatStr);
+  }
+  else {
+    result = PyObject_CallMethod(view, "cast", "s(nn)", formatStr, rows, columns);
+  }
+  Py_DECREF(view);
+
+  return result;
+}
+
 #endif  // WITH_PYTHON
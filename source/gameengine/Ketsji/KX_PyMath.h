@@ -40,6 +40,8 @@
 #include "MT_Vector3.h"
 #include "MT_Vector4.h"
 
+#include <vector>
+
 #ifdef WITH_PYTHON
 #  ifdef USE_MATHUTILS
 extern "C" {
@@ -292,4 +294,36 @@ PyObject *PyObjectFrom(const MT_Vector4 &pos);
  */
 PyObject *PyColorFromVector(const MT_Vector3 &vec);
 
+/**
+ * Read the items of an object supporting the buffer protocol with a float or double format,
+ * like a NumPy array, the buffer must be C contiguous and its items are read flat.
+ */
+bool PyFloatBufferTo(PyObject *pyval, std::vector<float> &values, const char *error_prefix);
+
+/**
+ * Read the items of an object supporting the buffer protocol with an integer format.
+ */
+bool PyIntBufferTo(PyObject *pyval, std::vector<int> &values, const char *error_prefix);
+
+/**
+ * Get a writable C contiguous buffer of size items with a float or double format, like a NumPy
+ * array, to fill it with PyFloatBufferWrite. The buffer must be released by PyBuffer_Release.
+ */
+bool PyFloatBufferGetWritable(PyObject *pyval,
+                              Py_ssize_t size,
+                              Py_buffer &buffer,
+                              const char *error_prefix);
+
+/**
+ * Write the values into a buffer obtained by PyFloatBufferGetWritable.
+ */
+void PyFloatBufferWrite(Py_buffer &buffer, const std::vector<float> &values);
+
+/**
+ * Create a writable memory view of rows * columns items of the struct format 'f' or 'i',
+ * NumPy arrays can be created from it without copy. The view has the shape (rows, columns),
+ * or (rows) if columns is 1, data receives the address of the zero initialized items.
+ */
+PyObject *PyBufferNew(char format, Py_ssize_t rows, Py_ssize_t columns, void **data);
+
 #endif  // WITH_PYTHON
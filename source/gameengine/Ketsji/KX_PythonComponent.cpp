@@ -32,7 +32,7 @@
 #  include "KX_GameObject.h"
 
 KX_PythonComponent::KX_PythonComponent(const std::string &name)
-    : KX_PythonProxy(), m_gameobj(nullptr), m_name(name)
+    : KX_PythonProxy(), m_gameobj(nullptr), m_name(name), m_profileName(nullptr)
 {
 }
 
@@ -55,6 +55,7 @@ void KX_PythonComponent::ProcessReplica()
   KX_PythonProxy::ProcessReplica();
 
   m_gameobj = nullptr;
+  m_profileName = nullptr;
 }
 
 KX_GameObject *KX_PythonComponent::GetGameObject() const
@@ -65,6 +66,17 @@ KX_GameObject *KX_PythonComponent::GetGameObject() const
 void KX_PythonComponent::SetGameObject(KX_GameObject *gameobj)
 {
   m_gameobj = gameobj;
+  m_profileName = nullptr;
+}
+
+const char *&KX_PythonComponent::GetProfileName()
+{
+  return m_profileName;
+}
+
+void KX_PythonComponent::ResetProfileName()
+{
+  m_profileName = nullptr;
 }
 
 PyObject *KX_PythonComponent::py_component_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
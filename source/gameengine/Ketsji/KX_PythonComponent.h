@@ -33,6 +33,8 @@ class KX_PythonComponent : public KX_PythonProxy {
 
       private : KX_GameObject *m_gameobj;
   std::string m_name;
+  /// Object and component names interned for the profiler scope of the update.
+  const char *m_profileName;
 
  public:
   KX_PythonComponent(const std::string &name);
@@ -46,6 +48,10 @@ class KX_PythonComponent : public KX_PythonProxy {
   KX_GameObject *GetGameObject() const;
   void SetGameObject(KX_GameObject *gameobj);
 
+  const char *&GetProfileName();
+  /// Forget the profiler name, called when the object is renamed.
+  void ResetProfileName();
+
   virtual KX_PythonProxy *NewInstance();
 
   static PyObject *py_component_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
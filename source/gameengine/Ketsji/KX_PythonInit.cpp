@@ -103,10 +103,12 @@
 #include "BL_Converter.h"
 #include "BL_Shader.h"
 #include "CM_Message.h"
+#include "CM_Profiler.h"
 #include "KX_Globals.h"
 #include "KX_LibLoadStatus.h"
 #include "KX_MeshProxy.h" /* for creating a new library of mesh objects */
 #include "KX_NavMeshObject.h"
+#include "KX_NetworkMessageManager.h"
 #include "KX_NetworkMessageScene.h"  //Needed for sendMessage()
 #include "KX_PyConstraintBinding.h"
 #include "KX_PyMath.h"
@@ -282,6 +284,108 @@ static PyObject *gPyGetProfileInfo(PyObject *)
   return KX_GetActiveEngine()->GetPyProfileDict();
 }
 
+PyDoc_STRVAR(gPyStartProfiling_doc,
+             "startProfiling(path)\n"
+             "Starts writing the timings of the frames to a Chrome trace file.\n"
+             " path - the file path, '//' is relative to the current .blend file.\n"
+             "Returns True if the file was opened.");
+static PyObject *gPyStartProfiling(PyObject *, PyObject *args)
+{
+  char expanded[FILE_MAX];
+  char *filename;
+
+  if (!PyArg_ParseTuple(args, "s:startProfiling", &filename)) {
+    return nullptr;
+  }
+
+  BLI_strncpy(expanded, filename, FILE_MAX);
+  BLI_path_abs(expanded, KX_GetMainPath().c_str());
+  return PyBool_FromLong(CM_Profiler::Start(expanded));
+}
+
+PyDoc_STRVAR(gPyStopProfiling_doc,
+             "stopProfiling()\n"
+             "Stops writing the timings of the frames and closes the trace file.");
+static PyObject *gPyStopProfiling(PyObject *)
+{
+  CM_Profiler::Stop();
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(gPyStartReplicationServer_doc,
+             "startReplicationServer(port, rate=20.0)\n"
+             "Starts sending the replicated objects to the clients.\n"
+             " port - the UDP port listened for the clients.\n"
+             " rate - the number of snapshots sent per second.\n"
+             "Returns True if the port was opened.");
+static PyObject *gPyStartReplicationServer(PyObject *, PyObject *args)
+{
+  int port;
+  double rate = 20.0;
+
+  if (!PyArg_ParseTuple(args, "i|d:startReplicationServer", &port, &rate)) {
+    return nullptr;
+  }
+
+  if (port < 0 || port > 65535) {
+    PyErr_SetString(PyExc_ValueError,
+                    "logic.startReplicationServer(port, rate): expected a port in [0, 65535]");
+    return nullptr;
+  }
+  if (rate <= 0.0) {
+    PyErr_SetString(PyExc_ValueError,
+                    "logic.startReplicationServer(port, rate): expected a positive rate");
+    return nullptr;
+  }
+
+  KX_NetworkReplication &replication =
+      KX_GetActiveEngine()->GetNetworkMessageManager()->GetReplication();
+  return PyBool_FromLong(replication.StartServer(port, rate));
+}
+
+PyDoc_STRVAR(gPyStartReplicationClient_doc,
+             "startReplicationClient(host, port, delay=0.1)\n"
+             "Starts receiving the replicated objects from a server.\n"
+             " host - the name or address of the server.\n"
+             " port - the UDP port of the server.\n"
+             " delay - the time in seconds in the past at which the objects are shown.\n"
+             "Returns True if the host was found.");
+static PyObject *gPyStartReplicationClient(PyObject *, PyObject *args)
+{
+  char *host;
+  int port;
+  double delay = 0.1;
+
+  if (!PyArg_ParseTuple(args, "si|d:startReplicationClient", &host, &port, &delay)) {
+    return nullptr;
+  }
+
+  if (port < 0 || port > 65535) {
+    PyErr_SetString(PyExc_ValueError,
+                    "logic.startReplicationClient(host, port, delay): expected a port in [0, "
+                    "65535]");
+    return nullptr;
+  }
+  if (delay < 0.0) {
+    PyErr_SetString(PyExc_ValueError,
+                    "logic.startReplicationClient(host, port, delay): expected a positive delay");
+    return nullptr;
+  }
+
+  KX_NetworkReplication &replication =
+      KX_GetActiveEngine()->GetNetworkMessageManager()->GetReplication();
+  return PyBool_FromLong(replication.StartClient(host, port, delay));
+}
+
+PyDoc_STRVAR(gPyStopReplication_doc,
+             "stopReplication()\n"
+             "Stops the replication server or client.");
+static PyObject *gPyStopReplication(PyObject *)
+{
+  KX_GetActiveEngine()->GetNetworkMessageManager()->GetReplication().Stop();
+  Py_RETURN_NONE;
+}
+
 PyDoc_STRVAR(gPySendMessage_doc,
              "sendMessage(subject, [body, to, from])\n"
              "sends a message in same manner as a message actuator"
@@ -917,6 +1021,17 @@ static struct PyMethodDef game_methods[] = {
      METH_NOARGS,
      (const char *)"Render next frame (if Python has control)"},
     {"getProfileInfo", (PyCFunction)gPyGetProfileInfo, METH_NOARGS, gPyGetProfileInfo_doc},
+    {"startProfiling", (PyCFunction)gPyStartProfiling, METH_VARARGS, gPyStartProfiling_doc},
+    {"stopProfiling", (PyCFunction)gPyStopProfiling, METH_NOARGS, gPyStopProfiling_doc},
+    {"startReplicationServer",
+     (PyCFunction)gPyStartReplicationServer,
+     METH_VARARGS,
+     gPyStartReplicationServer_doc},
+    {"startReplicationClient",
+     (PyCFunction)gPyStartReplicationClient,
+     METH_VARARGS,
+     gPyStartReplicationClient_doc},
+    {"stopReplication", (PyCFunction)gPyStopReplication, METH_NOARGS, gPyStopReplication_doc},
     /* library functions */
     {"LibLoad", (PyCFunction)gLibLoad, METH_VARARGS | METH_KEYWORDS, (const char *)""},
     {"LibNew", (PyCFunction)gLibNew, METH_VARARGS, (const char *)""},
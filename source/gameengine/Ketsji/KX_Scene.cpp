@@ -36,6 +36,10 @@
 
 #include "KX_Scene.h"
 
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "BKE_lib_id.h"
 #include "BKE_mball.h"
 #include "BKE_modifier.h"
@@ -61,6 +65,7 @@
 #include "BL_DataConversion.h"
 #include "BL_SceneConverter.h"
 #include "CM_List.h"
+#include "CM_Profiler.h"
 #include "EXP_FloatValue.h"
 #include "KX_2DFilterManager.h"
 #include "KX_BlenderCanvas.h"
@@ -75,8 +80,10 @@
 #include "KX_NodeRelationships.h"
 #include "KX_ObstacleSimulation.h"
 #include "KX_PyMath.h"
+#include "KX_SensorSpatialHash.h"
 #include "PHY_IPhysicsController.h"
 #include "PHY_IPhysicsEnvironment.h"
+#include "PHY_Snapshot.h"
 #include "RAS_BucketManager.h"
 #include "RAS_FrameBuffer.h"
 #include "SCA_2DFilterActuator.h"
@@ -93,6 +100,9 @@
 #  include "bpy_rna.h"
 #endif
 
+/// Task data of the animation task running on the current thread, nullptr outside of a task.
+static thread_local KX_Scene::AnimationTaskData *currentAnimationTask = nullptr;
+
 static void *KX_SceneReplicationFunc(SG_Node *node, void *gameobj, void *scene)
 {
   KX_GameObject *replica =
@@ -148,6 +158,7 @@ KX_Scene::KX_Scene(SCA_IInputDevice *inputDevice,
       m_active_camera(nullptr),
       m_overrideCullingCamera(nullptr),
       m_ueberExecutionPriority(0),
+      m_lastObjectSerial(0),
       m_blenderScene(scene),
       m_isActivedHysteresis(false),
       m_lodHysteresisValue(0),
@@ -164,6 +175,12 @@ KX_Scene::KX_Scene(SCA_IInputDevice *inputDevice,
   m_cameralist = new EXP_ListValue<KX_Camera>();
   m_fontlist = new EXP_ListValue<KX_FontObject>();
 
+  // These lists are searched by name from the scripts.
+  m_objectlist->EnableNameIndex(true);
+  m_lightlist->EnableNameIndex(true);
+  m_inactivelist->EnableNameIndex(true);
+  m_cameralist->EnableNameIndex(true);
+
   m_filterManager = new KX_2DFilterManager();
   m_logicmgr = new SCA_LogicManager();
 
@@ -204,6 +221,12 @@ KX_Scene::KX_Scene(SCA_IInputDevice *inputDevice,
   }
 
   m_animationPool = BLI_task_pool_create(&m_animationPoolData, TASK_PRIORITY_LOW);
+  m_threadedSceneGraph = false;
+  m_sceneGraphPool = BLI_task_pool_create(nullptr, TASK_PRIORITY_HIGH);
+  m_independentPhysics = false;
+  m_instanceBatchesModified = false;
+  m_transformSyncCount = 0;
+  m_sensorSpatialHash = nullptr;
 
 #ifdef WITH_PYTHON
   m_attr_dict = nullptr;
@@ -370,12 +393,25 @@ KX_Scene::~KX_Scene()
   // reference might be hanging and causing late release of objects
   RemoveAllDebugProperties();
 
+  // Free the pooled replicas first, the removed objects must not be parked anymore.
+  ClearObjectPools();
+
   while (GetRootParentList()->GetCount() > 0) {
     KX_GameObject *parentobj = GetRootParentList()->GetValue(0);
     this->RemoveObject(parentobj);
     BKE_view_layer_synced_ensure(scene, BKE_view_layer_default_view(scene));
   }
 
+  // All the instanced replicas are freed, remove their shared blender objects.
+  DRW_game_instances_set(nullptr, 0);
+  for (const auto &pair : m_instancedBlenderObjects) {
+    BKE_id_delete(bmain, pair.second);
+  }
+  if (!m_instancedBlenderObjects.empty()) {
+    DEG_relations_tag_update(bmain);
+  }
+  m_instancedBlenderObjects.clear();
+
   if (m_obstacleSimulation)
     delete m_obstacleSimulation;
 
@@ -383,6 +419,10 @@ KX_Scene::~KX_Scene()
     BLI_task_pool_free(m_animationPool);
   }
 
+  if (m_sceneGraphPool) {
+    BLI_task_pool_free(m_sceneGraphPool);
+  }
+
   if (m_objectlist)
     m_objectlist->Release();
 
@@ -754,10 +794,12 @@ void KX_Scene::RenderAfterCameraSetup(KX_Camera *cam,
   }
 
   /* Notify the depsgraph if object transform changed in the scene
-   * for next drawing loop. */
-  for (KX_GameObject *gameobj : GetObjectList()) {
+   * for next drawing loop. Only the objects updated by the scene graph
+   * since the last render pass are visited. */
+  for (KX_GameObject *gameobj : m_dirtyTransformObjects) {
     gameobj->TagForTransformUpdate(is_overlay_pass, is_last_render_pass);
   }
+  m_transformSyncCount = m_dirtyTransformObjects.size();
 
   /* Notify depsgraph for other changes */
   TagForExtraIdsUpdate(bmain, cam);
@@ -767,15 +809,35 @@ void KX_Scene::RenderAfterCameraSetup(KX_Camera *cam,
   }
 
   /* We need the changes to be flushed before each draw loop! */
-  BKE_scene_graph_update_tagged(depsgraph, bmain);
+  {
+    CM_PROFILE_SCOPE("Depsgraph");
+    BKE_scene_graph_update_tagged(depsgraph, bmain);
+  }
 
   UpdateParents(0.0);
 
   /* Update evaluated object object_to_world according to SceneGraph. */
-  for (KX_GameObject *gameobj : GetObjectList()) {
+  for (KX_GameObject *gameobj : m_dirtyTransformObjects) {
     gameobj->TagForTransformUpdateEvaluated();
   }
 
+  UpdateInstanceBatches();
+
+  /* Keep only the objects waiting for the next render passes, the objects
+   * updated by UpdateParents and the ones synchronized at every frame. */
+  if (is_last_render_pass) {
+    for (std::unordered_set<KX_GameObject *>::iterator it = m_dirtyTransformObjects.begin();
+         it != m_dirtyTransformObjects.end();)
+    {
+      if ((*it)->NeedTransformSync()) {
+        ++it;
+      }
+      else {
+        it = m_dirtyTransformObjects.erase(it);
+      }
+    }
+  }
+
   engine->EndCountDepsgraphTime();
 
   rcti window;
@@ -951,6 +1013,7 @@ void KX_Scene::RenderAfterCameraSetupImageRender(KX_Camera *cam, const rcti *win
                             winmat,
                             NULL);
 
+  DRW_game_instances_set(m_drawInstances.data(), m_drawInstances.size());
   DRW_game_render_loop(C, m_currentGPUViewport, depsgraph, window, false, false);
 }
 
@@ -1250,6 +1313,155 @@ void KX_Scene::RestoreObjectsMatToWorld()
   }
 }
 
+Object *KX_Scene::EnsureInstancedBlenderObject(Object *ob)
+{
+  std::map<Object *, Object *>::iterator it = m_instancedBlenderObjects.find(ob);
+  if (it != m_instancedBlenderObjects.end()) {
+    return it->second;
+  }
+
+  /* Same as KX_GameObject::ReplicateBlenderObject but the copy is done once for all the
+   * instanced replicas and stays hidden, only its evaluated data is used by the instances. */
+  bContext *C = KX_GetActiveEngine()->GetContext();
+  Main *bmain = CTX_data_main(C);
+  Scene *scene = GetBlenderScene();
+  ViewLayer *view_layer = BKE_view_layer_default_view(scene);
+
+  Object *newob;
+  BKE_id_copy_ex(bmain, &ob->id, (ID **)&newob, 0);
+  id_us_min(&newob->id);
+  BKE_collection_object_add_from(
+      bmain, scene, BKE_view_layer_camera_find(scene, view_layer), newob);
+  newob->base_flag |= (BASE_ENABLED_AND_MAYBE_VISIBLE_IN_VIEWPORT |
+                       BASE_ENABLED_AND_VISIBLE_IN_DEFAULT_VIEWPORT);
+  newob->visibility_flag &= ~OB_HIDE_VIEWPORT;
+
+  BKE_view_layer_synced_ensure(scene, view_layer);
+  Base *base = BKE_view_layer_base_find(view_layer, newob);
+  if (base) {
+    base->flag |= BASE_HIDDEN;
+    BKE_layer_collection_sync(scene, view_layer);
+    DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
+  }
+
+  DEG_relations_tag_update(bmain);
+  TagForCollectionRemap();
+
+  m_instancedBlenderObjects[ob] = newob;
+  return newob;
+}
+
+void KX_Scene::UpdateInstanceBatches()
+{
+  /* Only the instanced replicas moved, shown, hidden or colored since the last render pass
+   * are in the dirty transform objects. */
+  for (KX_GameObject *gameobj : m_dirtyTransformObjects) {
+    if (!gameobj->IsInstancedRender()) {
+      continue;
+    }
+
+    if (!gameobj->GetVisible()) {
+      RemoveInstance(gameobj);
+      continue;
+    }
+
+    InstanceBatch &batch = m_instanceBatches[gameobj->GetBlenderObject()];
+    std::pair<std::unordered_map<KX_GameObject *, unsigned int>::iterator, bool> result =
+        m_instanceIndices.emplace(gameobj, batch.objects.size());
+    const unsigned int index = result.first->second;
+    if (result.second) {
+      batch.objects.push_back(gameobj);
+      batch.matrices.resize(batch.matrices.size() + 16);
+      batch.colors.resize(batch.colors.size() + 4);
+      m_instanceBatchesModified = true;
+    }
+
+    gameobj->NodeGetWorldTransform().getValue(&batch.matrices[index * 16]);
+    const MT_Vector4 &color = gameobj->GetObjectColor();
+    std::copy(color.getValue(), color.getValue() + 4, &batch.colors[index * 4]);
+  }
+
+  if (m_instanceBatchesModified) {
+    m_drawInstances.clear();
+    for (std::map<Object *, InstanceBatch>::iterator it = m_instanceBatches.begin();
+         it != m_instanceBatches.end();)
+    {
+      InstanceBatch &batch = it->second;
+      // No more instances, release the buffers.
+      if (batch.objects.empty()) {
+        it = m_instanceBatches.erase(it);
+        continue;
+      }
+
+      DRWGameInstances instances;
+      instances.ob = it->first;
+      instances.matrices = reinterpret_cast<const float(*)[4][4]>(batch.matrices.data());
+      instances.colors = reinterpret_cast<const float(*)[4]>(batch.colors.data());
+      instances.len = batch.objects.size();
+      m_drawInstances.push_back(instances);
+      ++it;
+    }
+    m_instanceBatchesModified = false;
+  }
+
+  DRW_game_instances_set(m_drawInstances.data(), m_drawInstances.size());
+}
+
+void KX_Scene::RemoveInstance(KX_GameObject *gameobj)
+{
+  std::unordered_map<KX_GameObject *, unsigned int>::iterator it = m_instanceIndices.find(
+      gameobj);
+  if (it == m_instanceIndices.end()) {
+    return;
+  }
+
+  // WARNING: 'gameobj' maybe be freed, find its batch from the index without accessing it.
+  const unsigned int index = it->second;
+  m_instanceIndices.erase(it);
+  for (std::pair<Object *const, InstanceBatch> &pair : m_instanceBatches) {
+    InstanceBatch &batch = pair.second;
+    if (index >= batch.objects.size() || batch.objects[index] != gameobj) {
+      continue;
+    }
+
+    // The last instance fills the hole to keep the buffers contiguous.
+    const unsigned int last = batch.objects.size() - 1;
+    if (index != last) {
+      KX_GameObject *lastobj = batch.objects[last];
+      batch.objects[index] = lastobj;
+      m_instanceIndices[lastobj] = index;
+      std::copy_n(&batch.matrices[last * 16], 16, &batch.matrices[index * 16]);
+      std::copy_n(&batch.colors[last * 4], 4, &batch.colors[index * 4]);
+    }
+    batch.objects.pop_back();
+    batch.matrices.resize(last * 16);
+    batch.colors.resize(last * 4);
+    break;
+  }
+
+  m_instanceBatchesModified = true;
+}
+
+void KX_Scene::AddDirtyTransformObject(KX_GameObject *gameobj)
+{
+  m_dirtyTransformLock.Lock();
+  m_dirtyTransformObjects.insert(gameobj);
+  if (m_sensorSpatialHash) {
+    m_sensorSpatialHash->AddDirtyObject(gameobj);
+  }
+  m_dirtyTransformLock.Unlock();
+}
+
+void KX_Scene::SetSensorSpatialHash(KX_SensorSpatialHash *hash)
+{
+  m_sensorSpatialHash = hash;
+}
+
+unsigned int KX_Scene::GetTransformSyncCount() const
+{
+  return m_transformSyncCount;
+}
+
 bool KX_Scene::OrigObCanBeTransformedInRealtime(Object *ob)
 {
   FluidModifierData *fluidModifierData = (FluidModifierData *)BKE_modifiers_findby_type(
@@ -1346,23 +1558,34 @@ bool KX_Scene::SomethingIsMoving()
   return false;
 }
 
-void KX_Scene::AppendToIdsToUpdateInAllRenderPasses(ID *id, IDRecalcFlag flag)
+static void append_id_to_update(std::vector<std::pair<ID *, IDRecalcFlag>> &ids,
+                                ID *id,
+                                IDRecalcFlag flag)
 {
   std::pair<ID *, IDRecalcFlag> it = {id, flag};
-  if (std::find(m_idsToUpdateInAllRenderPasses.begin(),
-                m_idsToUpdateInAllRenderPasses.end(),
-                it) == m_idsToUpdateInAllRenderPasses.end()) {
-    m_idsToUpdateInAllRenderPasses.push_back(it);
+  if (std::find(ids.begin(), ids.end(), it) == ids.end()) {
+    ids.push_back(it);
+  }
+}
+
+void KX_Scene::AppendToIdsToUpdateInAllRenderPasses(ID *id, IDRecalcFlag flag)
+{
+  // Called from an animation task, the tag is merged after all tasks are done.
+  if (currentAnimationTask) {
+    append_id_to_update(currentAnimationTask->idsToUpdateInAllRenderPasses, id, flag);
+  }
+  else {
+    append_id_to_update(m_idsToUpdateInAllRenderPasses, id, flag);
   }
 }
 
 void KX_Scene::AppendToIdsToUpdateInOverlayPass(ID *id, IDRecalcFlag flag)
 {
-  std::pair<ID *, IDRecalcFlag> it = {id, flag};
-  if (std::find(m_idsToUpdateInOverlayPass.begin(),
-                m_idsToUpdateInOverlayPass.end(),
-                it) == m_idsToUpdateInOverlayPass.end()) {
-    m_idsToUpdateInOverlayPass.push_back(it);
+  if (currentAnimationTask) {
+    append_id_to_update(currentAnimationTask->idsToUpdateInOverlayPass, id, flag);
+  }
+  else {
+    append_id_to_update(m_idsToUpdateInOverlayPass, id, flag);
   }
 }
 
@@ -1511,6 +1734,11 @@ KX_PythonProxyManager &KX_Scene::GetPythonProxyManager()
   return m_proxyManager;
 }
 
+KX_NativeComponentManager &KX_Scene::GetNativeComponentManager()
+{
+  return m_nativeComponentManager;
+}
+
 EXP_ListValue<KX_Camera> *KX_Scene::GetCameraList() const
 {
   return m_cameralist;
@@ -1519,6 +1747,7 @@ EXP_ListValue<KX_Camera> *KX_Scene::GetCameraList() const
 void KX_Scene::SetCameraList(EXP_ListValue<KX_Camera> *camList)
 {
   m_cameralist = camList;
+  m_cameralist->EnableNameIndex(true);
 }
 
 EXP_ListValue<KX_FontObject> *KX_Scene::GetFontList() const
@@ -1587,6 +1816,7 @@ KX_GameObject *KX_Scene::AddNodeReplicaObject(SG_Node *node, KX_GameObject *game
 
   KX_GameObject *newobj = (KX_GameObject *)gameobj->GetReplica();
   m_map_gameobject_to_replica[gameobj] = newobj;
+  newobj->SetSerial(++m_lastObjectSerial);
 
   // also register 'timers' (time properties) of the replica
   int numprops = newobj->GetPropertyCount();
@@ -1629,11 +1859,13 @@ KX_GameObject *KX_Scene::AddNodeReplicaObject(SG_Node *node, KX_GameObject *game
   if (gameobj->GetPrototype() || gameobj->GetComponents()) {
     m_proxyManager.Register(newobj);
   }
+  m_nativeComponentManager.Replicate(gameobj, newobj);
 
   replicanode->SetSGClientObject(newobj);
 
   // this is the list of object that are send to the graphics pipeline
   m_objectlist->Add(CM_AddRef(newobj));
+  AddDirtyTransformObject(newobj);
   switch (newobj->GetGameObjectType()) {
     case SCA_IObject::OBJ_LIGHT: {
       m_lightlist->Add(CM_AddRef(static_cast<KX_LightObject *>(newobj)));
@@ -1953,11 +2185,24 @@ KX_GameObject *KX_Scene::AddReplicaObject(KX_GameObject *originalobject,
   KX_GameObject *originalobj = (KX_GameObject *)originalobject;
   KX_GameObject *referenceobj = (KX_GameObject *)referenceobject;
 
+  // Reuse a parked replica if any, it doesn't need any blender data or logic replication.
+  std::map<KX_GameObject *, std::vector<KX_GameObject *>>::iterator poolit = m_objectPools.find(
+      originalobj);
+  if (poolit != m_objectPools.end() && !poolit->second.empty()) {
+    m_ueberExecutionPriority++;
+    return AcquirePooledObject(originalobj, referenceobj, lifespan);
+  }
+
   m_ueberExecutionPriority++;
 
   // lets create a replica
   KX_GameObject *replica = (KX_GameObject *)AddNodeReplicaObject(nullptr, originalobj);
 
+  // the replica will be parked in the pool of the original when removed
+  if (m_objectPoolSizes.find(originalobj) != m_objectPoolSizes.end()) {
+    replica->SetPoolOriginal(originalobj);
+  }
+
   // add a timebomb to this object
   // lifespan of zero means 'this object lives forever'
   if (lifespan > 0.0f) {
@@ -2044,6 +2289,13 @@ KX_GameObject *KX_Scene::AddReplicaObject(KX_GameObject *originalobject,
 
 void KX_Scene::RemoveObject(KX_GameObject *gameobj)
 {
+  // Keep the replica for the next AddReplicaObject instead of freeing it.
+  if (ReleaseToObjectPool(gameobj)) {
+    return;
+  }
+
+  gameobj->SetSerial(0);
+
   // disconnect child from parent
   SG_Node *node = gameobj->GetSGNode();
 
@@ -2079,6 +2331,11 @@ void KX_Scene::DelayedRemoveObject(KX_GameObject *gameobj)
 
 bool KX_Scene::NewRemoveObject(KX_GameObject *gameobj)
 {
+  // The pooled replicas of a removed original object are freed too.
+  if (m_objectPoolSizes.find(gameobj) != m_objectPoolSizes.end()) {
+    SetObjectPoolSize(gameobj, 0);
+  }
+
   gameobj->Dispose();
 
   /* remove property from debug list */
@@ -2147,6 +2404,7 @@ bool KX_Scene::NewRemoveObject(KX_GameObject *gameobj)
   }
 
   m_proxyManager.Unregister(gameobj);
+  m_nativeComponentManager.Unregister(gameobj);
 
   gameobj->RemoveMeshes();
 
@@ -2174,6 +2432,11 @@ bool KX_Scene::NewRemoveObject(KX_GameObject *gameobj)
   CM_ListRemoveIfFound(m_animatedlist, gameobj);
   CM_ListRemoveIfFound(m_euthanasyobjects, gameobj);
   CM_ListRemoveIfFound(m_tempObjectList, gameobj);
+  m_dirtyTransformObjects.erase(gameobj);
+  RemoveInstance(gameobj);
+  if (m_sensorSpatialHash) {
+    m_sensorSpatialHash->RemoveObject(gameobj);
+  }
 
   if (gameobj == m_active_camera) {
     // no AddRef done on m_active_camera so no Release
@@ -2190,6 +2453,234 @@ bool KX_Scene::NewRemoveObject(KX_GameObject *gameobj)
   return ret;
 }
 
+KX_GameObject *KX_Scene::AcquirePooledObject(KX_GameObject *originalobj,
+                                             KX_GameObject *referenceobj,
+                                             float lifespan)
+{
+  std::vector<KX_GameObject *> &pool = m_objectPools[originalobj];
+  KX_GameObject *replica = pool.back();
+  pool.pop_back();
+
+  // A reused replica is a new object for the snapshots and the replication.
+  replica->SetSerial(++m_lastObjectSerial);
+
+  // The reference owned by the pool is given back to the object list.
+  m_objectlist->Add(replica);
+  m_parentlist->Add(CM_AddRef(replica));
+  AddDirtyTransformObject(replica);
+  GetBlenderSceneConverter()->RegisterGameObject(replica, replica->GetBlenderObject());
+
+  // Same placement as a new replica.
+  SG_Node *replicanode = replica->GetSGNode();
+  SG_Node *orgnode = originalobj->GetSGNode();
+  replicanode->SetLocalScale(orgnode->GetLocalScale());
+  replicanode->SetLocalPosition(orgnode->GetLocalPosition());
+  replicanode->SetLocalOrientation(orgnode->GetLocalOrientation());
+
+  if (referenceobj) {
+    replica->NodeSetLocalPosition(referenceobj->NodeGetWorldPosition());
+    replica->NodeSetLocalOrientation(referenceobj->NodeGetWorldOrientation());
+    replica->NodeSetRelativeScale(
+        referenceobj->GetSGNode()->GetRootSGParent()->GetLocalScale());
+    replica->SetLayer(referenceobj->GetLayer());
+  }
+  else {
+    replica->SetLayer(m_blenderScene->lay);
+  }
+
+  replicanode->UpdateWorldData(0);
+
+  replica->RestoreFromPool(originalobj);
+
+  // The logic of the replica runs after the older objects as for a new replica.
+  for (SCA_IController *cont : replica->GetControllers()) {
+    cont->SetUeberExecutePriority(m_ueberExecutionPriority);
+    for (SCA_IActuator *actuator : cont->GetLinkedActuators()) {
+      if (actuator->GetParent() == replica) {
+        actuator->SetUeberExecutePriority(m_ueberExecutionPriority);
+      }
+    }
+  }
+  // The native components start again as on a new replica.
+  m_nativeComponentManager.Replicate(originalobj, replica);
+
+  // Properties are replaced, register again the timers and the timebomb.
+  for (int i = 0, numprops = replica->GetPropertyCount(); i < numprops; ++i) {
+    EXP_Value *prop = replica->GetProperty(i);
+    if (prop->GetProperty("timer")) {
+      m_timemgr->AddTimeProperty(prop);
+    }
+  }
+
+  if (lifespan > 0.0f) {
+    m_tempObjectList.push_back(replica);
+    // See AddReplicaObject for the conversion from frames to seconds.
+    EXP_Value *fval = new EXP_FloatValue(lifespan * 0.016666667f);
+    replica->SetProperty("::timebomb", fval);
+    fval->Release();
+  }
+
+  if (m_obstacleSimulation && originalobj->GetBlenderObject()->gameflag & OB_HASOBSTACLE) {
+    m_obstacleSimulation->AddObstacleForObj(replica);
+  }
+
+  // The caller releases the returned object as for a new replica.
+  return CM_AddRef(replica);
+}
+
+bool KX_Scene::ReleaseToObjectPool(KX_GameObject *gameobj)
+{
+  KX_GameObject *originalobj = gameobj->GetPoolOriginal();
+  if (!originalobj) {
+    return false;
+  }
+
+  std::map<KX_GameObject *, unsigned int>::const_iterator sizeit = m_objectPoolSizes.find(
+      originalobj);
+  if (sizeit == m_objectPoolSizes.end()) {
+    return false;
+  }
+
+  std::vector<KX_GameObject *> &pool = m_objectPools[originalobj];
+  if (pool.size() >= sizeit->second) {
+    return false;
+  }
+
+  // Objects parented or used in a hierarchy since their creation are freed as usual.
+  SG_Node *node = gameobj->GetSGNode();
+  if (!node || node->GetSGParent() || !node->GetSGChildren().empty() ||
+      gameobj->GetDupliGroupObject() ||
+      (gameobj->GetBlenderObject()->gameflag & OB_OVERLAY_COLLECTION)) {
+    return false;
+  }
+
+  RemoveObjectDebugProperties(gameobj);
+
+  for (int i = 0, numprops = gameobj->GetPropertyCount(); i < numprops; ++i) {
+    EXP_Value *prop = gameobj->GetProperty(i);
+    if (prop->GetProperty("timer")) {
+      m_timemgr->RemoveTimeProperty(prop);
+    }
+  }
+
+  if (m_obstacleSimulation) {
+    m_obstacleSimulation->DestroyObstacleForObj(gameobj);
+  }
+
+  m_nativeComponentManager.Unregister(gameobj);
+
+  GetBlenderSceneConverter()->UnregisterGameObject(gameobj);
+
+  // The view layer base of a replica created this frame is needed to hide it.
+  Scene *scene = GetBlenderScene();
+  BKE_view_layer_synced_ensure(scene, BKE_view_layer_default_view(scene));
+
+  gameobj->SuspendToPool();
+  gameobj->SetSerial(0);
+
+  CM_ListRemoveIfFound(m_animatedlist, gameobj);
+  CM_ListRemoveIfFound(m_euthanasyobjects, gameobj);
+  CM_ListRemoveIfFound(m_tempObjectList, gameobj);
+  m_dirtyTransformObjects.erase(gameobj);
+  RemoveInstance(gameobj);
+  if (m_sensorSpatialHash) {
+    m_sensorSpatialHash->RemoveObject(gameobj);
+  }
+
+  // The pool takes the reference of the object list.
+  m_objectlist->RemoveValue(gameobj);
+  if (m_parentlist->RemoveValue(gameobj)) {
+    gameobj->Release();
+  }
+  pool.push_back(gameobj);
+
+  return true;
+}
+
+void KX_Scene::DestroyPooledObjects(std::vector<KX_GameObject *> &pool, unsigned int size)
+{
+  while (pool.size() > size) {
+    KX_GameObject *gameobj = pool.back();
+    pool.pop_back();
+
+    gameobj->SetPoolOriginal(nullptr);
+    // Give back the pool reference to the object list, it is released by the removal.
+    m_objectlist->Add(gameobj);
+    RemoveObject(gameobj);
+  }
+}
+
+bool KX_Scene::IsObjectPoolable(KX_GameObject *originalobj)
+{
+  // Only single objects without python components are reused.
+  return (originalobj->GetSGNode()->GetSGChildren().empty() && !originalobj->IsDupliGroup() &&
+          originalobj->GetGameObjectType() == -1 && !originalobj->GetPrototype() &&
+          !originalobj->GetComponents());
+}
+
+void KX_Scene::SetObjectPoolSize(KX_GameObject *originalobj, unsigned int size)
+{
+  if (size == 0) {
+    m_objectPoolSizes.erase(originalobj);
+  }
+  else {
+    m_objectPoolSizes[originalobj] = size;
+  }
+
+  std::map<KX_GameObject *, std::vector<KX_GameObject *>>::iterator it = m_objectPools.find(
+      originalobj);
+  if (it != m_objectPools.end()) {
+    DestroyPooledObjects(it->second, size);
+    if (it->second.empty()) {
+      m_objectPools.erase(it);
+    }
+  }
+}
+
+unsigned int KX_Scene::GetObjectPoolSize(KX_GameObject *originalobj) const
+{
+  std::map<KX_GameObject *, unsigned int>::const_iterator it = m_objectPoolSizes.find(
+      originalobj);
+  return (it != m_objectPoolSizes.end()) ? it->second : 0;
+}
+
+unsigned int KX_Scene::GetObjectPoolCount(KX_GameObject *originalobj) const
+{
+  std::map<KX_GameObject *, std::vector<KX_GameObject *>>::const_iterator it =
+      m_objectPools.find(originalobj);
+  return (it != m_objectPools.end()) ? it->second.size() : 0;
+}
+
+void KX_Scene::FillObjectPool(KX_GameObject *originalobj)
+{
+  const unsigned int size = GetObjectPoolSize(originalobj);
+  const unsigned int count = GetObjectPoolCount(originalobj);
+  if (count >= size) {
+    return;
+  }
+
+  /* Add all the missing replicas before removing them, the parked replicas are used
+   * first by AddReplicaObject. */
+  std::vector<KX_GameObject *> replicas(size - count);
+  for (KX_GameObject *&replica : replicas) {
+    replica = AddReplicaObject(originalobj, nullptr, 0.0f);
+  }
+
+  for (KX_GameObject *replica : replicas) {
+    RemoveObject(replica);
+    replica->Release();
+  }
+}
+
+void KX_Scene::ClearObjectPools()
+{
+  m_objectPoolSizes.clear();
+  for (auto &pair : m_objectPools) {
+    DestroyPooledObjects(pair.second, 0);
+  }
+  m_objectPools.clear();
+}
+
 void KX_Scene::ReplaceMesh(KX_GameObject *gameobj,
                            RAS_MeshObject *mesh,
                            bool use_gfx,
@@ -2204,6 +2695,12 @@ void KX_Scene::ReplaceMesh(KX_GameObject *gameobj,
     return;
   }
 
+  if (use_gfx && gameobj->IsInstancedRender()) {
+    CM_FunctionWarning("object \"" << gameobj->GetName()
+                                    << "\" is instanced, its render mesh can't be replaced");
+    use_gfx = false;
+  }
+
   if (use_gfx) {
     gameobj->RemoveMeshes();
     gameobj->AddMesh(mesh);
@@ -2349,72 +2846,74 @@ void KX_Scene::AddAnimatedObject(KX_GameObject *gameobj)
   CM_ListAddIfNotFound(m_animatedlist, gameobj);
 }
 
-// static void update_anim_thread_func(TaskPool *pool, void *taskdata, int UNUSED(threadid))
-//{
-//  KX_GameObject *gameobj, *parent;
-//  bool needs_update;
-//  KX_Scene::AnimationPoolData *data = (KX_Scene::AnimationPoolData
-//  *)BLI_task_pool_user_data(pool); double curtime = data->curtime;
-
-//  gameobj = (KX_GameObject *)taskdata;
-
-//  // Non-armature updates are fast enough, so just update them
-//  needs_update = gameobj->GetGameObjectType() != SCA_IObject::OBJ_ARMATURE;
+static void update_anim_thread_func(TaskPool *__restrict pool, void *taskdata)
+{
+  KX_Scene::AnimationPoolData *data = (KX_Scene::AnimationPoolData *)BLI_task_pool_user_data(
+      pool);
+  KX_Scene::AnimationTaskData *task = (KX_Scene::AnimationTaskData *)taskdata;
 
-//  if (!needs_update) {
-//    // If we got here, we're looking to update an armature, so check its children meshes
-//    // to see if we need to bother with a more expensive pose update
-//    const std::vector<KX_GameObject *> children = gameobj->GetChildren();
+  // Redirect the depsgraph tags to the task buffers.
+  currentAnimationTask = task;
+  task->gameobj->UpdateActionManager(data->curtime, true);
+  currentAnimationTask = nullptr;
+}
 
-//    bool has_mesh = false, has_non_mesh = false;
+void KX_Scene::UpdateAnimations(double curtime)
+{
+  m_animationPoolData.curtime = curtime;
 
-//    // Check for meshes that haven't been culled
-//    for (KX_GameObject *child : children) {
-//      // if (!child->GetCulled()) { // eevee disable armature animation culling
-//      needs_update = true;
-//      break;
-//      //}
+  std::vector<KX_GameObject *> armatures;
+  for (KX_GameObject *gameobj : m_animatedlist) {
+    if (gameobj->IsActionsSuspended()) {
+      continue;
+    }
 
-//      if (child->GetMeshCount() == 0)
-//        has_non_mesh = true;
-//      else
-//        has_mesh = true;
-//    }
+    /* Armature actions only modify the pose and the transform of their own object,
+     * they can be evaluated concurrently. Other actions can evaluate data shared between
+     * objects (node trees, shape keys) and are updated on the main thread.
+     */
+    if (gameobj->GetGameObjectType() == SCA_IObject::OBJ_ARMATURE) {
+      armatures.push_back(gameobj);
+    }
+    else {
+      gameobj->UpdateActionManager(curtime, true);
+    }
+  }
 
-//    // If we didn't find a non-culled mesh, check to see
-//    // if we even have any meshes, and update if this
-//    // armature has only non-mesh children.
-//    if (!needs_update && !has_mesh && has_non_mesh)
-//      needs_update = true;
-//  }
+  if (armatures.empty()) {
+    return;
+  }
 
-//  // If the object is a culled armature, then we manage only the animation time and end of its
-//  // animations.
-//  gameobj->UpdateActionManager(curtime, needs_update);
+  // Resize only, the tag buffers of the previous frame are cleared to reuse their memory.
+  if (m_animationTasks.size() < armatures.size()) {
+    m_animationTasks.resize(armatures.size());
+  }
 
-//  if (needs_update) {
-//    const std::vector<KX_GameObject *> children = gameobj->GetChildren();
-//    parent = gameobj->GetParent();
-//  }
-//}
+  for (unsigned int i = 0, size = armatures.size(); i < size; ++i) {
+    AnimationTaskData &task = m_animationTasks[i];
+    task.gameobj = armatures[i];
+    task.idsToUpdateInAllRenderPasses.clear();
+    task.idsToUpdateInOverlayPass.clear();
+    BLI_task_pool_push(m_animationPool, update_anim_thread_func, &task, false, nullptr);
+  }
 
-void KX_Scene::UpdateAnimations(double curtime)
-{
-  // m_animationPoolData.curtime = curtime;
+  BLI_task_pool_work_and_wait(m_animationPool);
 
-  for (KX_GameObject *gameobj : m_animatedlist) {
-    // BLI_task_pool_push(m_animationPool, update_anim_thread_func, gameobj, false,
-    // TASK_PRIORITY_LOW);
-    if (!gameobj->IsActionsSuspended()) {
-      gameobj->UpdateActionManager(curtime, true);
+  // Merge the depsgraph tags in the scene lists in the order of the animated objects.
+  for (unsigned int i = 0, size = armatures.size(); i < size; ++i) {
+    const AnimationTaskData &task = m_animationTasks[i];
+    for (const std::pair<ID *, IDRecalcFlag> &it : task.idsToUpdateInAllRenderPasses) {
+      AppendToIdsToUpdateInAllRenderPasses(it.first, it.second);
+    }
+    for (const std::pair<ID *, IDRecalcFlag> &it : task.idsToUpdateInOverlayPass) {
+      AppendToIdsToUpdateInOverlayPass(it.first, it.second);
     }
   }
-
-  // BLI_task_pool_work_and_wait(m_animationPool);
 }
 
-void KX_Scene::LogicUpdateFrame(double curtime)
+void KX_Scene::LogicUpdateFrame(double curtime, double framestep)
 {
+  m_nativeComponentManager.Update(this, framestep);
   m_proxyManager.Update();
 
   m_logicmgr->UpdateFrame(curtime);
@@ -2451,8 +2950,13 @@ void KX_Scene::UpdateParents(double curtime)
   // we use the SG dynamic list
   SG_Node *node;
 
-  while ((node = SG_Node::GetNextScheduled(m_sghead)) != nullptr) {
-    node->UpdateWorldData(curtime);
+  if (m_threadedSceneGraph) {
+    UpdateParentsThreaded(curtime);
+  }
+  else {
+    while ((node = SG_Node::GetNextScheduled(m_sghead)) != nullptr) {
+      node->UpdateWorldData(curtime);
+    }
   }
 
   // the list must be empty here
@@ -2463,25 +2967,140 @@ void KX_Scene::UpdateParents(double curtime)
   }
 }
 
-RAS_MaterialBucket *KX_Scene::FindBucket(class RAS_IPolyMaterial *polymat, bool &bucketCreated)
+static void update_scenegraph_thread_func(TaskPool *__restrict UNUSED(pool), void *taskdata)
 {
-  return m_bucketmanager->FindBucket(polymat, bucketCreated);
-}
+  KX_Scene::SceneGraphTaskData *task = (KX_Scene::SceneGraphTaskData *)taskdata;
 
-void KX_Scene::UpdateObjectLods(KX_Camera *cam)
-{
-  const MT_Vector3 &cam_pos = cam->NodeGetWorldPosition();
-  const float lodfactor = cam->GetLodDistanceFactor();
+  SG_Node::SetThreadScheduleList(&task->scheduleList);
 
-  for (KX_GameObject *gameobj : m_kxobWithLod) {
-    gameobj->UpdateLod(cam_pos, lodfactor);
+  // Update depth-first each scheduled sub tree of the hierarchies owned by this task.
+  for (SG_Node *node : task->nodes) {
+    node->UpdateWorldDataThread(task->curtime);
   }
+
+  SG_Node::SetThreadScheduleList(nullptr);
 }
 
-void KX_Scene::SetLodHysteresis(bool active)
+void KX_Scene::UpdateParentsThreaded(double curtime)
 {
-  m_isActivedHysteresis = active;
-}
+  std::vector<SG_Node *> scheduledNodes;
+  std::unordered_set<SG_Node *> scheduledSet;
+  std::unordered_map<const SG_Node *, unsigned int> rootGroupIndices;
+  std::vector<std::vector<SG_Node *>> rootGroups;
+
+  // Nodes can be scheduled again while updating, loop until the list is empty.
+  while (!m_sghead.Empty()) {
+    scheduledNodes.clear();
+    scheduledSet.clear();
+    rootGroupIndices.clear();
+    rootGroups.clear();
+
+    SG_Node *scheduledNode;
+    while ((scheduledNode = SG_Node::GetNextScheduled(m_sghead)) != nullptr) {
+      scheduledNodes.push_back(scheduledNode);
+      scheduledSet.insert(scheduledNode);
+    }
+
+    unsigned int numNodes = 0;
+    for (SG_Node *node : scheduledNodes) {
+      // Skip nodes with a scheduled ancestor, they are updated with their ancestor sub tree.
+      bool ancestorScheduled = false;
+      for (SG_Node *parent = node->GetSGParent(); parent; parent = parent->GetSGParent()) {
+        if (scheduledSet.find(parent) != scheduledSet.end()) {
+          ancestorScheduled = true;
+          break;
+        }
+      }
+      if (ancestorScheduled) {
+        continue;
+      }
+
+      // Group the nodes by root hierarchy, a hierarchy is never shared between two tasks.
+      const SG_Node *root = node->GetRootSGParent();
+      const auto it = rootGroupIndices.find(root);
+      if (it == rootGroupIndices.end()) {
+        rootGroupIndices.emplace(root, rootGroups.size());
+        rootGroups.push_back({node});
+      }
+      else {
+        rootGroups[it->second].push_back(node);
+      }
+      ++numNodes;
+    }
+
+    /* Partition the hierarchies in a few tasks per thread of balanced node count
+     * to avoid the overhead of a task per hierarchy. */
+    const unsigned int numTasks = std::min((unsigned int)rootGroups.size(),
+                                           (unsigned int)BLI_task_scheduler_num_threads() * 4);
+    const unsigned int nodesPerTask = (numNodes + numTasks - 1) / numTasks;
+
+    if (m_sceneGraphTasks.size() < numTasks) {
+      m_sceneGraphTasks.resize(numTasks);
+    }
+
+    unsigned int taskIndex = 0;
+    m_sceneGraphTasks[0].nodes.clear();
+    for (const std::vector<SG_Node *> &group : rootGroups) {
+      if (m_sceneGraphTasks[taskIndex].nodes.size() >= nodesPerTask && taskIndex < numTasks - 1) {
+        m_sceneGraphTasks[++taskIndex].nodes.clear();
+      }
+      std::vector<SG_Node *> &nodes = m_sceneGraphTasks[taskIndex].nodes;
+      nodes.insert(nodes.end(), group.begin(), group.end());
+    }
+
+    for (unsigned int i = 0; i <= taskIndex; ++i) {
+      SceneGraphTaskData &task = m_sceneGraphTasks[i];
+      task.curtime = curtime;
+      BLI_task_pool_push(m_sceneGraphPool, update_scenegraph_thread_func, &task, false, nullptr);
+    }
+
+    BLI_task_pool_work_and_wait(m_sceneGraphPool);
+
+    for (unsigned int i = 0; i <= taskIndex; ++i) {
+      SG_Node::MergeScheduleList(m_sceneGraphTasks[i].scheduleList, m_sghead);
+    }
+  }
+}
+
+void KX_Scene::SetThreadedSceneGraph(bool threaded)
+{
+  m_threadedSceneGraph = threaded;
+}
+
+bool KX_Scene::GetThreadedSceneGraph() const
+{
+  return m_threadedSceneGraph;
+}
+
+void KX_Scene::SetIndependentPhysics(bool independent)
+{
+  m_independentPhysics = independent;
+}
+
+bool KX_Scene::GetIndependentPhysics() const
+{
+  return m_independentPhysics;
+}
+
+RAS_MaterialBucket *KX_Scene::FindBucket(class RAS_IPolyMaterial *polymat, bool &bucketCreated)
+{
+  return m_bucketmanager->FindBucket(polymat, bucketCreated);
+}
+
+void KX_Scene::UpdateObjectLods(KX_Camera *cam)
+{
+  const MT_Vector3 &cam_pos = cam->NodeGetWorldPosition();
+  const float lodfactor = cam->GetLodDistanceFactor();
+
+  for (KX_GameObject *gameobj : m_kxobWithLod) {
+    gameobj->UpdateLod(cam_pos, lodfactor);
+  }
+}
+
+void KX_Scene::SetLodHysteresis(bool active)
+{
+  m_isActivedHysteresis = active;
+}
 
 bool KX_Scene::IsActivedLodHysteresis(void)
 {
@@ -2519,8 +3138,14 @@ void KX_Scene::UpdateObjectActivity(void)
 
   for (KX_GameObject *gameobj : m_objectlist) {
     // If the object doesn't manage activity culling we don't compute distance.
-    if (gameobj->GetActivityCullingInfo().m_flags ==
-        KX_GameObject::ActivityCullingInfo::ACTIVITY_NONE) {
+    const KX_GameObject::ActivityCullingInfo::Flag flags =
+        gameobj->GetActivityCullingInfo().m_flags;
+    if (flags == KX_GameObject::ActivityCullingInfo::ACTIVITY_NONE) {
+      continue;
+    }
+
+    // A sleeping object only needs its logic activity to be managed.
+    if (!(flags & KX_GameObject::ActivityCullingInfo::ACTIVITY_LOGIC) && gameobj->IsSleeping()) {
       continue;
     }
 
@@ -2559,11 +3184,135 @@ MT_Vector3 KX_Scene::GetGravity()
   return gravity;
 }
 
+/// Identify the scene snapshots and their format, "KXSS" and a version.
+static const unsigned int SCENE_STATE_MAGIC = 0x5353584B;
+static const unsigned int SCENE_STATE_VERSION = 2;
+
+bool KX_Scene::SaveState(std::vector<char> &buffer)
+{
+  PHY_SnapshotWriter writer(buffer);
+  writer.Write(SCENE_STATE_MAGIC);
+  writer.Write(SCENE_STATE_VERSION);
+  writer.Write(m_objectlist->GetCount());
+
+  for (KX_GameObject *gameobj : m_objectlist) {
+    // Identify the object, an object removed and another added give a different list.
+    const std::string name = gameobj->GetName();
+    writer.Write((unsigned int)name.size());
+    writer.Write(name.data(), name.size());
+    writer.Write(gameobj->GetSerial());
+
+    writer.Write(gameobj->NodeGetLocalPosition());
+    writer.Write(gameobj->NodeGetLocalOrientation());
+    writer.Write(gameobj->NodeGetLocalScaling());
+
+    PHY_IPhysicsController *ctrl = gameobj->GetPhysicsController();
+    writer.Write(ctrl != nullptr);
+    if (ctrl) {
+      ctrl->SaveState(writer);
+    }
+  }
+
+  return m_physicsEnvironment->SaveState(writer);
+}
+
+template <class Value> static bool state_value_changed(const Value &value, const Value &other)
+{
+  return (memcmp(&value, &other, sizeof(Value)) != 0);
+}
+
+bool KX_Scene::RestoreState(const char *data, size_t size)
+{
+  PHY_SnapshotReader reader(data, size);
+  unsigned int magic, version;
+  int numObjects;
+  if (!reader.Read(magic) || !reader.Read(version) || !reader.Read(numObjects) ||
+      magic != SCENE_STATE_MAGIC || version != SCENE_STATE_VERSION ||
+      numObjects != m_objectlist->GetCount()) {
+    return false;
+  }
+
+  struct ObjectState {
+    MT_Vector3 position;
+    MT_Matrix3x3 orientation;
+    MT_Vector3 scale;
+    std::unique_ptr<PHY_ISnapshotState> physicsState;
+  };
+
+  // Read and check the whole snapshot first, the scene is left untouched if it is invalid.
+  std::vector<ObjectState> objectStates(numObjects);
+  std::string name;
+  for (int i = 0; i < numObjects; ++i) {
+    KX_GameObject *gameobj = m_objectlist->GetValue(i);
+
+    // The object must be the one saved, not an other one at the same index.
+    const std::string objectName = gameobj->GetName();
+    unsigned int nameSize, serial;
+    if (!reader.Read(nameSize) || nameSize != objectName.size()) {
+      return false;
+    }
+    name.resize(nameSize);
+    if (!reader.Read(&name[0], nameSize) || name != objectName || !reader.Read(serial) ||
+        serial != gameobj->GetSerial()) {
+      return false;
+    }
+
+    ObjectState &state = objectStates[i];
+    bool hasCtrl;
+    if (!reader.Read(state.position) || !reader.Read(state.orientation) ||
+        !reader.Read(state.scale) || !reader.Read(hasCtrl)) {
+      return false;
+    }
+
+    PHY_IPhysicsController *ctrl = gameobj->GetPhysicsController();
+    if (hasCtrl != (ctrl != nullptr)) {
+      return false;
+    }
+    if (ctrl) {
+      state.physicsState.reset(ctrl->ReadState(reader));
+      if (!state.physicsState) {
+        return false;
+      }
+    }
+  }
+
+  std::unique_ptr<PHY_ISnapshotState> environmentState(m_physicsEnvironment->ReadState(reader));
+  if (!environmentState || !reader.IsEnd()) {
+    return false;
+  }
+
+  for (int i = 0; i < numObjects; ++i) {
+    KX_GameObject *gameobj = m_objectlist->GetValue(i);
+    const ObjectState &state = objectStates[i];
+
+    /* Only update the modified nodes, updating the node of a static object
+     * turns its physics object to kinematic. */
+    if (state_value_changed(state.position, gameobj->NodeGetLocalPosition())) {
+      gameobj->NodeSetLocalPosition(state.position);
+    }
+    if (state_value_changed(state.orientation, gameobj->NodeGetLocalOrientation())) {
+      gameobj->NodeSetLocalOrientation(state.orientation);
+    }
+    if (state_value_changed(state.scale, gameobj->NodeGetLocalScaling())) {
+      gameobj->NodeSetLocalScale(state.scale);
+    }
+
+    if (state.physicsState) {
+      state.physicsState->Apply();
+    }
+  }
+
+  environmentState->Apply();
+
+  return true;
+}
+
 void KX_Scene::SetPhysicsEnvironment(class PHY_IPhysicsEnvironment *physEnv)
 {
   m_physicsEnvironment = physEnv;
   if (m_physicsEnvironment) {
-    KX_CollisionEventManager *collisionmgr = new KX_CollisionEventManager(m_logicmgr, physEnv);
+    KX_CollisionEventManager *collisionmgr = new KX_CollisionEventManager(
+        m_logicmgr, physEnv, this, (m_blenderScene->gm.flag & GAME_USE_SENSOR_HASH) != 0);
     m_logicmgr->RegisterEventManager(collisionmgr);
   }
 }
@@ -2667,6 +3416,7 @@ bool KX_Scene::MergeScene(KX_Scene *other)
   /* active + inactive == all ??? - lets hope so */
   for (KX_GameObject *gameobj : *other->GetObjectList()) {
     MergeScene_GameObject(gameobj, this, other);
+    AddDirtyTransformObject(gameobj);
 
     /* add properties to debug list for LibLoad objects */
     if (KX_GetActiveEngine()->GetFlag(KX_KetsjiEngine::AUTO_ADD_DEBUG_PROPERTIES)) {
@@ -2846,6 +3596,9 @@ PyTypeObject KX_Scene::Type = {PyVarObject_HEAD_INIT(nullptr, 0) "KX_Scene",
 
 PyMethodDef KX_Scene::Methods[] = {
     EXP_PYMETHODTABLE(KX_Scene, addObject),
+    EXP_PYMETHODTABLE(KX_Scene, setObjectPoolSize),
+    EXP_PYMETHODTABLE_O(KX_Scene, getObjectPoolSize),
+    EXP_PYMETHODTABLE_O(KX_Scene, getObjectPoolCount),
     EXP_PYMETHODTABLE(KX_Scene, end),
     EXP_PYMETHODTABLE(KX_Scene, restart),
     EXP_PYMETHODTABLE(KX_Scene, replace),
@@ -2858,6 +3611,10 @@ PyMethodDef KX_Scene::Methods[] = {
     EXP_PYMETHODTABLE(KX_Scene, addOverlayCollection),
     EXP_PYMETHODTABLE(KX_Scene, removeOverlayCollection),
     EXP_PYMETHODTABLE(KX_Scene, getGameObjectFromObject),
+    EXP_PYMETHODTABLE_NOARGS(KX_Scene, saveState),
+    EXP_PYMETHODTABLE_O(KX_Scene, restoreState),
+    EXP_PYMETHODTABLE_KEYWORDS(KX_Scene, getTransforms),
+    EXP_PYMETHODTABLE_KEYWORDS(KX_Scene, setTransforms),
 
     /* dict style access */
     EXP_PYMETHODTABLE(KX_Scene, get),
@@ -3176,6 +3933,31 @@ int KX_Scene::pyattr_set_gravity(EXP_PyObjectPlus *self_v,
   return PY_SET_ATTR_SUCCESS;
 }
 
+PyObject *KX_Scene::pyattr_get_deterministic_physics(EXP_PyObjectPlus *self_v,
+                                                     const EXP_PYATTRIBUTE_DEF *attrdef)
+{
+  KX_Scene *self = static_cast<KX_Scene *>(self_v);
+
+  return PyBool_FromLong(self->GetPhysicsEnvironment()->GetDeterministic());
+}
+
+int KX_Scene::pyattr_set_deterministic_physics(EXP_PyObjectPlus *self_v,
+                                               const EXP_PYATTRIBUTE_DEF *attrdef,
+                                               PyObject *value)
+{
+  KX_Scene *self = static_cast<KX_Scene *>(self_v);
+
+  int param = PyObject_IsTrue(value);
+  if (param == -1) {
+    PyErr_SetString(PyExc_AttributeError,
+                    "scene.deterministicPhysics = bool: KX_Scene, expected True or False");
+    return PY_SET_ATTR_FAIL;
+  }
+
+  self->GetPhysicsEnvironment()->SetDeterministic(param);
+  return PY_SET_ATTR_SUCCESS;
+}
+
 PyAttributeDef KX_Scene::Attributes[] = {
     EXP_PYATTRIBUTE_RO_FUNCTION("name", KX_Scene, pyattr_get_name),
     EXP_PYATTRIBUTE_RO_FUNCTION("objects", KX_Scene, pyattr_get_objects),
@@ -3199,6 +3981,10 @@ PyAttributeDef KX_Scene::Attributes[] = {
     EXP_PYATTRIBUTE_RW_FUNCTION(
         "pre_draw_setup", KX_Scene, pyattr_get_drawing_callback, pyattr_set_drawing_callback),
     EXP_PYATTRIBUTE_RW_FUNCTION("gravity", KX_Scene, pyattr_get_gravity, pyattr_set_gravity),
+    EXP_PYATTRIBUTE_RW_FUNCTION("deterministicPhysics",
+                                KX_Scene,
+                                pyattr_get_deterministic_physics,
+                                pyattr_set_deterministic_physics),
     EXP_PYATTRIBUTE_BOOL_RO("activityCulling", KX_Scene, m_activityCulling),
     EXP_PYATTRIBUTE_BOOL_RO("dbvt_culling", KX_Scene, m_dbvt_culling),
     EXP_PYATTRIBUTE_RO_FUNCTION("logger", KX_Scene, KX_PythonProxy::pyattr_get_logger),
@@ -3255,6 +4041,90 @@ EXP_PYMETHODDEF_DOC(KX_Scene,
   return replica->GetProxy();
 }
 
+EXP_PYMETHODDEF_DOC(KX_Scene,
+                    setObjectPoolSize,
+                    "setObjectPoolSize(object, size, fill=False)\n"
+                    "Set the maximum number of removed replicas of object kept for reuse.\n")
+{
+  PyObject *pyob;
+  KX_GameObject *ob;
+  int size;
+  int fill = 0;
+
+  if (!PyArg_ParseTuple(args, "Oi|i:setObjectPoolSize", &pyob, &size, &fill)) {
+    return nullptr;
+  }
+
+  if (!ConvertPythonToGameObject(
+          m_logicmgr,
+          pyob,
+          &ob,
+          false,
+          "scene.setObjectPoolSize(object, size, fill): KX_Scene (first argument)")) {
+    return nullptr;
+  }
+
+  if (!m_inactivelist->SearchValue(ob)) {
+    PyErr_SetString(PyExc_ValueError,
+                    "scene.setObjectPoolSize(object, size, fill): KX_Scene (first argument): "
+                    "object must be in an inactive layer");
+    return nullptr;
+  }
+
+  if (size < 0) {
+    PyErr_SetString(PyExc_ValueError,
+                    "scene.setObjectPoolSize(object, size, fill): KX_Scene (second argument): "
+                    "size must be positive or zero");
+    return nullptr;
+  }
+
+  if (size > 0 && !IsObjectPoolable(ob)) {
+    PyErr_SetString(PyExc_ValueError,
+                    "scene.setObjectPoolSize(object, size, fill): KX_Scene (first argument): "
+                    "only objects without children, group, components or special type "
+                    "(armature, camera, light, text) can be pooled");
+    return nullptr;
+  }
+
+  SetObjectPoolSize(ob, size);
+  if (fill) {
+    FillObjectPool(ob);
+  }
+
+  Py_RETURN_NONE;
+}
+
+EXP_PYMETHODDEF_DOC_O(KX_Scene,
+                      getObjectPoolSize,
+                      "getObjectPoolSize(object)\n"
+                      "Return the maximum number of removed replicas of object kept for "
+                      "reuse.\n")
+{
+  KX_GameObject *ob;
+
+  if (!ConvertPythonToGameObject(
+          m_logicmgr, value, &ob, false, "scene.getObjectPoolSize(object): KX_Scene")) {
+    return nullptr;
+  }
+
+  return PyLong_FromLong(GetObjectPoolSize(ob));
+}
+
+EXP_PYMETHODDEF_DOC_O(KX_Scene,
+                      getObjectPoolCount,
+                      "getObjectPoolCount(object)\n"
+                      "Return the number of replicas of object currently kept for reuse.\n")
+{
+  KX_GameObject *ob;
+
+  if (!ConvertPythonToGameObject(
+          m_logicmgr, value, &ob, false, "scene.getObjectPoolCount(object): KX_Scene")) {
+    return nullptr;
+  }
+
+  return PyLong_FromLong(GetObjectPoolCount(ob));
+}
+
 EXP_PYMETHODDEF_DOC(KX_Scene,
                     end,
                     "end()\n"
@@ -3541,6 +4411,324 @@ EXP_PYMETHODDEF_DOC(KX_Scene,
   Py_RETURN_NONE;
 }
 
+EXP_PYMETHODDEF_DOC_NOARGS(KX_Scene,
+                           saveState,
+                           "saveState()\n"
+                           "Return the simulation state of the scene as bytes.\n")
+{
+  std::vector<char> buffer;
+  if (!SaveState(buffer)) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "scene.saveState(): KX_Scene, the physics engine doesn't support states");
+    return nullptr;
+  }
+
+  return PyBytes_FromStringAndSize(buffer.data(), buffer.size());
+}
+
+EXP_PYMETHODDEF_DOC_O(KX_Scene,
+                      restoreState,
+                      "restoreState(state)\n"
+                      "Restore a simulation state returned by saveState.\n")
+{
+  Py_buffer view;
+  if (PyObject_GetBuffer(value, &view, PyBUF_SIMPLE) == -1) {
+    return nullptr;
+  }
+
+  const bool restored = RestoreState((const char *)view.buf, view.len);
+  PyBuffer_Release(&view);
+
+  if (!restored) {
+    PyErr_SetString(PyExc_ValueError,
+                    "scene.restoreState(state): KX_Scene, the state doesn't match the scene");
+    return nullptr;
+  }
+
+  Py_RETURN_NONE;
+}
+
+/// Convert a sequence of game objects or names.
+static bool convert_python_to_game_objects(SCA_LogicManager *logicmgr,
+                                           PyObject *value,
+                                           std::vector<KX_GameObject *> &objects,
+                                           const char *error_prefix)
+{
+  PyObject *sequence = PySequence_Fast(value, error_prefix);
+  if (!sequence) {
+    return false;
+  }
+
+  const Py_ssize_t size = PySequence_Fast_GET_SIZE(sequence);
+  PyObject **items = PySequence_Fast_ITEMS(sequence);
+  objects.resize(size);
+  for (Py_ssize_t i = 0; i < size; ++i) {
+    if (!ConvertPythonToGameObject(logicmgr, items[i], &objects[i], false, error_prefix)) {
+      Py_DECREF(sequence);
+      return false;
+    }
+  }
+
+  Py_DECREF(sequence);
+  return true;
+}
+
+EXP_PYMETHODDEF_DOC(KX_Scene,
+                    getTransforms,
+                    "getTransforms(objects, velocities=False, out=None)\n"
+                    "Return the world positions and orientations of objects as float buffers "
+                    "of shape (n, 3) and (n, 4), the orientations are quaternions (w, x, y, z).\n"
+                    " velocities = also return the world linear velocities as a float buffer "
+                    "of shape (n, 3).\n"
+                    " out = writable float buffers filled and returned instead of new buffers.\n")
+{
+  PyObject *pyobjects;
+  int velocities = 0;
+  PyObject *pyout = Py_None;
+
+  static const char *kwlist[] = {"objects", "velocities", "out", nullptr};
+  if (!PyArg_ParseTupleAndKeywords(args,
+                                   kwds,
+                                   "O|iO:getTransforms",
+                                   const_cast<char **>(kwlist),
+                                   &pyobjects,
+                                   &velocities,
+                                   &pyout)) {
+    return nullptr;
+  }
+
+  std::vector<KX_GameObject *> objects;
+  if (!convert_python_to_game_objects(
+          m_logicmgr, pyobjects, objects, "scene.getTransforms(objects, ...): KX_Scene")) {
+    return nullptr;
+  }
+
+  const unsigned int numObjects = objects.size();
+  const unsigned int numBuffers = velocities ? 3 : 2;
+  const unsigned int columns[3] = {3, 4, 3};
+
+  // Get all the output buffers before computing the transforms.
+  PyObject *outsequence = nullptr;
+  Py_buffer outbuffers[3];
+  if (pyout != Py_None) {
+    const char *error_prefix = "scene.getTransforms(objects, velocities, out): KX_Scene";
+    outsequence = PySequence_Fast(pyout, error_prefix);
+    if (!outsequence) {
+      return nullptr;
+    }
+    if (PySequence_Fast_GET_SIZE(outsequence) != (Py_ssize_t)numBuffers) {
+      PyErr_Format(PyExc_ValueError, "%s, expected %u buffers", error_prefix, numBuffers);
+      Py_DECREF(outsequence);
+      return nullptr;
+    }
+
+    PyObject **items = PySequence_Fast_ITEMS(outsequence);
+    for (unsigned int i = 0; i < numBuffers; ++i) {
+      if (!PyFloatBufferGetWritable(
+              items[i], numObjects * columns[i], outbuffers[i], error_prefix)) {
+        for (unsigned int j = 0; j < i; ++j) {
+          PyBuffer_Release(&outbuffers[j]);
+        }
+        Py_DECREF(outsequence);
+        return nullptr;
+      }
+    }
+  }
+
+  /* The values are written straight into the new buffers or into the buffers of floats of the
+   * caller, only the buffers of doubles are filled from temporary values. */
+  float *data[3];
+  std::vector<float> doubleValues[3];
+  PyObject *result = nullptr;
+  if (outsequence) {
+    for (unsigned int i = 0; i < numBuffers; ++i) {
+      // The writable buffers are of floats or doubles.
+      if (outbuffers[i].itemsize == sizeof(float)) {
+        data[i] = (float *)outbuffers[i].buf;
+      }
+      else {
+        doubleValues[i].resize(numObjects * columns[i]);
+        data[i] = doubleValues[i].data();
+      }
+    }
+  }
+  else {
+    result = PyTuple_New(numBuffers);
+    for (unsigned int i = 0; i < numBuffers; ++i) {
+      PyObject *pybuffer = PyBufferNew('f', numObjects, columns[i], (void **)&data[i]);
+      if (!pybuffer) {
+        Py_DECREF(result);
+        return nullptr;
+      }
+      PyTuple_SET_ITEM(result, i, pybuffer);
+    }
+  }
+
+  for (unsigned int i = 0; i < numObjects; ++i) {
+    KX_GameObject *gameobj = objects[i];
+
+    gameobj->NodeGetWorldPosition().getValue(&data[0][i * 3]);
+
+    const MT_Quaternion orientation = gameobj->NodeGetWorldOrientation().getRotation();
+    float *quat = &data[1][i * 4];
+    quat[0] = orientation.w();
+    quat[1] = orientation.x();
+    quat[2] = orientation.y();
+    quat[3] = orientation.z();
+
+    if (velocities) {
+      gameobj->GetLinearVelocity(false).getValue(&data[2][i * 3]);
+    }
+  }
+
+  if (outsequence) {
+    for (unsigned int i = 0; i < numBuffers; ++i) {
+      if (!doubleValues[i].empty()) {
+        PyFloatBufferWrite(outbuffers[i], doubleValues[i]);
+      }
+      PyBuffer_Release(&outbuffers[i]);
+    }
+
+    result = PySequence_Tuple(outsequence);
+    Py_DECREF(outsequence);
+  }
+
+  return result;
+}
+
+EXP_PYMETHODDEF_DOC(KX_Scene,
+                    setTransforms,
+                    "setTransforms(objects, positions=None, orientations=None, velocities=None)\n"
+                    "Set the world positions, orientations and linear velocities of objects from "
+                    "float buffers of shape (n, 3), (n, 4) and (n, 3), the orientations are "
+                    "quaternions (w, x, y, z).\n")
+{
+  PyObject *pyobjects;
+  PyObject *pypositions = Py_None;
+  PyObject *pyorientations = Py_None;
+  PyObject *pyvelocities = Py_None;
+
+  static const char *kwlist[] = {"objects", "positions", "orientations", "velocities", nullptr};
+  if (!PyArg_ParseTupleAndKeywords(args,
+                                   kwds,
+                                   "O|OOO:setTransforms",
+                                   const_cast<char **>(kwlist),
+                                   &pyobjects,
+                                   &pypositions,
+                                   &pyorientations,
+                                   &pyvelocities)) {
+    return nullptr;
+  }
+
+  std::vector<KX_GameObject *> objects;
+  if (!convert_python_to_game_objects(
+          m_logicmgr, pyobjects, objects, "scene.setTransforms(objects, ...): KX_Scene")) {
+    return nullptr;
+  }
+
+  const unsigned int numObjects = objects.size();
+  const bool setPositions = (pypositions != Py_None);
+  const bool setOrientations = (pyorientations != Py_None);
+  const bool setVelocities = (pyvelocities != Py_None);
+
+  // Check all the values before modifying any object.
+  std::vector<float> positions;
+  if (setPositions) {
+    if (!PyFloatBufferTo(
+            pypositions, positions, "scene.setTransforms(objects, positions, ...): KX_Scene")) {
+      return nullptr;
+    }
+    if (positions.size() != numObjects * 3) {
+      PyErr_Format(PyExc_ValueError,
+                   "scene.setTransforms(objects, positions, ...): KX_Scene, expected %u "
+                   "positions of 3 floats",
+                   numObjects);
+      return nullptr;
+    }
+  }
+
+  std::vector<float> orientations;
+  if (setOrientations) {
+    if (!PyFloatBufferTo(pyorientations,
+                         orientations,
+                         "scene.setTransforms(objects, positions, orientations, ...): KX_Scene")) {
+      return nullptr;
+    }
+    if (orientations.size() != numObjects * 4) {
+      PyErr_Format(PyExc_ValueError,
+                   "scene.setTransforms(objects, positions, orientations, ...): KX_Scene, "
+                   "expected %u quaternions of 4 floats",
+                   numObjects);
+      return nullptr;
+    }
+    for (unsigned int i = 0; i < numObjects; ++i) {
+      const float *quat = &orientations[i * 4];
+      if ((quat[0] * quat[0] + quat[1] * quat[1] + quat[2] * quat[2] + quat[3] * quat[3]) <
+          FLT_EPSILON) {
+        PyErr_Format(PyExc_ValueError,
+                     "scene.setTransforms(objects, positions, orientations, ...): KX_Scene, "
+                     "the quaternion %u is null",
+                     i);
+        return nullptr;
+      }
+    }
+  }
+
+  std::vector<float> velocities;
+  if (setVelocities) {
+    if (!PyFloatBufferTo(pyvelocities,
+                         velocities,
+                         "scene.setTransforms(objects, positions, orientations, velocities): "
+                         "KX_Scene")) {
+      return nullptr;
+    }
+    if (velocities.size() != numObjects * 3) {
+      PyErr_Format(PyExc_ValueError,
+                   "scene.setTransforms(objects, positions, orientations, velocities): "
+                   "KX_Scene, expected %u velocities of 3 floats",
+                   numObjects);
+      return nullptr;
+    }
+  }
+
+  /* Setting the local transforms only marks the nodes modified and schedules them, the world
+   * transforms of all the objects are updated in one scene graph pass at the end. */
+  if (setPositions || setOrientations) {
+    for (unsigned int i = 0; i < numObjects; ++i) {
+      KX_GameObject *gameobj = objects[i];
+
+      // The world transform of a modified parent is needed to compute the local transform.
+      for (SG_Node *parent = gameobj->GetSGNode()->GetSGParent(); parent;
+           parent = parent->GetSGParent())
+      {
+        if (parent->IsModified()) {
+          UpdateParents(0.0);
+          break;
+        }
+      }
+
+      if (setPositions) {
+        gameobj->NodeSetWorldPosition(MT_Vector3(&positions[i * 3]));
+      }
+      if (setOrientations) {
+        const float *quat = &orientations[i * 4];
+        gameobj->NodeSetGlobalOrientation(
+            MT_Matrix3x3(MT_Quaternion(quat[1], quat[2], quat[3], quat[0])));
+      }
+    }
+
+    UpdateParents(0.0);
+  }
+
+  if (setVelocities) {
+    for (unsigned int i = 0; i < numObjects; ++i) {
+      objects[i]->setLinearVelocity(MT_Vector3(&velocities[i * 3]), false);
+    }
+  }
+
+  Py_RETURN_NONE;
+}
+
 bool ConvertPythonToScene(PyObject *value,
                           KX_Scene **scene,
                           bool py_none_ok,
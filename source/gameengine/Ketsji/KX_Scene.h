@@ -32,13 +32,18 @@
 #pragma once
 
 #include <list>
+#include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "DNA_ID.h"  // For IDRecalcFlag
 
+#include "CM_Thread.h"
 #include "EXP_PyObjectPlus.h"
 #include "EXP_Value.h"
+#include "KX_NativeComponentManager.h"
 #include "KX_PhysicsEngineEnums.h"
 #include "KX_PythonProxy.h"
 #include "KX_PythonProxyManager.h"
@@ -83,7 +88,9 @@ class KX_2DFilterManager;
 class BL_SceneConverter;
 struct KX_ClientObjectInfo;
 class KX_ObstacleSimulation;
+class KX_SensorSpatialHash;
 struct TaskPool;
+struct DRWGameInstances;
 
 /*********EEVEE INTEGRATION************/
 struct bNodeTree;
@@ -111,6 +118,24 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
     double curtime;
   };
 
+  /** Data of an animation task, the depsgraph tags requested while updating
+   * the object are stored in the task and merged into the scene after the pool
+   * is done to avoid locking the shared lists.
+   */
+  struct AnimationTaskData {
+    KX_GameObject *gameobj;
+    std::vector<std::pair<ID *, IDRecalcFlag>> idsToUpdateInAllRenderPasses;
+    std::vector<std::pair<ID *, IDRecalcFlag>> idsToUpdateInOverlayPass;
+  };
+
+  /// Data of a scene graph task, a set of independent hierarchies updated on the same thread.
+  struct SceneGraphTaskData {
+    double curtime;
+    std::vector<SG_Node *> nodes;
+    /// Nodes scheduled while updating, merged in the scene update list after the tasks.
+    SG_ScheduleList scheduleList;
+  };
+
  private:
   Py_Header
 
@@ -190,6 +215,7 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   SCA_TimeEventManager *m_timemgr;
 
   KX_PythonProxyManager m_proxyManager;
+  KX_NativeComponentManager m_nativeComponentManager;
 
   /**
    * physics engine abstraction
@@ -263,6 +289,9 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
    */
   int m_ueberExecutionPriority;
 
+  /// Last serial given to an added replica, see KX_GameObject::GetSerial.
+  unsigned int m_lastObjectSerial;
+
   /**
    * Toggle to enable or disable activity culling.
    */
@@ -303,6 +332,61 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
 
   AnimationPoolData m_animationPoolData;
   TaskPool *m_animationPool;
+  /// Task data of the objects animated in parallel, kept to reuse allocated tag buffers.
+  std::vector<AnimationTaskData> m_animationTasks;
+
+  /// Update the independent hierarchies of the scene graph in parallel.
+  bool m_threadedSceneGraph;
+  TaskPool *m_sceneGraphPool;
+  std::vector<SceneGraphTaskData> m_sceneGraphTasks;
+
+  /// The physics of the scene is stepped concurrently with the other independent scenes.
+  bool m_independentPhysics;
+
+  /** Instance buffers of the visible instanced replicas, 16 floats per matrix and 4 per color
+   * at the index of the object.
+   */
+  struct InstanceBatch {
+    std::vector<KX_GameObject *> objects;
+    std::vector<float> matrices;
+    std::vector<float> colors;
+  };
+
+  /// Hidden blender object shared by all the instanced replicas of an original blender object.
+  std::map<Object *, Object *> m_instancedBlenderObjects;
+  /// Instance buffers per shared blender object, updated from the dirty transform objects.
+  std::map<Object *, InstanceBatch> m_instanceBatches;
+  /// Index of the drawn instanced replicas in the buffers of their batch.
+  std::unordered_map<KX_GameObject *, unsigned int> m_instanceIndices;
+  /// An instance was added or removed, the buffers given to the draw manager are outdated.
+  bool m_instanceBatchesModified;
+  /// Instance buffers given to the draw manager.
+  std::vector<DRWGameInstances> m_drawInstances;
+
+  /** Active objects whose transform must be sent to the depsgraph in the next render pass,
+   * filled by the scene graph update transform callback.
+   */
+  std::unordered_set<KX_GameObject *> m_dirtyTransformObjects;
+  /// Lock of the dirty objects, objects can be tagged from the animation tasks.
+  CM_ThreadSpinLock m_dirtyTransformLock;
+  /// Number of objects sent to the depsgraph in the last render pass.
+  unsigned int m_transformSyncCount;
+  /// Grid of the Near and Radar sensors, also receiving the dirty objects, nullptr if unused.
+  KX_SensorSpatialHash *m_sensorSpatialHash;
+
+  /// Removed replicas kept hidden and suspended for reuse by AddReplicaObject, per original.
+  std::map<KX_GameObject *, std::vector<KX_GameObject *>> m_objectPools;
+  /// Maximum number of replicas kept in the pool of an original object.
+  std::map<KX_GameObject *, unsigned int> m_objectPoolSizes;
+
+  /// Enable back a replica from the pool of an original object, used in AddReplicaObject.
+  KX_GameObject *AcquirePooledObject(KX_GameObject *originalobj,
+                                     KX_GameObject *referenceobj,
+                                     float lifespan);
+  /// Park a removed replica in the pool of its original, return false if it must be freed.
+  bool ReleaseToObjectPool(KX_GameObject *gameobj);
+  /// Free the parked replicas of a pool until it contains at most size replicas.
+  void DestroyPooledObjects(std::vector<KX_GameObject *> &pool, unsigned int size);
 
   /**
    * LOD Hysteresis settings
@@ -366,6 +450,17 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   void RestoreObjectsMatToWorld();
   void TagForObjectsMatToWorldRestore();
   bool OrigObCanBeTransformedInRealtime(Object *ob);
+  /// Return the hidden blender object drawn for all the instanced replicas of ob.
+  Object *EnsureInstancedBlenderObject(Object *ob);
+  /// Add, update or remove the instances of the dirty instanced replicas in their batches.
+  void UpdateInstanceBatches();
+  /// Remove an instanced replica from its batch, for a removed or pooled object.
+  void RemoveInstance(KX_GameObject *gameobj);
+  /// Tag an object to send its transform to the depsgraph in the next render pass.
+  void AddDirtyTransformObject(KX_GameObject *gameobj);
+  unsigned int GetTransformSyncCount() const;
+  /// Set the sensor grid notified of the moved and removed objects.
+  void SetSensorSpatialHash(KX_SensorSpatialHash *hash);
   void IgnoreParentTxBGE(struct Main *bmain,
                          struct Depsgraph *depsgraph,
                          Object *ob,
@@ -391,6 +486,12 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   static bool KX_ScenegraphUpdateFunc(SG_Node *node, void *gameobj, void *scene);
   static bool KX_ScenegraphRescheduleFunc(SG_Node *node, void *gameobj, void *scene);
   void UpdateParents(double curtime);
+  /// Update all the scheduled nodes, the root hierarchies are partitioned over m_sceneGraphPool.
+  void UpdateParentsThreaded(double curtime);
+  void SetThreadedSceneGraph(bool threaded);
+  bool GetThreadedSceneGraph() const;
+  void SetIndependentPhysics(bool independent);
+  bool GetIndependentPhysics() const;
   void DupliGroupRecurse(KX_GameObject *groupobj, int level);
   bool IsObjectInGroup(KX_GameObject *gameobj)
   {
@@ -408,6 +509,26 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   void DelayedRemoveObject(KX_GameObject *gameobj);
 
   bool NewRemoveObject(KX_GameObject *gameobj);
+
+  /**
+   * \section Object pooling.
+   * Replicas of an original object with a pool size are not freed when removed but
+   * parked in a pool and reused by the next AddReplicaObject of this original, avoiding
+   * the copy of the blender object and the rebuild of the depsgraph relations.
+   */
+
+  /// Return true if the replicas of this original object can be pooled.
+  bool IsObjectPoolable(KX_GameObject *originalobj);
+  /// Set the maximum number of parked replicas, zero disables and clears the pool.
+  void SetObjectPoolSize(KX_GameObject *originalobj, unsigned int size);
+  unsigned int GetObjectPoolSize(KX_GameObject *originalobj) const;
+  /// Return the number of replicas currently parked in the pool.
+  unsigned int GetObjectPoolCount(KX_GameObject *originalobj) const;
+  /// Create replicas until the pool is full, to avoid the replication cost during the game.
+  void FillObjectPool(KX_GameObject *originalobj);
+  /// Free all the pooled replicas and disable all the pools.
+  void ClearObjectPools();
+
   void ReplaceMesh(KX_GameObject *gameobj, RAS_MeshObject *mesh, bool use_gfx, bool use_phys);
 
   void AddAnimatedObject(KX_GameObject *gameobj);
@@ -417,7 +538,7 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
    * Initiate an update of the logic system.
    */
   void LogicBeginFrame(double curtime, double framestep);
-  void LogicUpdateFrame(double curtime);
+  void LogicUpdateFrame(double curtime, double framestep);
   void UpdateAnimations(double curtime);
 
   void LogicEndFrame();
@@ -432,6 +553,7 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   SCA_TimeEventManager *GetTimeEventManager() const;
 
   KX_PythonProxyManager &GetPythonProxyManager();
+  KX_NativeComponentManager &GetNativeComponentManager();
 
   EXP_ListValue<KX_Camera> *GetCameraList() const;
   void SetCameraList(EXP_ListValue<KX_Camera> *camList);
@@ -538,6 +660,15 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   void SetGravity(const MT_Vector3 &gravity);
   MT_Vector3 GetGravity();
 
+  /** Append the simulation state of the scene to the buffer: the object transforms and the
+   * physics state. Return false if the physics environment doesn't support snapshots.
+   */
+  bool SaveState(std::vector<char> &buffer);
+  /** Restore a state saved by SaveState, the objects of the scene must be the same.
+   * Return false and leave the scene unchanged if the state doesn't match the scene.
+   */
+  bool RestoreState(const char *data, size_t size);
+
   short GetAnimationFPS();
 
   /**
@@ -568,6 +699,9 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   /* --------------------------------------------------------------------- */
 
   EXP_PYMETHOD_DOC(KX_Scene, addObject);
+  EXP_PYMETHOD_DOC(KX_Scene, setObjectPoolSize);
+  EXP_PYMETHOD_DOC_O(KX_Scene, getObjectPoolSize);
+  EXP_PYMETHOD_DOC_O(KX_Scene, getObjectPoolCount);
   EXP_PYMETHOD_DOC(KX_Scene, end);
   EXP_PYMETHOD_DOC(KX_Scene, restart);
   EXP_PYMETHOD_DOC(KX_Scene, replace);
@@ -581,6 +715,10 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   EXP_PYMETHOD_DOC(KX_Scene, addOverlayCollection);
   EXP_PYMETHOD_DOC(KX_Scene, removeOverlayCollection);
   EXP_PYMETHOD_DOC(KX_Scene, getGameObjectFromObject);
+  EXP_PYMETHOD_DOC_NOARGS(KX_Scene, saveState);
+  EXP_PYMETHOD_DOC_O(KX_Scene, restoreState);
+  EXP_PYMETHOD_DOC(KX_Scene, getTransforms);
+  EXP_PYMETHOD_DOC(KX_Scene, setTransforms);
 
   /* attributes */
   static PyObject *pyattr_get_name(EXP_PyObjectPlus *self_v, const EXP_PYATTRIBUTE_DEF *attrdef);
@@ -619,6 +757,11 @@ class KX_Scene : public KX_PythonProxy, public SCA_IScene {
   static int pyattr_set_gravity(EXP_PyObjectPlus *self_v,
                                 const EXP_PYATTRIBUTE_DEF *attrdef,
                                 PyObject *value);
+  static PyObject *pyattr_get_deterministic_physics(EXP_PyObjectPlus *self_v,
+                                                    const EXP_PYATTRIBUTE_DEF *attrdef);
+  static int pyattr_set_deterministic_physics(EXP_PyObjectPlus *self_v,
+                                              const EXP_PYATTRIBUTE_DEF *attrdef,
+                                              PyObject *value);
 
   /* getitem/setitem */
   static PyMappingMethods Mapping;
@@ -0,0 +1,253 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/Ketsji/KX_SensorSpatialHash.cpp
+ *  \ingroup ketsji
+ */
+
+#include "KX_SensorSpatialHash.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "KX_ClientObjectInfo.h"
+#include "KX_GameObject.h"
+#include "MT_MinMax.h"
+#include "PHY_IPhysicsController.h"
+
+/// Objects covering more cells are not inserted in the cells but tested by all the queries.
+static const int maxEntryCells = 64;
+
+static uint64_t cell_key(int x, int y, int z)
+{
+  // 21 bits per axis, distant cells can share a key, the bounding boxes are tested anyway.
+  return ((uint64_t)(x & 0x1FFFFF) << 42) | ((uint64_t)(y & 0x1FFFFF) << 21) |
+         (uint64_t)(z & 0x1FFFFF);
+}
+
+KX_SensorSpatialHash::KX_SensorSpatialHash(float cellSize)
+    : m_cellSize(cellSize), m_initialized(false), m_query(0)
+{
+}
+
+KX_SensorSpatialHash::~KX_SensorSpatialHash()
+{
+}
+
+void KX_SensorSpatialHash::GetCellRange(const MT_Vector3 &aabbMin,
+                                        const MT_Vector3 &aabbMax,
+                                        int cellMin[3],
+                                        int cellMax[3]) const
+{
+  // Clamp to keep the cell coordinates in the range of an int for infinite or huge boxes.
+  static const MT_Scalar maxCell = 1.0e6f;
+  for (unsigned short i = 0; i < 3; ++i) {
+    cellMin[i] = (int)std::floor(MT_max(-maxCell, MT_min(aabbMin[i] / m_cellSize, maxCell)));
+    cellMax[i] = (int)std::floor(MT_max(-maxCell, MT_min(aabbMax[i] / m_cellSize, maxCell)));
+  }
+}
+
+void KX_SensorSpatialHash::InsertEntry(Entry *entry)
+{
+  const int64_t numCells = (int64_t)(entry->m_cellMax[0] - entry->m_cellMin[0] + 1) *
+                           (entry->m_cellMax[1] - entry->m_cellMin[1] + 1) *
+                           (entry->m_cellMax[2] - entry->m_cellMin[2] + 1);
+  entry->m_large = (numCells > maxEntryCells);
+  if (entry->m_large) {
+    m_largeEntries.push_back(entry);
+    return;
+  }
+
+  for (int x = entry->m_cellMin[0]; x <= entry->m_cellMax[0]; ++x) {
+    for (int y = entry->m_cellMin[1]; y <= entry->m_cellMax[1]; ++y) {
+      for (int z = entry->m_cellMin[2]; z <= entry->m_cellMax[2]; ++z) {
+        m_cells[cell_key(x, y, z)].push_back(entry);
+      }
+    }
+  }
+}
+
+static void remove_entry(std::vector<KX_SensorSpatialHash::Entry *> &entries,
+                         KX_SensorSpatialHash::Entry *entry)
+{
+  std::vector<KX_SensorSpatialHash::Entry *>::iterator it = std::find(
+      entries.begin(), entries.end(), entry);
+  if (it != entries.end()) {
+    *it = entries.back();
+    entries.pop_back();
+  }
+}
+
+void KX_SensorSpatialHash::RemoveEntry(Entry *entry)
+{
+  if (entry->m_large) {
+    remove_entry(m_largeEntries, entry);
+    return;
+  }
+
+  for (int x = entry->m_cellMin[0]; x <= entry->m_cellMax[0]; ++x) {
+    for (int y = entry->m_cellMin[1]; y <= entry->m_cellMax[1]; ++y) {
+      for (int z = entry->m_cellMin[2]; z <= entry->m_cellMax[2]; ++z) {
+        // The empty cells are kept, an object moving around reuses them.
+        remove_entry(m_cells[cell_key(x, y, z)], entry);
+      }
+    }
+  }
+}
+
+void KX_SensorSpatialHash::UpdateObject(KX_GameObject *gameobj)
+{
+  PHY_IPhysicsController *ctrl = gameobj->GetPhysicsController();
+  KX_ClientObjectInfo *info = gameobj->getClientInfo();
+  // Only the actors are sensed, the same objects as in the physics broadphase.
+  if (!ctrl || !info || !info->isActor()) {
+    RemoveObject(gameobj);
+    return;
+  }
+
+  std::pair<std::unordered_map<KX_GameObject *, Entry>::iterator, bool> result =
+      m_entries.emplace(gameobj, Entry());
+  Entry &entry = result.first->second;
+  const bool inserted = result.second;
+
+  entry.m_object = gameobj;
+  ctrl->GetAabb(entry.m_aabbMin, entry.m_aabbMax);
+
+  int cellMin[3];
+  int cellMax[3];
+  GetCellRange(entry.m_aabbMin, entry.m_aabbMax, cellMin, cellMax);
+
+  if (inserted) {
+    entry.m_query = m_query;
+  }
+  else if (std::equal(cellMin, cellMin + 3, entry.m_cellMin) &&
+           std::equal(cellMax, cellMax + 3, entry.m_cellMax)) {
+    // The object is still in the same cells.
+    return;
+  }
+  else {
+    RemoveEntry(&entry);
+  }
+
+  std::copy(cellMin, cellMin + 3, entry.m_cellMin);
+  std::copy(cellMax, cellMax + 3, entry.m_cellMax);
+  InsertEntry(&entry);
+}
+
+void KX_SensorSpatialHash::AddDirtyObject(KX_GameObject *gameobj)
+{
+  m_dirtyObjects.insert(gameobj);
+}
+
+void KX_SensorSpatialHash::RemoveObject(KX_GameObject *gameobj)
+{
+  m_dirtyObjects.erase(gameobj);
+
+  std::unordered_map<KX_GameObject *, Entry>::iterator it = m_entries.find(gameobj);
+  if (it != m_entries.end()) {
+    RemoveEntry(&it->second);
+    m_entries.erase(it);
+  }
+}
+
+void KX_SensorSpatialHash::Update(EXP_ListValue<KX_GameObject> *objects)
+{
+  if (!m_initialized) {
+    for (KX_GameObject *gameobj : *objects) {
+      UpdateObject(gameobj);
+    }
+    m_dirtyObjects.clear();
+    m_initialized = true;
+    return;
+  }
+
+  for (KX_GameObject *gameobj : m_dirtyObjects) {
+    UpdateObject(gameobj);
+  }
+  m_dirtyObjects.clear();
+}
+
+static bool aabb_overlap(const MT_Vector3 &min1,
+                         const MT_Vector3 &max1,
+                         const MT_Vector3 &min2,
+                         const MT_Vector3 &max2)
+{
+  return (min1[0] <= max2[0] && max1[0] >= min2[0] && min1[1] <= max2[1] &&
+          max1[1] >= min2[1] && min1[2] <= max2[2] && max1[2] >= min2[2]);
+}
+
+/** The objects with suspended physics keep their entry to not depend on a transform change
+ * when their physics is restored, but they are not sensed as in the broadphase.
+ */
+static bool is_entry_sensed(KX_SensorSpatialHash::Entry *entry)
+{
+  PHY_IPhysicsController *ctrl = entry->m_object->GetPhysicsController();
+  return (ctrl && !ctrl->IsPhysicsSuspended());
+}
+
+void KX_SensorSpatialHash::Query(const MT_Vector3 &aabbMin,
+                                 const MT_Vector3 &aabbMax,
+                                 std::vector<Entry *> &entries)
+{
+  ++m_query;
+
+  const auto testEntry = [this, &aabbMin, &aabbMax, &entries](Entry *entry) {
+    if (entry->m_query != m_query &&
+        aabb_overlap(aabbMin, aabbMax, entry->m_aabbMin, entry->m_aabbMax) &&
+        is_entry_sensed(entry)) {
+      entry->m_query = m_query;
+      entries.push_back(entry);
+    }
+  };
+
+  int cellMin[3];
+  int cellMax[3];
+  GetCellRange(aabbMin, aabbMax, cellMin, cellMax);
+  const int64_t numCells = (int64_t)(cellMax[0] - cellMin[0] + 1) *
+                           (cellMax[1] - cellMin[1] + 1) * (cellMax[2] - cellMin[2] + 1);
+
+  if (numCells > (int64_t)m_entries.size()) {
+    // A query larger than the number of objects, test them all.
+    for (std::pair<KX_GameObject *const, Entry> &pair : m_entries) {
+      testEntry(&pair.second);
+    }
+    return;
+  }
+
+  for (int x = cellMin[0]; x <= cellMax[0]; ++x) {
+    for (int y = cellMin[1]; y <= cellMax[1]; ++y) {
+      for (int z = cellMin[2]; z <= cellMax[2]; ++z) {
+        std::unordered_map<uint64_t, std::vector<Entry *>>::iterator it = m_cells.find(
+            cell_key(x, y, z));
+        if (it != m_cells.end()) {
+          for (Entry *entry : it->second) {
+            testEntry(entry);
+          }
+        }
+      }
+    }
+  }
+
+  for (Entry *entry : m_largeEntries) {
+    testEntry(entry);
+  }
+}
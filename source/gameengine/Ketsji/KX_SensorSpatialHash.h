@@ -0,0 +1,106 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file KX_SensorSpatialHash.h
+ *  \ingroup ketsji
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "EXP_ListValue.h"
+#include "MT_Vector3.h"
+
+class KX_GameObject;
+
+/** Uniform grid of the bounding boxes of the actor objects, used by the Near and Radar
+ * sensors instead of their ghost objects in the physics broadphase. The grid is updated
+ * once per frame from the objects whose transform changed, only the objects changing of
+ * cells are moved.
+ */
+class KX_SensorSpatialHash {
+ public:
+  /// An actor object in the grid.
+  class Entry {
+   public:
+    KX_GameObject *m_object;
+    MT_Vector3 m_aabbMin;
+    MT_Vector3 m_aabbMax;
+
+   private:
+    friend class KX_SensorSpatialHash;
+
+    /// Range of cells covered by the bounding box.
+    int m_cellMin[3];
+    int m_cellMax[3];
+    /// True if the object covers too many cells and is tested by all the queries.
+    bool m_large;
+    /// Last query which returned this entry, to return it once per query.
+    unsigned int m_query;
+  };
+
+ private:
+  /// Size of a cell in world units.
+  float m_cellSize;
+
+  std::unordered_map<uint64_t, std::vector<Entry *>> m_cells;
+  std::unordered_map<KX_GameObject *, Entry> m_entries;
+  /// Entries too large to be inserted in the cells.
+  std::vector<Entry *> m_largeEntries;
+
+  /// Objects whose transform changed since the last update, filled by the scene.
+  std::unordered_set<KX_GameObject *> m_dirtyObjects;
+  /// False until all the objects of the scene were inserted once.
+  bool m_initialized;
+
+  unsigned int m_query;
+
+  void GetCellRange(const MT_Vector3 &aabbMin,
+                    const MT_Vector3 &aabbMax,
+                    int cellMin[3],
+                    int cellMax[3]) const;
+  void InsertEntry(Entry *entry);
+  void RemoveEntry(Entry *entry);
+  /// Add, move or remove the entry of an object from its current bounding box.
+  void UpdateObject(KX_GameObject *gameobj);
+
+ public:
+  KX_SensorSpatialHash(float cellSize);
+  ~KX_SensorSpatialHash();
+
+  /** Tag an object to update in the next Update, the caller must lock concurrent calls.
+   * Only the tagged objects are visited after the first update.
+   */
+  void AddDirtyObject(KX_GameObject *gameobj);
+  /// Remove an object deleted or moved to a pool, the object is not accessed.
+  void RemoveObject(KX_GameObject *gameobj);
+
+  /// Add, move and remove the tagged actor objects, all the objects at the first update.
+  void Update(EXP_ListValue<KX_GameObject> *objects);
+
+  /// Append the entries whose bounding box overlaps the bounding box of the query.
+  void Query(const MT_Vector3 &aabbMin, const MT_Vector3 &aabbMax, std::vector<Entry *> &entries);
+};
@@ -27,6 +27,12 @@
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_context.h"
+#include "BKE_mesh.h"
+#include "BLI_endian_defines.h"
+#include "BLI_fileops.h"
+#include "BLI_hash_md5.h"
+#include "BLI_path_util.h"
+#include "BLI_task.h"
 #include "DEG_depsgraph_query.h"
 #include "DNA_mesh_types.h"
 
@@ -36,8 +42,10 @@
 #include "BulletSoftBody/btSoftRigidDynamicsWorld.h"
 #include "LinearMath/btConvexHull.h"
 
+#include "CM_Message.h"
 #include "CcdPhysicsEnvironment.h"
 #include "KX_GameObject.h"
+#include "PHY_Snapshot.h"
 #include "RAS_DisplayArray.h"
 #include "RAS_MeshObject.h"
 #include "RAS_Polygon.h"
@@ -189,6 +197,8 @@ CcdPhysicsController::CcdPhysicsController(const CcdConstructionInfo &ci) : m_cc
 {
   m_prototypeTransformInitialized = false;
   m_softbodyMappingDone = false;
+  m_softBodyMesh = nullptr;
+  m_softBodyMeshTotVert = 0;
   m_newClientInfo = 0;
   m_registerCount = 0;
   m_softBodyTransformInitialized = false;
@@ -216,6 +226,11 @@ CcdPhysicsController::CcdPhysicsController(const CcdConstructionInfo &ci) : m_cc
   m_savedFriction = 0.0f;
   m_savedDyna = false;
   m_suspended = false;
+  m_envKind = 0;
+  m_envIndex = -1;
+  m_envFhIndex = -1;
+  m_envGImpact = false;
+  m_sleeping = false;
 
   CreateRigidbody();
 }
@@ -308,8 +323,14 @@ bool CcdPhysicsController::CreateSoftbody()
     return false;
   }
 
+  btSoftRigidDynamicsWorld *softBodyWorld = m_cci.m_physicsEnv->GetSoftBodyWorld();
+  // The multithreaded world doesn't support soft bodies, a rigid body is created instead.
+  if (!softBodyWorld) {
+    return false;
+  }
+
   btSoftBody *psb = nullptr;
-  btSoftBodyWorldInfo &worldInfo = m_cci.m_physicsEnv->GetDynamicsWorld()->getWorldInfo();
+  btSoftBodyWorldInfo &worldInfo = softBodyWorld->getWorldInfo();
 
   if (m_cci.m_collisionShape->getShapeType() ==
       CONVEX_HULL_SHAPE_PROXYTYPE) {  // Disabled in upbge 0.3
@@ -530,6 +551,11 @@ bool CcdPhysicsController::CreateSoftbody()
   }
   m_softbodyMappingDone = true;
 
+  RAS_MeshObject *rasMesh = GetShapeInfo()->GetMesh();
+  if (rasMesh) {
+    CreateSoftBodyMeshMapping(rasMesh->GetOrigMesh());
+  }
+
   btTransform startTrans;
   m_bulletMotionState->getWorldTransform(startTrans);
 
@@ -642,6 +668,15 @@ MT_Vector3 CcdPhysicsController::GetGravity()
   return gravity;
 }
 
+void CcdPhysicsController::GetAabb(MT_Vector3 &aabbMin, MT_Vector3 &aabbMax)
+{
+  btVector3 minAabb;
+  btVector3 maxAabb;
+  m_object->getCollisionShape()->getAabb(m_object->getWorldTransform(), minAabb, maxAabb);
+  aabbMin = ToMoto(minAabb);
+  aabbMax = ToMoto(maxAabb);
+}
+
 void CcdPhysicsController::SetGravity(const MT_Vector3 &gravity)
 {
   btRigidBody *body = GetRigidBody();
@@ -701,7 +736,7 @@ bool CcdPhysicsController::ReplaceControllerShape(btCollisionShape *newShape)
 
   btSoftBody *softBody = GetSoftBody();
   if (softBody) {
-    btSoftRigidDynamicsWorld *world = GetPhysicsEnvironment()->GetDynamicsWorld();
+    btSoftRigidDynamicsWorld *world = GetPhysicsEnvironment()->GetSoftBodyWorld();
     // remove the old softBody
     world->removeSoftBody(softBody);
 
@@ -821,6 +856,14 @@ bool CcdPhysicsController::SynchronizeMotionStates(float time)
   btRigidBody *body = GetRigidBody();
 
   if (body && !body->isStaticObject()) {
+    /* A sleeping body doesn't move, its transform was synchronized when it fell asleep.
+     * Its node then stays out of the scene graph and depsgraph updates until it wakes up. */
+    const bool sleeping = !body->isActive();
+    if (sleeping && m_sleeping) {
+      return true;
+    }
+    m_sleeping = sleeping;
+
     const btTransform &xform = body->getCenterOfMassTransform();
     const btMatrix3x3 &worldOri = xform.getBasis();
     const btVector3 &worldPos = xform.getOrigin();
@@ -835,83 +878,112 @@ bool CcdPhysicsController::SynchronizeMotionStates(float time)
   return true;
 }
 
-void CcdPhysicsController::UpdateSoftBody()
+void CcdPhysicsController::CreateSoftBodyMeshMapping(Mesh *me)
 {
-  btSoftBody *sb = GetSoftBody();
-  if (sb) {
-    if (sb->m_pose.m_bframe || sb->m_pose.m_bvolume) {
+  m_softBodyMeshVertices.clear();
+  m_softBodyMesh = me;
+  m_softBodyMeshTotVert = me->totvert;
 
-      RAS_MeshObject *rasMesh = GetShapeInfo()->GetMesh();
+  RAS_MeshObject *rasMesh = GetShapeInfo()->GetMesh();
 
-      if (rasMesh) {
-        // Get other mesh data
-        Mesh *me = rasMesh->GetOrigMesh();
-        // I don't see how we could do without DerivedMesh...
-        DerivedMesh *dm = CDDM_from_mesh(me);
+  // The tessellation is only needed to find the soft body node of each mesh vertex.
+  DerivedMesh *dm = CDDM_from_mesh(me);
 
-        // Some meshes with modifiers returns 0 polys, call DM_ensure_tessface avoid this.
-        DM_ensure_tessface(dm);
+  // Some meshes with modifiers returns 0 polys, call DM_ensure_tessface avoid this.
+  DM_ensure_tessface(dm);
 
-        const int *index_mf_to_mpoly = (const int *)dm->getTessFaceDataArray(dm, CD_ORIGINDEX);
-        const int *index_mp_to_orig = (const int *)dm->getPolyDataArray(dm, CD_ORIGINDEX);
-        if (!index_mf_to_mpoly) {
-          index_mp_to_orig = nullptr;
-        }
+  const int *index_mf_to_mpoly = (const int *)dm->getTessFaceDataArray(dm, CD_ORIGINDEX);
+  const int *index_mp_to_orig = (const int *)dm->getPolyDataArray(dm, CD_ORIGINDEX);
+  if (!index_mf_to_mpoly) {
+    index_mp_to_orig = nullptr;
+  }
 
-        MVert *mverts = dm->getVertArray(dm);
-        MFace *mface = dm->getTessFaceArray(dm);
-        int numpolys = dm->getNumTessFaces(dm);
+  MFace *mface = dm->getTessFaceArray(dm);
+  const int numpolys = dm->getNumTessFaces(dm);
+  const int numnodes = GetSoftBody()->m_nodes.size();
+
+  // Soft body node of each mesh vertex, the last polygon using a vertex sets its node.
+  std::vector<int> vertexNodes(me->totvert, -1);
+
+  for (int p2 = 0; p2 < numpolys; p2++) {
+    MFace *mf = &mface[p2];
+    const int origi = index_mf_to_mpoly ?
+                          DM_origindex_mface_mpoly(index_mf_to_mpoly, index_mp_to_orig, p2) :
+                          p2;
+    RAS_Polygon *poly = (origi != ORIGINDEX_NONE) ? rasMesh->GetPolygon(origi) : nullptr;
+
+    // only add polygons that have the collisionflag set
+    if (poly) {
+      const unsigned int verts[4] = {mf->v1, mf->v2, mf->v3, mf->v4};
+      for (unsigned short i = 0, size = (mf->v4 ? 4 : 3); i < size; ++i) {
+        const int node = poly->GetVertexInfo(i).getSoftBodyIndex();
+        if (node >= 0 && node < numnodes) {
+          vertexNodes[verts[i]] = node;
+        }
+      }
+    }
+  }
 
-        btSoftBody::tNodeArray &nodes(sb->m_nodes);
-        bContext *C = KX_GetActiveEngine()->GetContext();
-        Depsgraph *depsgraph = CTX_data_depsgraph_on_load(C);
-        KX_GameObject *gameobj = KX_GameObject::GetClientObject(
-            (KX_ClientObjectInfo *)GetNewClientInfo());
-        Object *ob = DEG_get_evaluated_object(depsgraph, gameobj->GetBlenderObject());
+  dm->release(dm);
 
-        for (int p2 = 0; p2 < numpolys; p2++) {
-          MFace *mf = &mface[p2];
-          const int origi = index_mf_to_mpoly ?
-                                DM_origindex_mface_mpoly(index_mf_to_mpoly, index_mp_to_orig, p2) :
-                                p2;
-          RAS_Polygon *poly = (origi != ORIGINDEX_NONE) ? rasMesh->GetPolygon(origi) : nullptr;
+  for (int i = 0; i < me->totvert; ++i) {
+    if (vertexNodes[i] != -1) {
+      m_softBodyMeshVertices.emplace_back(i, vertexNodes[i]);
+    }
+  }
+}
 
-          // only add polygons that have the collisionflag set
-          if (poly) {
-            MVert *v1 = &mverts[mf->v1];
-            MVert *v2 = &mverts[mf->v2];
-            MVert *v3 = &mverts[mf->v3];
+struct SoftBodyMeshSyncData {
+  const std::pair<unsigned int, unsigned int> *meshVertices;
+  const btSoftBody::tNodeArray *nodes;
+  btVector3 com;
+  MVert *mverts;
+};
 
-            int i1 = poly->GetVertexInfo(0).getSoftBodyIndex();
-            int i2 = poly->GetVertexInfo(1).getSoftBodyIndex();
-            int i3 = poly->GetVertexInfo(2).getSoftBodyIndex();
+static void soft_body_mesh_sync_func(void *__restrict userdata,
+                                     const int iter,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SoftBodyMeshSyncData *data = (SoftBodyMeshSyncData *)userdata;
+  const std::pair<unsigned int, unsigned int> &pair = data->meshVertices[iter];
+  const btVector3 co = (*data->nodes)[pair.second].m_x - data->com;
 
-            MT_Vector3 p1 = ToMoto(nodes.at(i1).m_x - sb->m_pose.m_com);
-            MT_Vector3 p2 = ToMoto(nodes.at(i2).m_x - sb->m_pose.m_com);
-            MT_Vector3 p3 = ToMoto(nodes.at(i3).m_x - sb->m_pose.m_com);
+  // Do we need object_to_world? maybe
+  MVert *mvert = &data->mverts[pair.first];
+  mvert->co[0] = co.x();
+  mvert->co[1] = co.y();
+  mvert->co[2] = co.z();
+}
 
-            // Do we need object_to_world? maybe
-            copy_v3_v3(v1->co, p1.getValue());
-            copy_v3_v3(v2->co, p2.getValue());
-            copy_v3_v3(v3->co, p3.getValue());
+void CcdPhysicsController::UpdateSoftBody()
+{
+  btSoftBody *sb = GetSoftBody();
+  if (sb) {
+    if (sb->m_pose.m_bframe || sb->m_pose.m_bvolume) {
 
-            if (mf->v4) {
-              MVert *v4 = &mverts[mf->v4];
+      RAS_MeshObject *rasMesh = GetShapeInfo()->GetMesh();
 
-              int i4 = poly->GetVertexInfo(3).getSoftBodyIndex();
+      if (rasMesh) {
+        Mesh *me = rasMesh->GetOrigMesh();
+        // The mapping is only rebuilt if the mesh changed since the soft body creation.
+        if (me != m_softBodyMesh || me->totvert != m_softBodyMeshTotVert) {
+          CreateSoftBodyMeshMapping(me);
+        }
 
-              MT_Vector3 p4 = ToMoto(nodes.at(i4).m_x - sb->m_pose.m_com);
+        SoftBodyMeshSyncData data;
+        data.meshVertices = m_softBodyMeshVertices.data();
+        data.nodes = &sb->m_nodes;
+        data.com = sb->m_pose.m_com;
+        data.mverts = BKE_mesh_verts_for_write(me);
 
-              copy_v3_v3(v4->co, p4.getValue());
+        const int size = m_softBodyMeshVertices.size();
+        TaskParallelSettings settings;
+        BLI_parallel_range_settings_defaults(&settings);
+        // Only large cloth meshes are worth the thread synchronization.
+        settings.min_iter_per_thread = 1024;
+        settings.use_threading = (size > settings.min_iter_per_thread);
+        BLI_task_parallel_range(0, size, &data, soft_body_mesh_sync_func, &settings);
 
-            }
-          }
-        }
-        DM_to_mesh(dm,
-                   me,
-                   gameobj->GetBlenderObject(),
-                   &CD_MASK_MESH,
-                   true);  // if take_ownership is true, dm is freed
         DEG_id_tag_update(&me->id, ID_RECALC_GEOMETRY);
       }
     }
@@ -947,6 +1019,10 @@ void CcdPhysicsController::PostProcessReplica(class PHY_IMotionState *motionstat
   m_softBodyTransformInitialized = false;
   m_MotionState = motionstate;
   m_registerCount = 0;
+  m_envIndex = -1;
+  m_envFhIndex = -1;
+  m_envGImpact = false;
+  m_sleeping = false;
   m_collisionShape = nullptr;
 
   // Clear all old constraints.
@@ -1159,7 +1235,7 @@ void CcdPhysicsController::RefreshCollisions()
   if (IsPhysicsSuspended())
     return;
 
-  btSoftRigidDynamicsWorld *dw = GetPhysicsEnvironment()->GetDynamicsWorld();
+  btDiscreteDynamicsWorld *dw = GetPhysicsEnvironment()->GetDynamicsWorld();
   btBroadphaseProxy *proxy = m_object->getBroadphaseHandle();
   btDispatcher *dispatcher = dw->getDispatcher();
   btOverlappingPairCache *pairCache = dw->getPairCache();
@@ -1264,6 +1340,14 @@ void CcdPhysicsController::SetTransform()
   const MT_Matrix3x3 rot = m_MotionState->GetWorldOrientation();
   ForceWorldTransform(ToBullet(rot), ToBullet(pos));
 
+  /* The static controllers are not synchronized at each step by the physics environment,
+   * apply the world scale here when it changed. */
+  const btVector3 scale = ToBullet(m_MotionState->GetWorldScaling());
+  btCollisionShape *shape = GetCollisionShape();
+  if (shape && shape->getLocalScaling() != scale) {
+    shape->setLocalScaling(scale);
+  }
+
   if (!IsDynamic() && !GetConstructionInfo().m_bSensor && !GetCharacterController()) {
     btCollisionObject *object = GetRigidBody();
     object->setActivationState(ACTIVE_TAG);
@@ -1577,6 +1661,142 @@ void CcdPhysicsController::SetCcdSweptSphereRadius(float ccd_swept_sphere_radius
   body->setCcdSweptSphereRadius(ccd_swept_sphere_radius);
 }
 
+/// Simulation state of a collision object in a snapshot.
+struct CcdCollisionObjectState {
+  btTransform m_worldTransform;
+  btTransform m_interpolationWorldTransform;
+  btVector3 m_interpolationLinearVelocity;
+  btVector3 m_interpolationAngularVelocity;
+  btScalar m_deactivationTime;
+  btScalar m_hitFraction;
+  int m_activationState;
+  /// Type of the collision object, checked to not restore the state in another controller.
+  int m_internalType;
+};
+
+/// Simulation state of a rigid body, following the state of its collision object.
+struct CcdRigidBodyState {
+  btVector3 m_linearVelocity;
+  btVector3 m_angularVelocity;
+  btVector3 m_gravity;
+};
+
+void CcdPhysicsController::SaveState(PHY_SnapshotWriter &writer)
+{
+  CcdCollisionObjectState state;
+  state.m_worldTransform = m_object->getWorldTransform();
+  state.m_interpolationWorldTransform = m_object->getInterpolationWorldTransform();
+  state.m_interpolationLinearVelocity = m_object->getInterpolationLinearVelocity();
+  state.m_interpolationAngularVelocity = m_object->getInterpolationAngularVelocity();
+  state.m_deactivationTime = m_object->getDeactivationTime();
+  state.m_hitFraction = m_object->getHitFraction();
+  state.m_activationState = m_object->getActivationState();
+  state.m_internalType = m_object->getInternalType();
+  writer.Write(state);
+
+  btRigidBody *body = GetRigidBody();
+  if (body) {
+    CcdRigidBodyState bodyState;
+    bodyState.m_linearVelocity = body->getLinearVelocity();
+    bodyState.m_angularVelocity = body->getAngularVelocity();
+    bodyState.m_gravity = body->getGravity();
+    writer.Write(bodyState);
+  }
+
+  btSoftBody *sb = GetSoftBody();
+  if (sb) {
+    const int numNodes = sb->m_nodes.size();
+    writer.Write(numNodes);
+    for (int i = 0; i < numNodes; ++i) {
+      const btSoftBody::Node &node = sb->m_nodes[i];
+      writer.Write(node.m_x);
+      writer.Write(node.m_q);
+      writer.Write(node.m_v);
+    }
+  }
+}
+
+class CcdPhysicsController::SnapshotState : public PHY_ISnapshotState {
+ public:
+  CcdPhysicsController *m_ctrl;
+  CcdCollisionObjectState m_state;
+  CcdRigidBodyState m_bodyState;
+  /// Position, previous position and velocity of the soft body nodes.
+  std::vector<btVector3> m_nodes;
+
+  SnapshotState(CcdPhysicsController *ctrl) : m_ctrl(ctrl)
+  {
+  }
+
+  virtual void Apply()
+  {
+    btCollisionObject *object = m_ctrl->m_object;
+
+    btSoftBody *sb = m_ctrl->GetSoftBody();
+    if (sb) {
+      for (int i = 0, size = sb->m_nodes.size(); i < size; ++i) {
+        btSoftBody::Node &node = sb->m_nodes[i];
+        node.m_x = m_nodes[i * 3];
+        node.m_q = m_nodes[i * 3 + 1];
+        node.m_v = m_nodes[i * 3 + 2];
+      }
+      sb->updateBounds();
+    }
+
+    object->setWorldTransform(m_state.m_worldTransform);
+    object->setInterpolationWorldTransform(m_state.m_interpolationWorldTransform);
+    object->setInterpolationLinearVelocity(m_state.m_interpolationLinearVelocity);
+    object->setInterpolationAngularVelocity(m_state.m_interpolationAngularVelocity);
+    object->setDeactivationTime(m_state.m_deactivationTime);
+    object->setHitFraction(m_state.m_hitFraction);
+    object->forceActivationState(m_state.m_activationState);
+    // Synchronize the restored transform even if the body sleeps.
+    m_ctrl->m_sleeping = false;
+
+    btRigidBody *body = m_ctrl->GetRigidBody();
+    if (body) {
+      body->setLinearVelocity(m_bodyState.m_linearVelocity);
+      body->setAngularVelocity(m_bodyState.m_angularVelocity);
+      body->setGravity(m_bodyState.m_gravity);
+      body->clearForces();
+    }
+  }
+};
+
+PHY_ISnapshotState *CcdPhysicsController::ReadState(PHY_SnapshotReader &reader)
+{
+  SnapshotState *state = new SnapshotState(this);
+  if (!reader.Read(state->m_state) ||
+      state->m_state.m_internalType != m_object->getInternalType()) {
+    delete state;
+    return nullptr;
+  }
+
+  btRigidBody *body = GetRigidBody();
+  if (body && !reader.Read(state->m_bodyState)) {
+    delete state;
+    return nullptr;
+  }
+
+  btSoftBody *sb = GetSoftBody();
+  if (sb) {
+    int numNodes;
+    if (!reader.Read(numNodes) || numNodes != sb->m_nodes.size()) {
+      delete state;
+      return nullptr;
+    }
+    state->m_nodes.resize(numNodes * 3);
+    for (btVector3 &value : state->m_nodes) {
+      if (!reader.Read(value)) {
+        delete state;
+        return nullptr;
+      }
+    }
+  }
+
+  return state;
+}
+
 // reading out information from physics
 MT_Vector3 CcdPhysicsController::GetLinearVelocity()
 {
@@ -2014,6 +2234,8 @@ void CcdShapeConstructionInfo::ProcessReplica()
   m_triangleIndexVertexArray = nullptr;
   m_forceReInstance = false;
   m_shapeProxy = nullptr;
+  m_bvhBuffer = nullptr;
+  m_cachedBvh = nullptr;
   m_vertexArray.clear();
   m_polygonIndexArray.clear();
   m_triFaceArray.clear();
@@ -2774,6 +2996,9 @@ btCollisionShape *CcdShapeConstructionInfo::CreateBulletShape(btScalar margin,
       }
       else {
         if (!m_triangleIndexVertexArray || m_forceReInstance) {
+          // The cached BVH was built for the previous triangles.
+          FreeCachedBvh();
+
           /// enable welding, only for the objects that need it (such as soft bodies)
           if (0.0f != m_weldingThreshold1) {
             btTriangleMesh *collisionMeshData = new btTriangleMesh(true, false);
@@ -2806,8 +3031,19 @@ btCollisionShape *CcdShapeConstructionInfo::CreateBulletShape(btScalar margin,
           m_forceReInstance = false;
         }
 
-        btBvhTriangleMeshShape *unscaledShape = new btBvhTriangleMeshShape(
-            m_triangleIndexVertexArray, true, useBvh);
+        const bool useBvhCache = useBvh && !m_bvhCacheDirectory.empty();
+        btOptimizedBvh *cachedBvh = (useBvhCache) ? LoadCachedBvh() : nullptr;
+        btBvhTriangleMeshShape *unscaledShape;
+        if (cachedBvh) {
+          unscaledShape = new btBvhTriangleMeshShape(m_triangleIndexVertexArray, true, false);
+          unscaledShape->setOptimizedBvh(cachedBvh);
+        }
+        else {
+          unscaledShape = new btBvhTriangleMeshShape(m_triangleIndexVertexArray, true, useBvh);
+          if (useBvhCache) {
+            SaveCachedBvh(unscaledShape->getOptimizedBvh());
+          }
+        }
         unscaledShape->setMargin(margin);
         collisionShape = new btScaledBvhTriangleMeshShape(unscaledShape,
                                                           btVector3(1.0f, 1.0f, 1.0f));
@@ -2840,6 +3076,187 @@ btCollisionShape *CcdShapeConstructionInfo::CreateBulletShape(btScalar margin,
   return collisionShape;
 }
 
+/// Header written before the serialized tree in a BVH cache file.
+struct CcdBvhCacheHeader {
+  char magic[8];
+  int version;
+  unsigned int size;
+  /// Hash of the mesh data and Bullet layout the tree was built for.
+  char contentHash[16];
+  /// Hash of the serialized tree following the header.
+  char checksum[16];
+};
+
+static const char bvhCacheMagic[8] = {'B', 'G', 'E', 'B', 'V', 'H', '\0', '\0'};
+/// Increase when the content of the cache files changes.
+static const int bvhCacheVersion = 1;
+
+void CcdShapeConstructionInfo::GetBvhCacheHash(char hash[16]) const
+{
+  /* The serialized tree depends on the triangles and on the layout of the Bullet
+   * structures, hash both to never load a tree built for another mesh or build. */
+  const int layout[] = {
+      BT_BULLET_VERSION, (int)sizeof(btScalar), (int)sizeof(void *), ENDIAN_ORDER};
+  std::vector<char> digests((const char *)layout, (const char *)layout + sizeof(layout));
+
+  for (int part = 0, numParts = m_triangleIndexVertexArray->getNumSubParts(); part < numParts;
+       ++part) {
+    const unsigned char *vertexBase;
+    const unsigned char *indexBase;
+    int numVerts, vertexStride, indexStride, numFaces;
+    PHY_ScalarType vertexType, indexType;
+    m_triangleIndexVertexArray->getLockedReadOnlyVertexIndexBase(&vertexBase,
+                                                                 numVerts,
+                                                                 vertexType,
+                                                                 vertexStride,
+                                                                 &indexBase,
+                                                                 indexStride,
+                                                                 numFaces,
+                                                                 indexType,
+                                                                 part);
+
+    char digest[16];
+    BLI_hash_md5_buffer((const char *)vertexBase, (size_t)numVerts * vertexStride, digest);
+    digests.insert(digests.end(), digest, digest + sizeof(digest));
+    BLI_hash_md5_buffer((const char *)indexBase, (size_t)numFaces * indexStride, digest);
+    digests.insert(digests.end(), digest, digest + sizeof(digest));
+
+    m_triangleIndexVertexArray->unLockReadOnlyVertexBase(part);
+  }
+
+  BLI_hash_md5_buffer(digests.data(), digests.size(), hash);
+}
+
+std::string CcdShapeConstructionInfo::GetBvhCachePath(const char hash[16]) const
+{
+  char hexDigest[33];
+  BLI_hash_md5_to_hexdigest((void *)hash, hexDigest);
+
+  char path[FILE_MAX];
+  const std::string filename = std::string(hexDigest) + ".bvh";
+  BLI_path_join(path, sizeof(path), m_bvhCacheDirectory.c_str(), filename.c_str());
+
+  return path;
+}
+
+btOptimizedBvh *CcdShapeConstructionInfo::LoadCachedBvh()
+{
+  if (m_cachedBvh) {
+    return m_cachedBvh;
+  }
+
+  char hash[16];
+  GetBvhCacheHash(hash);
+  const std::string path = GetBvhCachePath(hash);
+  const size_t fileSize = BLI_file_size(path.c_str());
+  if (fileSize == (size_t)-1 || fileSize == 0) {
+    return nullptr;
+  }
+
+  FILE *file = BLI_fopen(path.c_str(), "rb");
+  if (!file) {
+    return nullptr;
+  }
+
+  /* Validate the whole file before deserializing: the tree is patched in place and an
+   * altered file would produce invalid node offsets. */
+  CcdBvhCacheHeader header;
+  bool valid = (fileSize > sizeof(header) && fread(&header, sizeof(header), 1, file) == 1 &&
+                memcmp(header.magic, bvhCacheMagic, sizeof(bvhCacheMagic)) == 0 &&
+                header.version == bvhCacheVersion && header.size == fileSize - sizeof(header) &&
+                memcmp(header.contentHash, hash, sizeof(hash)) == 0);
+
+  // The tree is patched in place by the deserialization and requires an aligned buffer.
+  void *buffer = nullptr;
+  if (valid) {
+    buffer = btAlignedAlloc(header.size, 16);
+    valid = (fread(buffer, 1, header.size, file) == header.size);
+  }
+  fclose(file);
+
+  if (valid) {
+    char checksum[16];
+    BLI_hash_md5_buffer((const char *)buffer, header.size, checksum);
+    valid = (memcmp(header.checksum, checksum, sizeof(checksum)) == 0);
+  }
+
+  btOptimizedBvh *bvh = (valid) ? btOptimizedBvh::deSerializeInPlace(buffer, header.size, false) :
+                                  nullptr;
+  if (!bvh) {
+    CM_Warning("invalid BVH cache file \"" << path << "\", rebuilding it");
+    if (buffer) {
+      btAlignedFree(buffer);
+    }
+    // Remove the file, it is rewritten once the tree is rebuilt.
+    BLI_delete(path.c_str(), false, false);
+    return nullptr;
+  }
+
+  m_bvhBuffer = buffer;
+  m_cachedBvh = bvh;
+
+  return m_cachedBvh;
+}
+
+void CcdShapeConstructionInfo::SaveCachedBvh(btOptimizedBvh *bvh)
+{
+  const unsigned int size = bvh->calculateSerializeBufferSize();
+  void *buffer = btAlignedAlloc(size, 16);
+  if (!bvh->serializeInPlace(buffer, size, false)) {
+    btAlignedFree(buffer);
+    return;
+  }
+
+  CcdBvhCacheHeader header;
+  memcpy(header.magic, bvhCacheMagic, sizeof(bvhCacheMagic));
+  header.version = bvhCacheVersion;
+  header.size = size;
+  GetBvhCacheHash(header.contentHash);
+  BLI_hash_md5_buffer((const char *)buffer, size, header.checksum);
+
+  const std::string path = GetBvhCachePath(header.contentHash);
+  // Write in a temporary file first to never leave a truncated cache file.
+  const std::string tmpPath = path + ".tmp";
+  FILE *file = nullptr;
+  if (BLI_dir_create_recursive(m_bvhCacheDirectory.c_str())) {
+    file = BLI_fopen(tmpPath.c_str(), "wb");
+  }
+
+  if (file) {
+    const bool written = (fwrite(&header, sizeof(header), 1, file) == 1 &&
+                          fwrite(buffer, 1, size, file) == size);
+    fclose(file);
+    if (!written || BLI_rename(tmpPath.c_str(), path.c_str()) != 0) {
+      BLI_delete(tmpPath.c_str(), false, false);
+      file = nullptr;
+    }
+  }
+
+  if (!file) {
+    CM_Warning("failed to write BVH cache file \"" << path << "\"");
+  }
+
+  // Share the serialized copy of the tree with the next shapes using this mesh.
+  m_cachedBvh = btOptimizedBvh::deSerializeInPlace(buffer, size, false);
+  if (m_cachedBvh) {
+    m_bvhBuffer = buffer;
+  }
+  else {
+    btAlignedFree(buffer);
+  }
+}
+
+void CcdShapeConstructionInfo::FreeCachedBvh()
+{
+  if (m_bvhBuffer) {
+    // The tree was constructed in place in the buffer, only its destructor must be called.
+    m_cachedBvh->~btOptimizedBvh();
+    btAlignedFree(m_bvhBuffer);
+    m_bvhBuffer = nullptr;
+    m_cachedBvh = nullptr;
+  }
+}
+
 void CcdShapeConstructionInfo::AddShape(CcdShapeConstructionInfo *shapeInfo)
 {
   m_shapeArray.push_back(shapeInfo);
@@ -2853,6 +3270,7 @@ CcdShapeConstructionInfo::~CcdShapeConstructionInfo()
   }
   m_shapeArray.clear();
 
+  FreeCachedBvh();
   if (m_triangleIndexVertexArray)
     delete m_triangleIndexVertexArray;
   m_vertexArray.clear();
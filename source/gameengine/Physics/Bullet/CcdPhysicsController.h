@@ -23,6 +23,7 @@
 #pragma once
 
 #include <map>
+#include <string>
 #include <vector>
 
 ///	PHY_IPhysicsController is the abstract simplified Interface to a physical object.
@@ -46,6 +47,7 @@ class CcdPhysicsController;
 class btMotionState;
 class RAS_MeshObject;
 struct DerivedMesh;
+struct Mesh;
 class btCollisionShape;
 
 #define CCD_BSB_SHAPE_MATCHING 2
@@ -82,7 +84,9 @@ class CcdShapeConstructionInfo : public CM_RefCount<CcdShapeConstructionInfo> {
         m_triangleIndexVertexArray(nullptr),
         m_forceReInstance(false),
         m_weldingThreshold1(0.0f),
-        m_shapeProxy(nullptr)
+        m_shapeProxy(nullptr),
+        m_bvhBuffer(nullptr),
+        m_cachedBvh(nullptr)
   {
     m_childTrans.setIdentity();
   }
@@ -190,7 +194,27 @@ class CcdShapeConstructionInfo : public CM_RefCount<CcdShapeConstructionInfo> {
     m_weldingThreshold1 = threshold * threshold;
   }
 
+  /** Set the directory caching the BVH of the triangle mesh shape between runs,
+   * an empty directory disables the cache.
+   */
+  void SetBvhCacheDirectory(const std::string &directory)
+  {
+    m_bvhCacheDirectory = directory;
+  }
+
  protected:
+  /// Compute the hash of the triangle mesh data identifying its cached BVH.
+  void GetBvhCacheHash(char hash[16]) const;
+  /// Return the file caching the BVH of the triangle mesh, named after its hash.
+  std::string GetBvhCachePath(const char hash[16]) const;
+  /** Return the BVH shared by the triangle mesh shapes, loaded from the disk cache if present.
+   * The cache file is checked against its header and removed if invalid.
+   */
+  btOptimizedBvh *LoadCachedBvh();
+  /// Write the BVH in the disk cache and keep a copy shared by the next triangle mesh shapes.
+  void SaveCachedBvh(btOptimizedBvh *bvh);
+  void FreeCachedBvh();
+
   static std::map<RAS_MeshObject *, CcdShapeConstructionInfo *> m_meshShapeMap;
   /// Keep a pointer to the original mesh
   RAS_MeshObject *m_meshObject;
@@ -204,6 +228,12 @@ class CcdShapeConstructionInfo : public CM_RefCount<CcdShapeConstructionInfo> {
   float m_weldingThreshold1;
   /// only used for PHY_SHAPE_PROXY, pointer to actual shape info
   CcdShapeConstructionInfo *m_shapeProxy;
+  /// Directory of the BVH disk cache, empty when disabled.
+  std::string m_bvhCacheDirectory;
+  /// Aligned memory holding the serialized BVH, btOptimizedBvh::deSerializeInPlace uses it as is.
+  void *m_bvhBuffer;
+  /// BVH living in m_bvhBuffer, not owned by the triangle mesh shapes using it.
+  btOptimizedBvh *m_cachedBvh;
 };
 
 struct CcdConstructionInfo {
@@ -560,6 +590,10 @@ class CleanPairCallback : public btOverlapCallback {
 /// CcdPhysicsController is a physics object that supports continuous collision detection and time
 /// of impact based physics resolution.
 class CcdPhysicsController : public PHY_IPhysicsController {
+ private:
+  /// Simulation state read from a snapshot.
+  class SnapshotState;
+
  protected:
   btCollisionObject *m_object;
   CcdCharacter *m_characterController;
@@ -581,6 +615,14 @@ class CcdPhysicsController : public PHY_IPhysicsController {
   bool m_prototypeTransformInitialized;
   btTransform m_softbodyStartTrans;
 
+  /** Pairs of mesh vertex and soft body node indices, used to write the soft body nodes
+   * in the mesh without tessellating it at each frame.
+   */
+  std::vector<std::pair<unsigned int, unsigned int>> m_softBodyMeshVertices;
+  /// Mesh and its number of vertices used to build m_softBodyMeshVertices.
+  Mesh *m_softBodyMesh;
+  int m_softBodyMeshTotVert;
+
   void *m_newClientInfo;
   int m_registerCount;        // needed when multiple sensors use the same controller
   CcdConstructionInfo m_cci;  // needed for replication
@@ -595,10 +637,22 @@ class CcdPhysicsController : public PHY_IPhysicsController {
   bool m_savedDyna;
   bool m_suspended;
 
+  /// Kind and index of the controller in the arrays of the physics environment, -1 when removed.
+  int m_envKind;
+  int m_envIndex;
+  /// Index of the controller in the Fh spring array of the physics environment, -1 if none.
+  int m_envFhIndex;
+  /// The controller is counted in the GImpact controllers of the physics environment.
+  bool m_envGImpact;
+  /// The body sleeps and its last transform was synchronized to the motion state.
+  bool m_sleeping;
+
   void GetWorldOrientation(btMatrix3x3 &mat);
 
   void CreateRigidbody();
   bool CreateSoftbody();
+  /// Build the mapping between the mesh vertices and the soft body nodes.
+  void CreateSoftBodyMeshMapping(Mesh *me);
   bool CreateCharacterController();
 
   bool Register()
@@ -739,6 +793,7 @@ class CcdPhysicsController : public PHY_IPhysicsController {
   virtual MT_Vector3 GetVelocity(const MT_Vector3 &posin);
   virtual MT_Vector3 GetLocalInertia();
   virtual MT_Vector3 GetGravity();
+  virtual void GetAabb(MT_Vector3 &aabbMin, MT_Vector3 &aabbMax);
 
   // dyna's that are rigidbody are free in orientation, dyna's with non-rigidbody are restricted
   virtual void SetRigidBody(bool rigid);
@@ -879,6 +934,11 @@ class CcdPhysicsController : public PHY_IPhysicsController {
 
   virtual bool IsPhysicsSuspended();
 
+  virtual bool IsSleeping() const
+  {
+    return m_sleeping;
+  }
+
   virtual bool IsCompound()
   {
     return GetConstructionInfo().m_shapeInfo->m_shapeType == PHY_SHAPE_COMPOUND;
@@ -897,6 +957,9 @@ class CcdPhysicsController : public PHY_IPhysicsController {
   // CCD methods
   virtual void SetCcdMotionThreshold(float val);
   virtual void SetCcdSweptSphereRadius(float val);
+
+  virtual void SaveState(PHY_SnapshotWriter &writer);
+  virtual PHY_ISnapshotState *ReadState(PHY_SnapshotReader &reader);
 };
 
 /// DefaultMotionState implements standard motionstate, using btTransform
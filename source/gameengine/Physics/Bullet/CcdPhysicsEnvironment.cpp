@@ -21,14 +21,19 @@
 
 #include "CcdPhysicsEnvironment.h"
 
+#include "BKE_appdir.h"
+#include "BKE_collection.h"
 #include "BKE_object.h"
+#include "BLI_path_util.h"
 #include "DNA_object_force_types.h"
 #include "DNA_scene_types.h"
 
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
 #include "BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h"
 #include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 #include "BulletDynamics/ConstraintSolver/btNNCGConstraintSolver.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
 #include "BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h"
 #include "BulletSoftBody/btSoftRigidDynamicsWorld.h"
 
@@ -36,9 +41,12 @@
 #include "CM_List.h"
 #include "CcdConstraint.h"
 #include "CcdGraphicController.h"
+#include "CcdTaskScheduler.h"
 #include "KX_GameObject.h"
+#include "KX_Globals.h"
 #include "MT_MinMax.h"
 #include "PHY_IVehicle.h"
+#include "PHY_Snapshot.h"
 #include "RAS_IVertex.h"
 #include "RAS_MeshObject.h"
 #include "RAS_Polygon.h"
@@ -342,6 +350,17 @@ class WrapperVehicle : public PHY_IVehicle {
   }
 };
 
+/** Multithreaded dispatcher with manifold batches for all the threads the scheduler can use,
+ * the number of used threads can be raised after the dispatcher is created.
+ */
+class CcdCollisionDispatcherMt : public btCollisionDispatcherMt {
+ public:
+  CcdCollisionDispatcherMt(btCollisionConfiguration *config) : btCollisionDispatcherMt(config)
+  {
+    m_batchManifoldsPtr.resize(CcdTaskScheduler::Get()->getMaxNumThreads());
+  }
+};
+
 class CcdOverlapFilterCallBack : public btOverlapFilterCallback {
  private:
   class CcdPhysicsEnvironment *m_physEnv;
@@ -364,7 +383,9 @@ void CcdPhysicsEnvironment::SetDebugDrawer(btIDebugDraw *debugDrawer)
   m_debugDrawer = debugDrawer;
 }
 
-CcdPhysicsEnvironment::CcdPhysicsEnvironment(PHY_SolverType solverType, bool useDbvtCulling)
+CcdPhysicsEnvironment::CcdPhysicsEnvironment(PHY_SolverType solverType,
+                                             bool useDbvtCulling,
+                                             bool useThreads)
     : m_cullingCache(nullptr),
       m_cullingTree(nullptr),
       m_numIterations(10),
@@ -374,6 +395,13 @@ CcdPhysicsEnvironment::CcdPhysicsEnvironment(PHY_SolverType solverType, bool use
       m_linearDeactivationThreshold(0.8f),
       m_angularDeactivationThreshold(1.0f),
       m_contactBreakingThreshold(0.02f),
+      m_numFhRays(0),
+      m_numSleepingControllers(0),
+      m_numGImpactControllers(0),
+      m_deterministic(false),
+      m_numCollData(0),
+      m_collisionStep(0),
+      m_softBodyWorld(nullptr),
       m_solver(nullptr),
       m_filterCallback(nullptr),
       m_ghostPairCallback(nullptr),
@@ -385,7 +413,15 @@ CcdPhysicsEnvironment::CcdPhysicsEnvironment(PHY_SolverType solverType, bool use
 
   m_collisionConfiguration = new btSoftBodyRigidBodyCollisionConfiguration();
 
-  btCollisionDispatcher *dispatcher = new btCollisionDispatcher(m_collisionConfiguration);
+  btCollisionDispatcher *dispatcher;
+  if (useThreads) {
+    // The dispatcher allocates its per thread data from the installed scheduler.
+    BLI_assert(btGetTaskScheduler() == CcdTaskScheduler::Get());
+    dispatcher = new CcdCollisionDispatcherMt(m_collisionConfiguration);
+  }
+  else {
+    dispatcher = new btCollisionDispatcher(m_collisionConfiguration);
+  }
   btGImpactCollisionAlgorithm::registerAlgorithm(dispatcher);
   m_ownDispatcher = dispatcher;
 
@@ -404,8 +440,31 @@ CcdPhysicsEnvironment::CcdPhysicsEnvironment(PHY_SolverType solverType, bool use
   SetSolverType(solverType);  // issues with quickstep and memory allocations
   //	m_dynamicsWorld = new
   // btDiscreteDynamicsWorld(dispatcher,m_broadphase,m_solver,m_collisionConfiguration);
-  m_dynamicsWorld = new btSoftRigidDynamicsWorld(
-      dispatcher, m_broadphase, m_solver, m_collisionConfiguration);
+  if (useThreads) {
+    /* The islands are solved in parallel, each by a free solver of the pool.
+     * The pool owns the solvers and replaces the solver of the environment. */
+    const int numSolvers = CcdTaskScheduler::Get()->getMaxNumThreads();
+    std::vector<btConstraintSolver *> solvers(numSolvers);
+    solvers[0] = m_solver;
+    for (int i = 1; i < numSolvers; ++i) {
+      if (m_solverType == PHY_SOLVER_NNCG) {
+        solvers[i] = new btNNCGConstraintSolver();
+      }
+      else {
+        solvers[i] = new btSequentialImpulseConstraintSolver();
+      }
+    }
+    btConstraintSolverPoolMt *solverPool = new btConstraintSolverPoolMt(solvers.data(),
+                                                                        numSolvers);
+    m_solver = solverPool;
+    m_dynamicsWorld = new btDiscreteDynamicsWorldMt(
+        dispatcher, m_broadphase, solverPool, nullptr, m_collisionConfiguration);
+  }
+  else {
+    m_softBodyWorld = new btSoftRigidDynamicsWorld(
+        dispatcher, m_broadphase, m_solver, m_collisionConfiguration);
+    m_dynamicsWorld = m_softBodyWorld;
+  }
   m_dynamicsWorld->setInternalTickCallback(&CcdPhysicsEnvironment::StaticSimulationSubtickCallback,
                                            this);
   // m_dynamicsWorld->getSolverInfo().m_linearSlop = 0.01f;
@@ -416,10 +475,91 @@ CcdPhysicsEnvironment::CcdPhysicsEnvironment(PHY_SolverType solverType, bool use
   SetGravity(0.0f, 0.0f, -9.81f);
 }
 
+CcdPhysicsEnvironment::ControllerKind CcdPhysicsEnvironment::GetControllerKind(
+    CcdPhysicsController *ctrl) const
+{
+  if (ctrl->GetSoftBody()) {
+    return CONTROLLER_SOFT;
+  }
+
+  btRigidBody *body = ctrl->GetRigidBody();
+  if (body && !body->isStaticObject()) {
+    return CONTROLLER_DYNAMIC;
+  }
+
+  return CONTROLLER_STATIC;
+}
+
+static bool IsGImpactShape(const btCollisionShape *shape)
+{
+  if (shape->getShapeType() == GIMPACT_SHAPE_PROXYTYPE) {
+    return true;
+  }
+
+  if (shape->isCompound()) {
+    const btCompoundShape *compoundShape = static_cast<const btCompoundShape *>(shape);
+    for (int i = 0, size = compoundShape->getNumChildShapes(); i < size; ++i) {
+      if (IsGImpactShape(compoundShape->getChildShape(i))) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void CcdPhysicsEnvironment::CountGImpactController(CcdPhysicsController *ctrl, bool count)
+{
+  const btCollisionObject *obj = ctrl->GetCollisionObject();
+  const bool gimpact = (count && obj && obj->getCollisionShape() &&
+                        IsGImpactShape(obj->getCollisionShape()));
+  if (gimpact != ctrl->m_envGImpact) {
+    m_numGImpactControllers += gimpact ? 1 : -1;
+    ctrl->m_envGImpact = gimpact;
+  }
+}
+
+void CcdPhysicsEnvironment::InsertController(CcdPhysicsController *ctrl)
+{
+  const ControllerKind kind = GetControllerKind(ctrl);
+  std::vector<CcdPhysicsController *> &controllers = m_controllers[kind];
+  ctrl->m_envKind = kind;
+  ctrl->m_envIndex = controllers.size();
+  controllers.push_back(ctrl);
+
+  const CcdConstructionInfo &info = ctrl->GetConstructionInfo();
+  if (kind == CONTROLLER_DYNAMIC && (info.m_do_fh || info.m_do_rot_fh)) {
+    ctrl->m_envFhIndex = m_fhControllers.size();
+    m_fhControllers.push_back(ctrl);
+  }
+
+  CountGImpactController(ctrl, true);
+}
+
+void CcdPhysicsEnvironment::EraseController(CcdPhysicsController *ctrl)
+{
+  std::vector<CcdPhysicsController *> &controllers = m_controllers[ctrl->m_envKind];
+  CcdPhysicsController *last = controllers.back();
+  controllers[ctrl->m_envIndex] = last;
+  last->m_envIndex = ctrl->m_envIndex;
+  controllers.pop_back();
+  ctrl->m_envIndex = -1;
+
+  if (ctrl->m_envFhIndex != -1) {
+    CcdPhysicsController *lastFh = m_fhControllers.back();
+    m_fhControllers[ctrl->m_envFhIndex] = lastFh;
+    lastFh->m_envFhIndex = ctrl->m_envFhIndex;
+    m_fhControllers.pop_back();
+    ctrl->m_envFhIndex = -1;
+  }
+
+  CountGImpactController(ctrl, false);
+}
+
 void CcdPhysicsEnvironment::AddCcdPhysicsController(CcdPhysicsController *ctrl)
 {
   // the controller is already added we do nothing
-  if (!m_controllers.insert(ctrl).second) {
+  if (IsActiveCcdPhysicsController(ctrl)) {
     return;
   }
 
@@ -452,7 +592,12 @@ void CcdPhysicsEnvironment::AddCcdPhysicsController(CcdPhysicsController *ctrl)
   else {
     if (ctrl->GetSoftBody()) {
       btSoftBody *softBody = ctrl->GetSoftBody();
-      m_dynamicsWorld->addSoftBody(softBody);
+      if (m_softBodyWorld) {
+        m_softBodyWorld->addSoftBody(softBody);
+      }
+      else {
+        CM_Warning("soft bodies are not supported by threaded physics, soft body ignored");
+      }
     }
     else {
       if (obj->getCollisionShape()) {
@@ -468,6 +613,8 @@ void CcdPhysicsEnvironment::AddCcdPhysicsController(CcdPhysicsController *ctrl)
     obj->setActivationState(ISLAND_SLEEPING);
   }
 
+  InsertController(ctrl);
+
   BLI_assert(obj->getBroadphaseHandle());
 }
 
@@ -559,10 +706,12 @@ bool CcdPhysicsEnvironment::RemoveCcdPhysicsController(CcdPhysicsController *ctr
                                                        bool freeConstraints)
 {
   // if the physics controller is already removed we do nothing
-  if (!m_controllers.erase(ctrl)) {
+  if (!IsActiveCcdPhysicsController(ctrl)) {
     return false;
   }
 
+  EraseController(ctrl);
+
   // also remove constraint
   btRigidBody *body = ctrl->GetRigidBody();
   if (body) {
@@ -585,7 +734,9 @@ bool CcdPhysicsEnvironment::RemoveCcdPhysicsController(CcdPhysicsController *ctr
   else {
     // if a softbody
     if (ctrl->GetSoftBody()) {
-      m_dynamicsWorld->removeSoftBody(ctrl->GetSoftBody());
+      if (m_softBodyWorld) {
+        m_softBodyWorld->removeSoftBody(ctrl->GetSoftBody());
+      }
     }
     else {
       m_dynamicsWorld->removeCollisionObject(ctrl->GetCollisionObject());
@@ -623,7 +774,9 @@ void CcdPhysicsEnvironment::UpdateCcdPhysicsController(CcdPhysicsController *ctr
       m_dynamicsWorld->addRigidBody(body, newCollisionGroup, newCollisionMask);
     }
     else if (softBody) {
-      m_dynamicsWorld->addSoftBody(softBody);
+      if (m_softBodyWorld) {
+        m_softBodyWorld->addSoftBody(softBody);
+      }
     }
     else {
       m_dynamicsWorld->addCollisionObject(obj, newCollisionGroup, newCollisionMask);
@@ -635,6 +788,12 @@ void CcdPhysicsEnvironment::UpdateCcdPhysicsController(CcdPhysicsController *ctr
   ctrl->m_cci.m_collisionFilterGroup = newCollisionGroup;
   ctrl->m_cci.m_collisionFilterMask = newCollisionMask;
   ctrl->m_cci.m_collisionFlags = newCollisionFlags;
+
+  // The controller can change from static to dynamic.
+  if (IsActiveCcdPhysicsController(ctrl)) {
+    EraseController(ctrl);
+    InsertController(ctrl);
+  }
 }
 
 void CcdPhysicsEnvironment::RefreshCcdPhysicsController(CcdPhysicsController *ctrl)
@@ -647,11 +806,23 @@ void CcdPhysicsEnvironment::RefreshCcdPhysicsController(CcdPhysicsController *ct
                                                            m_dynamicsWorld->getDispatcher());
     }
   }
+
+  // The shape is refreshed after it was replaced or a compound child was added or removed.
+  if (IsActiveCcdPhysicsController(ctrl)) {
+    CountGImpactController(ctrl, true);
+  }
 }
 
 bool CcdPhysicsEnvironment::IsActiveCcdPhysicsController(CcdPhysicsController *ctrl)
 {
-  return (m_controllers.find(ctrl) != m_controllers.end());
+  // The index of a controller added in an other environment can be out of the arrays.
+  if (ctrl->m_envIndex == -1) {
+    return false;
+  }
+
+  const std::vector<CcdPhysicsController *> &controllers = m_controllers[ctrl->m_envKind];
+  return ((unsigned int)ctrl->m_envIndex < controllers.size() &&
+          controllers[ctrl->m_envIndex] == ctrl);
 }
 
 void CcdPhysicsEnvironment::AddCcdGraphicController(CcdGraphicController *ctrl)
@@ -688,10 +859,17 @@ void CcdPhysicsEnvironment::RemoveCcdGraphicController(CcdGraphicController *ctr
 
 void CcdPhysicsEnvironment::UpdateCcdPhysicsControllerShape(CcdShapeConstructionInfo *shapeInfo)
 {
-  for (CcdPhysicsController *ctrl : m_controllers) {
-    if (ctrl->GetShapeInfo() != shapeInfo)
-      continue;
+  // Replacing the shape can move the controller to other arrays, gather them first.
+  std::vector<CcdPhysicsController *> shapeControllers;
+  for (const std::vector<CcdPhysicsController *> &controllers : m_controllers) {
+    for (CcdPhysicsController *ctrl : controllers) {
+      if (ctrl->GetShapeInfo() == shapeInfo) {
+        shapeControllers.push_back(ctrl);
+      }
+    }
+  }
 
+  for (CcdPhysicsController *ctrl : shapeControllers) {
     ctrl->ReplaceControllerShape(nullptr);
     RefreshCcdPhysicsController(ctrl);
   }
@@ -712,37 +890,50 @@ void CcdPhysicsEnvironment::StaticSimulationSubtickCallback(btDynamicsWorld *wor
 
 void CcdPhysicsEnvironment::SimulationSubtickCallback(btScalar timeStep)
 {
-  std::set<CcdPhysicsController *>::iterator it;
-
-  for (it = m_controllers.begin(); it != m_controllers.end(); it++) {
-    (*it)->SimulationTick(timeStep);
+  // Only the non static rigid bodies are clamped.
+  for (CcdPhysicsController *ctrl : m_controllers[CONTROLLER_DYNAMIC]) {
+    ctrl->SimulationTick(timeStep);
   }
 }
 
-bool CcdPhysicsEnvironment::ProceedDeltaTime(double curTime, float timeStep, float interval)
+void CcdPhysicsEnvironment::ApplyGlobalSettings()
 {
-  std::set<CcdPhysicsController *>::iterator it;
-  int i;
-
-  // Update Bullet global variables.
   gDeactivationTime = m_deactivationTime;
   gContactBreakingThreshold = m_contactBreakingThreshold;
+}
 
-  for (it = m_controllers.begin(); it != m_controllers.end(); it++) {
-    (*it)->SynchronizeMotionStates(timeStep);
+bool CcdPhysicsEnvironment::HasSameGlobalSettings(PHY_IPhysicsEnvironment *other)
+{
+  CcdPhysicsEnvironment *env = dynamic_cast<CcdPhysicsEnvironment *>(other);
+  // Other physics engines don't use the Bullet globals.
+  if (!env) {
+    return true;
   }
 
+  return (m_deactivationTime == env->m_deactivationTime &&
+          m_contactBreakingThreshold == env->m_contactBreakingThreshold);
+}
+
+bool CcdPhysicsEnvironment::ProceedDeltaTime(double curTime, float timeStep, float interval)
+{
+  int i;
+
+  SynchronizeMotionStates(timeStep);
+
   float subStep = timeStep / float(m_numTimeSubSteps);
-  i = m_dynamicsWorld->stepSimulation(
-      interval, 25, subStep);  // perform always a full simulation step
+  if (m_deterministic) {
+    i = StepDeterministic(subStep);
+  }
+  else {
+    i = m_dynamicsWorld->stepSimulation(
+        interval, 25, subStep);  // perform always a full simulation step
+  }
   // uncomment next line to see where Bullet spend its time (printf in console)
   // CProfileManager::dumpAll();
 
   ProcessFhSprings(curTime, i * subStep);
 
-  for (it = m_controllers.begin(); it != m_controllers.end(); it++) {
-    (*it)->SynchronizeMotionStates(timeStep);
-  }
+  SynchronizeMotionStates(timeStep);
 
   for (i = 0; i < m_wrapperVehicles.size(); i++) {
     WrapperVehicle *veh = m_wrapperVehicles[i];
@@ -754,15 +945,70 @@ bool CcdPhysicsEnvironment::ProceedDeltaTime(double curTime, float timeStep, flo
   return true;
 }
 
-void CcdPhysicsEnvironment::UpdateSoftBodies()
+int CcdPhysicsEnvironment::StepDeterministic(float subStep)
 {
-  std::set<CcdPhysicsController *>::iterator it;
+  /* Bullet clears the forces after each call, apply the forces of the logic to all the sub
+   * steps as a single call with sub steps does. The forces were already multiplied by the
+   * linear and angular factors, these are 0 or 1 for the locked axes. */
+  const std::vector<CcdPhysicsController *> &controllers = m_controllers[CONTROLLER_DYNAMIC];
+  m_stepForces.resize(controllers.size() * 2);
+  for (unsigned int i = 0, size = controllers.size(); i < size; ++i) {
+    btRigidBody *body = controllers[i]->GetRigidBody();
+    m_stepForces[i * 2] = body ? body->getTotalForce() : btVector3(0.0f, 0.0f, 0.0f);
+    m_stepForces[i * 2 + 1] = body ? body->getTotalTorque() : btVector3(0.0f, 0.0f, 0.0f);
+  }
+
+  // The parallel loops keep their order only when run in this thread.
+  CcdTaskScheduler::SetSerial(true);
+
+  for (int step = 0; step < m_numTimeSubSteps; ++step) {
+    if (step > 0) {
+      for (unsigned int i = 0, size = controllers.size(); i < size; ++i) {
+        btRigidBody *body = controllers[i]->GetRigidBody();
+        if (body) {
+          body->applyCentralForce(m_stepForces[i * 2]);
+          body->applyTorque(m_stepForces[i * 2 + 1]);
+        }
+      }
+    }
+    m_dynamicsWorld->stepSimulation(subStep, 0);
+  }
 
-  for (it = m_controllers.begin(); it != m_controllers.end(); it++) {
-    (*it)->UpdateSoftBody();
+  CcdTaskScheduler::SetSerial(false);
+
+  return m_numTimeSubSteps;
+}
+
+void CcdPhysicsEnvironment::SynchronizeMotionStates(float timeStep)
+{
+  /* The static controllers are not moved by the simulation, their transform and scale
+   * are applied in CcdPhysicsController::SetTransform when changed. */
+  m_numSleepingControllers = 0;
+  for (CcdPhysicsController *ctrl : m_controllers[CONTROLLER_DYNAMIC]) {
+    ctrl->SynchronizeMotionStates(timeStep);
+    if (ctrl->IsSleeping()) {
+      ++m_numSleepingControllers;
+    }
+  }
+  for (CcdPhysicsController *ctrl : m_controllers[CONTROLLER_SOFT]) {
+    ctrl->SynchronizeMotionStates(timeStep);
+  }
+}
+
+void CcdPhysicsEnvironment::UpdateSoftBodies()
+{
+  for (CcdPhysicsController *ctrl : m_controllers[CONTROLLER_SOFT]) {
+    ctrl->UpdateSoftBody();
   }
 }
 
+bool CcdPhysicsEnvironment::IsParallelRayTestSafe() const
+{
+  /* The ray test of a GImpact mesh locks and unlocks the mesh vertices without synchronization,
+   * in this case the rays must be tested in the calling thread. */
+  return (m_numGImpactControllers == 0);
+}
+
 class ClosestRayResultCallbackNotMe : public btCollisionWorld::ClosestRayResultCallback {
   btCollisionObject *m_owner;
   btCollisionObject *m_parent;
@@ -778,6 +1024,20 @@ class ClosestRayResultCallbackNotMe : public btCollisionWorld::ClosestRayResultC
   {
   }
 
+  /// Prepare the callback for a new ray, to reuse it without construction.
+  void Reset(const btVector3 &rayFromWorld,
+             const btVector3 &rayToWorld,
+             btCollisionObject *owner,
+             btCollisionObject *parent)
+  {
+    m_rayFromWorld = rayFromWorld;
+    m_rayToWorld = rayToWorld;
+    m_closestHitFraction = btScalar(1.0f);
+    m_collisionObject = nullptr;
+    m_owner = owner;
+    m_parent = parent;
+  }
+
   virtual bool needsCollision(btBroadphaseProxy *proxy0) const
   {
     // don't collide with self
@@ -791,134 +1051,199 @@ class ClosestRayResultCallbackNotMe : public btCollisionWorld::ClosestRayResultC
   }
 };
 
+/// Loop body testing the rays of a range of Fh spring controllers.
+class CcdFhRayTestBody : public btIParallelForBody {
+ private:
+  const btCollisionWorld *m_world;
+  CcdPhysicsController *const *m_controllers;
+  CcdPhysicsEnvironment::FhRayResult *m_results;
+
+ public:
+  CcdFhRayTestBody(const btCollisionWorld *world,
+                   CcdPhysicsController *const *controllers,
+                   CcdPhysicsEnvironment::FhRayResult *results)
+      : m_world(world), m_controllers(controllers), m_results(results)
+  {
+  }
+
+  virtual void forLoop(int iBegin, int iEnd) const
+  {
+    // send a ray from {0.0, 0.0, 0.0} towards {0.0, 0.0, -10.0}, the ray always points down the
+    // z axis in world space.
+    const btVector3 rayDirLocal(0.0f, 0.0f, -10.0f);
+    // One callback per task, reset for each ray.
+    ClosestRayResultCallbackNotMe resultCallback(
+        btVector3(0.0f, 0.0f, 0.0f), rayDirLocal, nullptr, nullptr);
+
+    for (int i = iBegin; i < iEnd; ++i) {
+      CcdPhysicsController *ctrl = m_controllers[i];
+      CcdPhysicsEnvironment::FhRayResult &result = m_results[i];
+      result.m_hitObject = nullptr;
+
+      btRigidBody *body = ctrl->GetRigidBody();
+      if (body->isStaticOrKinematicObject()) {
+        continue;
+      }
+
+      CcdPhysicsController *parentCtrl = ctrl->GetParentRoot();
+      btRigidBody *parentBody = parentCtrl ? parentCtrl->GetRigidBody() : nullptr;
+
+      const btVector3 rayFromWorld = body->getCenterOfMassPosition();
+      const btVector3 rayToWorld = rayFromWorld + rayDirLocal;
+      resultCallback.Reset(rayFromWorld, rayToWorld, body, parentBody);
+
+      m_world->rayTest(rayFromWorld, rayToWorld, resultCallback);
+      if (resultCallback.hasHit()) {
+        result.m_hitObject = resultCallback.m_collisionObject;
+        result.m_hitFraction = resultCallback.m_closestHitFraction;
+        result.m_hitNormal = resultCallback.m_hitNormalWorld;
+      }
+    }
+  }
+};
+
 void CcdPhysicsEnvironment::ProcessFhSprings(double curTime, float interval)
 {
-  std::set<CcdPhysicsController *>::iterator it;
+  const unsigned int numFhControllers = m_fhControllers.size();
+  m_numFhRays = numFhControllers;
+  if (numFhControllers == 0) {
+    return;
+  }
 
   const float step = interval * KX_GetActiveEngine()->GetTicRate();
 
-  for (it = m_controllers.begin(); it != m_controllers.end(); it++) {
-    CcdPhysicsController *ctrl = (*it);
-    btRigidBody *body = ctrl->GetRigidBody();
+  /* The ray tests only read the world, they are all done first, in parallel, then the springs
+   * are applied in order. The springs only change the velocities of the bodies, not their
+   * position, so the rays hit the same objects as if tested between the springs. */
+  m_fhRayResults.resize(numFhControllers);
+  const CcdFhRayTestBody rayTestBody(m_dynamicsWorld, m_fhControllers.data(), m_fhRayResults.data());
 
-    if (body && (ctrl->GetConstructionInfo().m_do_fh || ctrl->GetConstructionInfo().m_do_rot_fh)) {
-      // re-implement SM_FhObject.cpp using btCollisionWorld::rayTest and info from
-      // ctrl->getConstructionInfo() send a ray from {0.0, 0.0, 0.0} towards {0.0, 0.0, -10.0}, in
-      // local coordinates
-      CcdPhysicsController *parentCtrl = ctrl->GetParentRoot();
-      btRigidBody *parentBody = parentCtrl ? parentCtrl->GetRigidBody() : nullptr;
-      btRigidBody *cl_object = parentBody ? parentBody : body;
+  // A ray test is short, group the rays to amortize the task creation.
+  static const int grainSize = 16;
+  if (numFhControllers > grainSize && IsParallelRayTestSafe()) {
+    CcdTaskScheduler::Get()->parallelFor(0, numFhControllers, grainSize, rayTestBody);
+  }
+  else {
+    rayTestBody.forLoop(0, numFhControllers);
+  }
 
-      if (body->isStaticOrKinematicObject())
+  const btVector3 rayDirLocal(0.0f, 0.0f, -10.0f);
+
+  for (unsigned int i = 0; i < numFhControllers; ++i) {
+    const FhRayResult &rayResult = m_fhRayResults[i];
+    if (!rayResult.m_hitObject) {
+      continue;
+    }
+
+    CcdPhysicsController *ctrl = m_fhControllers[i];
+    // re-implement SM_FhObject.cpp using btCollisionWorld::rayTest and info from
+    // ctrl->getConstructionInfo()
+    CcdPhysicsController *parentCtrl = ctrl->GetParentRoot();
+    btRigidBody *parentBody = parentCtrl ? parentCtrl->GetRigidBody() : nullptr;
+    btRigidBody *cl_object = parentBody ? parentBody : ctrl->GetRigidBody();
+
+    // we hit this one: rayResult.m_hitObject;
+    CcdPhysicsController *controller = static_cast<CcdPhysicsController *>(
+        rayResult.m_hitObject->getUserPointer());
+
+    if (controller) {
+      if (controller->GetConstructionInfo().m_fh_distance < SIMD_EPSILON)
         continue;
 
-      btVector3 rayDirLocal(0.0f, 0.0f, -10.0f);
+      btRigidBody *hit_object = controller->GetRigidBody();
+      if (!hit_object)
+        continue;
 
-      // m_dynamicsWorld
-      // ctrl->GetRigidBody();
-      btVector3 rayFromWorld = body->getCenterOfMassPosition();
-      // btVector3	rayToWorld = rayFromWorld + body->getCenterOfMassTransform().getBasis() *
-      // rayDirLocal; ray always points down the z axis in world space...
-      btVector3 rayToWorld = rayFromWorld + rayDirLocal;
+      CcdConstructionInfo &hitObjShapeProps = controller->GetConstructionInfo();
 
-      ClosestRayResultCallbackNotMe resultCallback(rayFromWorld, rayToWorld, body, parentBody);
+      float distance = rayResult.m_hitFraction * rayDirLocal.length() -
+                       ctrl->GetConstructionInfo().m_radius;
+      if (distance >= hitObjShapeProps.m_fh_distance)
+        continue;
 
-      m_dynamicsWorld->rayTest(rayFromWorld, rayToWorld, resultCallback);
-      if (resultCallback.hasHit()) {
-        // we hit this one: resultCallback.m_collisionObject;
-        CcdPhysicsController *controller = static_cast<CcdPhysicsController *>(
-            resultCallback.m_collisionObject->getUserPointer());
-
-        if (controller) {
-          if (controller->GetConstructionInfo().m_fh_distance < SIMD_EPSILON)
-            continue;
-
-          btRigidBody *hit_object = controller->GetRigidBody();
-          if (!hit_object)
-            continue;
-
-          CcdConstructionInfo &hitObjShapeProps = controller->GetConstructionInfo();
-
-          float distance = resultCallback.m_closestHitFraction * rayDirLocal.length() -
-                           ctrl->GetConstructionInfo().m_radius;
-          if (distance >= hitObjShapeProps.m_fh_distance)
-            continue;
-
-          // btVector3 ray_dir = cl_object->getCenterOfMassTransform().getBasis()*
-          // rayDirLocal.normalized();
-          btVector3 ray_dir = rayDirLocal.normalized();
-          btVector3 normal = resultCallback.m_hitNormalWorld;
-          normal.normalize();
-
-          if (ctrl->GetConstructionInfo().m_do_fh) {
-            btVector3 lspot = cl_object->getCenterOfMassPosition() +
-                              rayDirLocal * resultCallback.m_closestHitFraction;
-
-            lspot -= hit_object->getCenterOfMassPosition();
-            btVector3 rel_vel = cl_object->getLinearVelocity() -
-                                hit_object->getVelocityInLocalPoint(lspot);
-            btScalar rel_vel_ray = ray_dir.dot(rel_vel);
-            btScalar spring_extent = 1.0f - distance / hitObjShapeProps.m_fh_distance;
-
-            btScalar i_spring = spring_extent * hitObjShapeProps.m_fh_spring;
-            btScalar i_damp = rel_vel_ray * hitObjShapeProps.m_fh_damping;
-
-            cl_object->setLinearVelocity(cl_object->getLinearVelocity() +
-                                         (-(i_spring + i_damp) * ray_dir) * step);
-            if (hitObjShapeProps.m_fh_normal) {
-              cl_object->setLinearVelocity(cl_object->getLinearVelocity() +
-                                           (i_spring + i_damp) *
-                                               (normal - normal.dot(ray_dir) * ray_dir) * step);
-            }
+      // btVector3 ray_dir = cl_object->getCenterOfMassTransform().getBasis()*
+      // rayDirLocal.normalized();
+      btVector3 ray_dir = rayDirLocal.normalized();
+      btVector3 normal = rayResult.m_hitNormal;
+      normal.normalize();
+
+      if (ctrl->GetConstructionInfo().m_do_fh) {
+        btVector3 lspot = cl_object->getCenterOfMassPosition() +
+                          rayDirLocal * rayResult.m_hitFraction;
+
+        lspot -= hit_object->getCenterOfMassPosition();
+        btVector3 rel_vel = cl_object->getLinearVelocity() -
+                            hit_object->getVelocityInLocalPoint(lspot);
+        btScalar rel_vel_ray = ray_dir.dot(rel_vel);
+        btScalar spring_extent = 1.0f - distance / hitObjShapeProps.m_fh_distance;
+
+        btScalar i_spring = spring_extent * hitObjShapeProps.m_fh_spring;
+        btScalar i_damp = rel_vel_ray * hitObjShapeProps.m_fh_damping;
+
+        cl_object->setLinearVelocity(cl_object->getLinearVelocity() +
+                                     (-(i_spring + i_damp) * ray_dir) * step);
+        if (hitObjShapeProps.m_fh_normal) {
+          cl_object->setLinearVelocity(cl_object->getLinearVelocity() +
+                                       (i_spring + i_damp) *
+                                           (normal - normal.dot(ray_dir) * ray_dir) * step);
+        }
 
-            btVector3 lateral = rel_vel - rel_vel_ray * ray_dir;
+        btVector3 lateral = rel_vel - rel_vel_ray * ray_dir;
 
-            if (ctrl->GetConstructionInfo().m_do_anisotropic) {
-              // Bullet basis contains no scaling/shear etc.
-              const btMatrix3x3 &lcs = cl_object->getCenterOfMassTransform().getBasis();
-              btVector3 loc_lateral = lateral * lcs;
-              const btVector3 &friction_scaling = cl_object->getAnisotropicFriction();
-              loc_lateral *= friction_scaling;
-              lateral = lcs * loc_lateral;
-            }
+        if (ctrl->GetConstructionInfo().m_do_anisotropic) {
+          // Bullet basis contains no scaling/shear etc.
+          const btMatrix3x3 &lcs = cl_object->getCenterOfMassTransform().getBasis();
+          btVector3 loc_lateral = lateral * lcs;
+          const btVector3 &friction_scaling = cl_object->getAnisotropicFriction();
+          loc_lateral *= friction_scaling;
+          lateral = lcs * loc_lateral;
+        }
 
-            btScalar rel_vel_lateral = lateral.length();
+        btScalar rel_vel_lateral = lateral.length();
 
-            if (rel_vel_lateral > SIMD_EPSILON) {
-              btScalar friction_factor = hit_object->getFriction();  // cl_object->getFriction();
+        if (rel_vel_lateral > SIMD_EPSILON) {
+          btScalar friction_factor = hit_object->getFriction();  // cl_object->getFriction();
 
-              btScalar max_friction = friction_factor * btMax(btScalar(0.0), i_spring);
+          btScalar max_friction = friction_factor * btMax(btScalar(0.0), i_spring);
 
-              btScalar rel_mom_lateral = rel_vel_lateral / cl_object->getInvMass();
+          btScalar rel_mom_lateral = rel_vel_lateral / cl_object->getInvMass();
 
-              btVector3 friction = (rel_mom_lateral > max_friction) ?
-                                       -lateral * (max_friction / rel_vel_lateral) :
-                                       -lateral;
+          btVector3 friction = (rel_mom_lateral > max_friction) ?
+                                   -lateral * (max_friction / rel_vel_lateral) :
+                                   -lateral;
 
-              cl_object->applyCentralImpulse(friction * step);
-            }
-          }
+          cl_object->applyCentralImpulse(friction * step);
+        }
+      }
 
-          if (ctrl->GetConstructionInfo().m_do_rot_fh) {
-            btVector3 up2 = cl_object->getWorldTransform().getBasis().getColumn(2);
+      if (ctrl->GetConstructionInfo().m_do_rot_fh) {
+        btVector3 up2 = cl_object->getWorldTransform().getBasis().getColumn(2);
 
-            btVector3 t_spring = up2.cross(normal) * hitObjShapeProps.m_fh_spring;
-            btVector3 ang_vel = cl_object->getAngularVelocity();
+        btVector3 t_spring = up2.cross(normal) * hitObjShapeProps.m_fh_spring;
+        btVector3 ang_vel = cl_object->getAngularVelocity();
 
-            // only rotations that tilt relative to the normal are damped
-            ang_vel -= ang_vel.dot(normal) * normal;
+        // only rotations that tilt relative to the normal are damped
+        ang_vel -= ang_vel.dot(normal) * normal;
 
-            btVector3 t_damp = ang_vel * hitObjShapeProps.m_fh_damping;
+        btVector3 t_damp = ang_vel * hitObjShapeProps.m_fh_damping;
 
-            cl_object->setAngularVelocity(cl_object->getAngularVelocity() +
-                                          (t_spring - t_damp) * step);
-          }
-        }
+        cl_object->setAngularVelocity(cl_object->getAngularVelocity() +
+                                      (t_spring - t_damp) * step);
       }
     }
   }
 }
 
+unsigned int CcdPhysicsEnvironment::GetNumFhRays() const
+{
+  return m_numFhRays;
+}
+
+unsigned int CcdPhysicsEnvironment::GetNumSleepingControllers() const
+{
+  return m_numSleepingControllers;
+}
+
 int CcdPhysicsEnvironment::GetDebugMode() const
 {
   if (m_debugDrawer) {
@@ -947,10 +1272,12 @@ void CcdPhysicsEnvironment::SetDeactivationLinearTreshold(float linTresh)
   m_linearDeactivationThreshold = linTresh;
 
   // Update from all controllers.
-  for (CcdPhysicsController *ctrl : m_controllers) {
-    if (ctrl->GetRigidBody()) {
-      ctrl->GetRigidBody()->setSleepingThresholds(m_linearDeactivationThreshold,
-                                                  m_angularDeactivationThreshold);
+  for (const std::vector<CcdPhysicsController *> &controllers : m_controllers) {
+    for (CcdPhysicsController *ctrl : controllers) {
+      if (ctrl->GetRigidBody()) {
+        ctrl->GetRigidBody()->setSleepingThresholds(m_linearDeactivationThreshold,
+                                                    m_angularDeactivationThreshold);
+      }
     }
   }
 }
@@ -959,12 +1286,13 @@ void CcdPhysicsEnvironment::SetDeactivationAngularTreshold(float angTresh)
   m_angularDeactivationThreshold = angTresh;
 
   // Update from all controllers.
-  for (std::set<CcdPhysicsController *>::iterator it = m_controllers.begin();
-       it != m_controllers.end();
-       it++) {
-    if ((*it)->GetRigidBody())
-      (*it)->GetRigidBody()->setSleepingThresholds(m_linearDeactivationThreshold,
-                                                   m_angularDeactivationThreshold);
+  for (const std::vector<CcdPhysicsController *> &controllers : m_controllers) {
+    for (CcdPhysicsController *ctrl : controllers) {
+      if (ctrl->GetRigidBody()) {
+        ctrl->GetRigidBody()->setSleepingThresholds(m_linearDeactivationThreshold,
+                                                    m_angularDeactivationThreshold);
+      }
+    }
   }
 }
 
@@ -1001,6 +1329,16 @@ void CcdPhysicsEnvironment::SetSolverDamping(float damping)
   m_dynamicsWorld->getSolverInfo().m_damping = damping;
 }
 
+void CcdPhysicsEnvironment::SetNumThreads(int numThreads)
+{
+  CcdTaskScheduler::Get()->setNumThreads(numThreads);
+}
+
+int CcdPhysicsEnvironment::GetNumThreads()
+{
+  return CcdTaskScheduler::Get()->GetUsedThreads();
+}
+
 void CcdPhysicsEnvironment::SetSolverType(PHY_SolverType solverType)
 {
 
@@ -1037,7 +1375,9 @@ void CcdPhysicsEnvironment::SetGravity(float x, float y, float z)
 {
   m_gravity = btVector3(x, y, z);
   m_dynamicsWorld->setGravity(m_gravity);
-  m_dynamicsWorld->getWorldInfo().m_gravity.setValue(x, y, z);
+  if (m_softBodyWorld) {
+    m_softBodyWorld->getWorldInfo().m_gravity.setValue(x, y, z);
+  }
 }
 
 static int gConstraintUid = 1;
@@ -1316,6 +1656,57 @@ PHY_IPhysicsController *CcdPhysicsEnvironment::RayTest(PHY_IRayCastFilterCallbac
   return result.m_controller;
 }
 
+/// Loop body testing a range of rays of a batch.
+class CcdRayTestBatchBody : public btIParallelForBody {
+ private:
+  CcdPhysicsEnvironment *m_env;
+  PHY_IRayCastFilterCallback **m_filterCallbacks;
+  const MT_Vector3 *m_fromPoints;
+  const MT_Vector3 *m_toPoints;
+  PHY_IPhysicsController **m_hitControllers;
+
+ public:
+  CcdRayTestBatchBody(CcdPhysicsEnvironment *env,
+                      PHY_IRayCastFilterCallback **filterCallbacks,
+                      const MT_Vector3 *fromPoints,
+                      const MT_Vector3 *toPoints,
+                      PHY_IPhysicsController **hitControllers)
+      : m_env(env),
+        m_filterCallbacks(filterCallbacks),
+        m_fromPoints(fromPoints),
+        m_toPoints(toPoints),
+        m_hitControllers(hitControllers)
+  {
+  }
+
+  virtual void forLoop(int iBegin, int iEnd) const
+  {
+    for (int i = iBegin; i < iEnd; ++i) {
+      const MT_Vector3 &from = m_fromPoints[i];
+      const MT_Vector3 &to = m_toPoints[i];
+      m_hitControllers[i] = m_env->RayTest(
+          *m_filterCallbacks[i], from.x(), from.y(), from.z(), to.x(), to.y(), to.z());
+    }
+  }
+};
+
+void CcdPhysicsEnvironment::RayTestBatch(PHY_IRayCastFilterCallback **filterCallbacks,
+                                         const MT_Vector3 *fromPoints,
+                                         const MT_Vector3 *toPoints,
+                                         PHY_IPhysicsController **hitControllers,
+                                         unsigned int numRays)
+{
+  const CcdRayTestBatchBody body(this, filterCallbacks, fromPoints, toPoints, hitControllers);
+  if (IsParallelRayTestSafe()) {
+    // A ray test is short, group the rays to amortize the task creation.
+    static const int grainSize = 64;
+    CcdTaskScheduler::Get()->parallelFor(0, numRays, grainSize, body);
+  }
+  else {
+    body.forLoop(0, numRays);
+  }
+}
+
 // Handles occlusion culling.
 // The implementation is based on the CDTestFramework
 struct OcclusionBuffer {
@@ -1970,14 +2361,13 @@ void CcdPhysicsEnvironment::MergeEnvironment(PHY_IPhysicsEnvironment *other_env)
     return;
   }
 
-  std::set<CcdPhysicsController *>::iterator it;
-
-  while (other->m_controllers.begin() != other->m_controllers.end()) {
-    it = other->m_controllers.begin();
-    CcdPhysicsController *ctrl = (*it);
+  for (std::vector<CcdPhysicsController *> &controllers : other->m_controllers) {
+    while (!controllers.empty()) {
+      CcdPhysicsController *ctrl = controllers.back();
 
-    other->RemoveCcdPhysicsController(ctrl, true);
-    this->AddCcdPhysicsController(ctrl);
+      other->RemoveCcdPhysicsController(ctrl, true);
+      this->AddCcdPhysicsController(ctrl);
+    }
   }
 }
 
@@ -2073,6 +2463,9 @@ void CcdPhysicsEnvironment::CallbackTriggers()
     return;
   }
 
+  // The reports of this step are told apart from the reports of the previous steps.
+  ++m_collisionStep;
+
   // Walk over all overlapping pairs, and if one of the involved bodies is registered for trigger
   // callback, perform callback
   btDispatcher *dispatcher = m_dynamicsWorld->getDispatcher();
@@ -2102,11 +2495,36 @@ void CcdPhysicsEnvironment::CallbackTriggers()
       continue;
     }
 
-    const CcdCollData *coll_data = new CcdCollData(manifold);
+    CcdFrameCollData *coll_data = NewFrameCollData();
+    coll_data->Update(manifold);
     m_triggerCallbacks[PHY_OBJECT_RESPONSE](m_triggerCallbacksUserPtrs[PHY_OBJECT_RESPONSE], ctrl0, ctrl1, coll_data, first);
   }
 }
 
+/// Number of records allocated at once in the collision data arena.
+static const unsigned int collDataBlockSize = 256;
+
+CcdFrameCollData *CcdPhysicsEnvironment::NewFrameCollData()
+{
+  const unsigned int block = m_numCollData / collDataBlockSize;
+  if (block == m_collDataBlocks.size()) {
+    m_collDataBlocks.emplace_back(new CcdFrameCollData[collDataBlockSize]);
+  }
+
+  return &m_collDataBlocks[block][m_numCollData++ % collDataBlockSize];
+}
+
+void CcdPhysicsEnvironment::ClearCollisionData()
+{
+  m_numCollData = 0;
+  m_collisionStep = 0;
+}
+
+unsigned int CcdPhysicsEnvironment::GetCollisionStep() const
+{
+  return m_collisionStep;
+}
+
 PHY_CollisionTestResult CcdPhysicsEnvironment::CheckCollision(PHY_IPhysicsController *ctrl0, PHY_IPhysicsController *ctrl1)
 {
   PHY_CollisionTestResult result{false, false, nullptr};
@@ -2685,6 +3103,213 @@ void CcdPhysicsEnvironment::ExportFile(const std::string &filename)
   }
 }
 
+void CcdPhysicsEnvironment::ResetCollisionState()
+{
+  /// Collision object with the data lost when it's removed from the world.
+  struct CollisionObjectEntry {
+    btCollisionObject *m_object;
+    int m_group;
+    int m_mask;
+    btVector3 m_gravity;
+  };
+
+  btCollisionObjectArray &objects = m_dynamicsWorld->getCollisionObjectArray();
+  const int numObjects = objects.size();
+  btAlignedObjectArray<CollisionObjectEntry> entries;
+  entries.resize(numObjects);
+
+  for (int i = 0; i < numObjects; ++i) {
+    CollisionObjectEntry &entry = entries[i];
+    btCollisionObject *object = objects[i];
+    const btBroadphaseProxy *proxy = object->getBroadphaseHandle();
+    btRigidBody *body = btRigidBody::upcast(object);
+    entry.m_object = object;
+    entry.m_group = proxy->m_collisionFilterGroup;
+    entry.m_mask = proxy->m_collisionFilterMask;
+    entry.m_gravity = body ? body->getGravity() : btVector3(0.0f, 0.0f, 0.0f);
+  }
+
+  // Remove from the last to keep the order of the remaining objects.
+  for (int i = numObjects - 1; i >= 0; --i) {
+    btCollisionObject *object = entries[i].m_object;
+    btRigidBody *body = btRigidBody::upcast(object);
+    btSoftBody *softBody = btSoftBody::upcast(object);
+    if (body) {
+      m_dynamicsWorld->removeRigidBody(body);
+    }
+    else if (softBody) {
+      m_softBodyWorld->removeSoftBody(softBody);
+    }
+    else {
+      m_dynamicsWorld->removeCollisionObject(object);
+    }
+  }
+
+  // The broadphase is empty, reset its trees and proxy identifiers.
+  m_broadphase->resetPool(m_dynamicsWorld->getDispatcher());
+
+  for (int i = 0; i < numObjects; ++i) {
+    const CollisionObjectEntry &entry = entries[i];
+    btRigidBody *body = btRigidBody::upcast(entry.m_object);
+    btSoftBody *softBody = btSoftBody::upcast(entry.m_object);
+    if (body) {
+      const int activationState = body->getActivationState();
+      m_dynamicsWorld->addRigidBody(body, entry.m_group, entry.m_mask);
+      // Adding a body overrides its gravity and puts static bodies to sleep.
+      body->setGravity(entry.m_gravity);
+      body->forceActivationState(activationState);
+    }
+    else if (softBody) {
+      m_softBodyWorld->addSoftBody(softBody, entry.m_group, entry.m_mask);
+    }
+    else {
+      m_dynamicsWorld->addCollisionObject(entry.m_object, entry.m_group, entry.m_mask);
+    }
+  }
+
+  m_dynamicsWorld->getConstraintSolver()->reset();
+}
+
+/// Simulation state of a vehicle wheel in a snapshot.
+struct CcdWheelState {
+  btScalar m_rotation;
+  btScalar m_deltaRotation;
+  btScalar m_steering;
+  btScalar m_engineForce;
+  btScalar m_brake;
+};
+
+bool CcdPhysicsEnvironment::SaveState(PHY_SnapshotWriter &writer)
+{
+  const int numConstraints = m_dynamicsWorld->getNumConstraints();
+  writer.Write(numConstraints);
+  for (int i = 0; i < numConstraints; ++i) {
+    btTypedConstraint *constraint = m_dynamicsWorld->getConstraint(i);
+    writer.Write(constraint->isEnabled());
+    writer.Write(constraint->internalGetAppliedImpulse());
+  }
+
+  const unsigned int numVehicles = m_wrapperVehicles.size();
+  writer.Write(numVehicles);
+  for (WrapperVehicle *wrapperVehicle : m_wrapperVehicles) {
+    btRaycastVehicle *vehicle = wrapperVehicle->GetVehicle();
+    const int numWheels = vehicle->getNumWheels();
+    writer.Write(numWheels);
+    for (int i = 0; i < numWheels; ++i) {
+      const btWheelInfo &info = vehicle->getWheelInfo(i);
+      const CcdWheelState state = {
+          info.m_rotation, info.m_deltaRotation, info.m_steering, info.m_engineForce, info.m_brake};
+      writer.Write(state);
+    }
+  }
+
+  return true;
+}
+
+class CcdPhysicsEnvironment::SnapshotState : public PHY_ISnapshotState {
+ public:
+  CcdPhysicsEnvironment *m_env;
+  /// Enabled state and applied impulse of the constraints.
+  std::vector<std::pair<bool, btScalar>> m_constraints;
+  /// Wheels state of all the vehicles.
+  std::vector<CcdWheelState> m_wheels;
+
+  SnapshotState(CcdPhysicsEnvironment *env) : m_env(env)
+  {
+  }
+
+  virtual void Apply()
+  {
+    btDiscreteDynamicsWorld *world = m_env->m_dynamicsWorld;
+    for (int i = 0, size = m_constraints.size(); i < size; ++i) {
+      btTypedConstraint *constraint = world->getConstraint(i);
+      constraint->setEnabled(m_constraints[i].first);
+      constraint->internalSetAppliedImpulse(m_constraints[i].second);
+    }
+
+    unsigned int index = 0;
+    for (WrapperVehicle *wrapperVehicle : m_env->m_wrapperVehicles) {
+      btRaycastVehicle *vehicle = wrapperVehicle->GetVehicle();
+      for (int i = 0, numWheels = vehicle->getNumWheels(); i < numWheels; ++i) {
+        const CcdWheelState &state = m_wheels[index++];
+        btWheelInfo &info = vehicle->getWheelInfo(i);
+        info.m_rotation = state.m_rotation;
+        info.m_deltaRotation = state.m_deltaRotation;
+        info.m_steering = state.m_steering;
+        info.m_engineForce = state.m_engineForce;
+        info.m_brake = state.m_brake;
+      }
+    }
+
+    /* Rebuild the contacts and the broadphase from the restored transforms only, all the
+     * simulations restarted from the snapshot then give the same results. The contacts are
+     * not saved, saving doesn't modify the running simulation. */
+    if (m_env->m_deterministic) {
+      m_env->ResetCollisionState();
+    }
+    else {
+      // Move the broadphase proxies to the restored transforms.
+      world->updateAabbs();
+    }
+
+    // Move the objects and the wheels to the restored transforms.
+    m_env->SynchronizeMotionStates(0.0f);
+    for (WrapperVehicle *wrapperVehicle : m_env->m_wrapperVehicles) {
+      wrapperVehicle->SyncWheels();
+    }
+  }
+};
+
+PHY_ISnapshotState *CcdPhysicsEnvironment::ReadState(PHY_SnapshotReader &reader)
+{
+  int numConstraints;
+  if (!reader.Read(numConstraints) || numConstraints != m_dynamicsWorld->getNumConstraints()) {
+    return nullptr;
+  }
+
+  SnapshotState *state = new SnapshotState(this);
+  state->m_constraints.resize(numConstraints);
+  for (std::pair<bool, btScalar> &constraint : state->m_constraints) {
+    if (!reader.Read(constraint.first) || !reader.Read(constraint.second)) {
+      delete state;
+      return nullptr;
+    }
+  }
+
+  unsigned int numVehicles;
+  if (!reader.Read(numVehicles) || numVehicles != m_wrapperVehicles.size()) {
+    delete state;
+    return nullptr;
+  }
+  for (WrapperVehicle *wrapperVehicle : m_wrapperVehicles) {
+    int numWheels;
+    if (!reader.Read(numWheels) || numWheels != wrapperVehicle->GetVehicle()->getNumWheels()) {
+      delete state;
+      return nullptr;
+    }
+    for (int i = 0; i < numWheels; ++i) {
+      CcdWheelState wheel;
+      if (!reader.Read(wheel)) {
+        delete state;
+        return nullptr;
+      }
+      state->m_wheels.push_back(wheel);
+    }
+  }
+
+  return state;
+}
+
+void CcdPhysicsEnvironment::SetDeterministic(bool deterministic)
+{
+  m_deterministic = deterministic;
+}
+
+bool CcdPhysicsEnvironment::GetDeterministic() const
+{
+  return m_deterministic;
+}
+
 struct BlenderDebugDraw : public btIDebugDraw {
   BlenderDebugDraw() : m_debugMode(0)
   {
@@ -2735,8 +3360,25 @@ CcdPhysicsEnvironment *CcdPhysicsEnvironment::Create(Scene *blenderscene, bool v
       PHY_SOLVER_SEQUENTIAL,  // GAME_SOLVER_SEQUENTIAL
       PHY_SOLVER_NNCG,        // GAME_SOLVER_NNGC
   };
+
+  bool useThreads = (blenderscene->gm.flag & GAME_USE_THREADED_PHYSICS) != 0;
+  // The multithreaded world doesn't support soft bodies, keep the soft body world for them.
+  if (useThreads) {
+    FOREACH_SCENE_OBJECT_BEGIN (blenderscene, ob) {
+      if (ob->gameflag & OB_SOFT_BODY) {
+        useThreads = false;
+      }
+    }
+    FOREACH_SCENE_OBJECT_END;
+
+    if (!useThreads) {
+      CM_Warning("scene \"" << (blenderscene->id.name + 2)
+                             << "\" uses soft bodies, threaded physics disabled");
+    }
+  }
+
   CcdPhysicsEnvironment *ccdPhysEnv = new CcdPhysicsEnvironment(
-      solverTypeTable[blenderscene->gm.solverType], false);
+      solverTypeTable[blenderscene->gm.solverType], false, useThreads);
   ccdPhysEnv->SetDebugDrawer(new BlenderDebugDraw());
   ccdPhysEnv->SetDeactivationLinearTreshold(blenderscene->gm.lineardeactthreshold);
   ccdPhysEnv->SetDeactivationAngularTreshold(blenderscene->gm.angulardeactthreshold);
@@ -2745,6 +3387,21 @@ CcdPhysicsEnvironment *CcdPhysicsEnvironment::Create(Scene *blenderscene, bool v
   ccdPhysEnv->SetERPContact(blenderscene->gm.erp2);
   ccdPhysEnv->SetCFM(blenderscene->gm.cfm);
 
+  if (blenderscene->gm.flag & GAME_USE_BVH_CACHE) {
+    // Cache next to the main blend file, or in the temporary directory if it's not saved.
+    const std::string &mainPath = KX_GetMainPath();
+    char directory[FILE_MAX];
+    if (mainPath.empty()) {
+      BLI_path_join(directory, sizeof(directory), BKE_tempdir_base(), "bge_bvh_cache");
+    }
+    else {
+      char mainDirectory[FILE_MAX];
+      BLI_split_dir_part(mainPath.c_str(), mainDirectory, sizeof(mainDirectory));
+      BLI_path_join(directory, sizeof(directory), mainDirectory, "bvh_cache");
+    }
+    ccdPhysEnv->SetBvhCacheDirectory(directory);
+  }
+
   if (visualizePhysics)
     ccdPhysEnv->SetDebugMode(btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawAabb |
                              btIDebugDraw::DBG_DrawContactPoints | btIDebugDraw::DBG_DrawText |
@@ -3054,6 +3711,10 @@ void CcdPhysicsEnvironment::ConvertObject(BL_SceneConverter *converter,
         shapeInfo->setVertexWeldingThreshold1(0.0f);  // todo: expose this to the UI
       }
 
+      if (!isbulletsoftbody) {
+        shapeInfo->SetBvhCacheDirectory(m_bvhCacheDirectory);
+      }
+
       bm = shapeInfo->CreateBulletShape(ci.m_margin, useGimpact, !isbulletsoftbody);
       // should we compute inertia for dynamic shape?
       // bm->calculateLocalInertia(ci.m_mass,ci.m_localInertiaTensor);
@@ -3404,3 +4065,76 @@ float CcdCollData::GetAppliedImpulse(unsigned int index, bool first) const
   const btManifoldPoint &point = m_manifoldPoint->getContactPoint(index);
   return point.m_appliedImpulse;
 }
+
+CcdFrameCollData::CcdFrameCollData() : m_numContacts(0)
+{
+}
+
+CcdFrameCollData::~CcdFrameCollData()
+{
+}
+
+void CcdFrameCollData::Update(const btPersistentManifold *manifold)
+{
+  m_numContacts = manifold->getNumContacts();
+  for (unsigned int i = 0; i < m_numContacts; ++i) {
+    const btManifoldPoint &point = manifold->getContactPoint(i);
+    ContactPoint &copy = m_points[i];
+    copy.m_localPointA = point.m_localPointA;
+    copy.m_localPointB = point.m_localPointB;
+    copy.m_positionWorldOnB = point.m_positionWorldOnB;
+    copy.m_normalWorldOnB = point.m_normalWorldOnB;
+    copy.m_combinedFriction = point.m_combinedFriction;
+    copy.m_combinedRollingFriction = point.m_combinedRollingFriction;
+    copy.m_combinedRestitution = point.m_combinedRestitution;
+    copy.m_appliedImpulse = point.m_appliedImpulse;
+  }
+}
+
+unsigned int CcdFrameCollData::GetNumContacts() const
+{
+  return m_numContacts;
+}
+
+MT_Vector3 CcdFrameCollData::GetLocalPointA(unsigned int index, bool first) const
+{
+  const ContactPoint &point = m_points[index];
+  return MT_Vector3(first ? point.m_localPointA.m_floats : point.m_localPointB.m_floats);
+}
+
+MT_Vector3 CcdFrameCollData::GetLocalPointB(unsigned int index, bool first) const
+{
+  const ContactPoint &point = m_points[index];
+  return MT_Vector3(first ? point.m_localPointB.m_floats : point.m_localPointA.m_floats);
+}
+
+MT_Vector3 CcdFrameCollData::GetWorldPoint(unsigned int index, bool first) const
+{
+  return MT_Vector3(m_points[index].m_positionWorldOnB.m_floats);
+}
+
+MT_Vector3 CcdFrameCollData::GetNormal(unsigned int index, bool first) const
+{
+  const ContactPoint &point = m_points[index];
+  return MT_Vector3(first ? (-point.m_normalWorldOnB).m_floats : point.m_normalWorldOnB.m_floats);
+}
+
+float CcdFrameCollData::GetCombinedFriction(unsigned int index, bool first) const
+{
+  return m_points[index].m_combinedFriction;
+}
+
+float CcdFrameCollData::GetCombinedRollingFriction(unsigned int index, bool first) const
+{
+  return m_points[index].m_combinedRollingFriction;
+}
+
+float CcdFrameCollData::GetCombinedRestitution(unsigned int index, bool first) const
+{
+  return m_points[index].m_combinedRestitution;
+}
+
+float CcdFrameCollData::GetAppliedImpulse(unsigned int index, bool first) const
+{
+  return m_points[index].m_appliedImpulse;
+}
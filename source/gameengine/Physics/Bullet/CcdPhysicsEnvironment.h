@@ -24,9 +24,11 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
 #include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
 #include "LinearMath/btTransform.h"
 #include "LinearMath/btVector3.h"
@@ -49,6 +51,7 @@ class PHY_IVehicle;
 class CcdGraphicController;
 class CcdOverlapFilterCallBack;
 class CcdShapeConstructionInfo;
+class CcdFrameCollData;
 
 /** CcdPhysicsEnvironment is an experimental mainloop for physics simulation using optional
  * continuous collision detection. Physics Environment takes care of stepping the simulation and is
@@ -68,6 +71,9 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   /// Restore the constraint if the owner and target are presents.
   void RestoreConstraint(CcdPhysicsController *ctrl, btTypedConstraint *con);
 
+  /// Constraints and vehicles state read from a snapshot.
+  class SnapshotState;
+
  protected:
   btIDebugDraw *m_debugDrawer;
 
@@ -92,10 +98,26 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   float m_angularDeactivationThreshold;
   float m_contactBreakingThreshold;
 
+  /** Apply the Fh springs, the rays of all the Fh controllers are first tested in parallel
+   * then the springs applied in order.
+   */
   void ProcessFhSprings(double curTime, float timeStep);
+  /// Synchronize the motion states of the controllers moved by the simulation.
+  void SynchronizeMotionStates(float timeStep);
+  /** Step the world once per sub step, without the time accumulator of the world that is
+   * not part of the snapshots. Return the number of sub steps.
+   */
+  int StepDeterministic(float subStep);
+  /** Remove and add again all the collision objects in the same order, so that the
+   * broadphase, the pairs and the contact manifolds are rebuilt the same way from a snapshot.
+   */
+  void ResetCollisionState();
 
  public:
-  CcdPhysicsEnvironment(PHY_SolverType solverType, bool useDbvtCulling);
+  /** \param useThreads Use a multithreaded dynamics world running on the workers of
+   * CcdTaskScheduler, soft bodies are not supported in this world.
+   */
+  CcdPhysicsEnvironment(PHY_SolverType solverType, bool useDbvtCulling, bool useThreads = false);
 
   virtual ~CcdPhysicsEnvironment();
 
@@ -123,6 +145,16 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   virtual void SetSolverSorConstant(float sor);
   virtual void SetSolverTau(float tau);
   virtual void SetSolverDamping(float damping);
+  virtual void SetNumThreads(int numThreads);
+  virtual int GetNumThreads();
+
+  /** Set the directory caching the BVH of the static triangle mesh shapes between runs,
+   * an empty directory disables the cache.
+   */
+  void SetBvhCacheDirectory(const std::string &directory)
+  {
+    m_bvhCacheDirectory = directory;
+  }
 
   virtual int GetNumTimeSubSteps()
   {
@@ -130,6 +162,8 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   }
 
   /// Perform an integration step of duration 'timeStep'.
+  virtual void ApplyGlobalSettings();
+  virtual bool HasSameGlobalSettings(PHY_IPhysicsEnvironment *other);
   virtual bool ProceedDeltaTime(double curTime, float timeStep, float interval);
 
   virtual void UpdateSoftBodies();
@@ -185,6 +219,8 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   virtual float getAppliedImpulse(int constraintid);
 
   virtual void CallbackTriggers();
+  virtual void ClearCollisionData();
+  virtual unsigned int GetCollisionStep() const;
 
   // complex constraint for vehicles
   virtual PHY_IVehicle *GetVehicleConstraint(int constraintId);
@@ -200,6 +236,15 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
                                           float toX,
                                           float toY,
                                           float toZ);
+  virtual unsigned int GetNumFhRays() const;
+  virtual unsigned int GetNumSleepingControllers() const;
+
+  /// Test the rays of the batch on the worker threads of the task scheduler.
+  virtual void RayTestBatch(PHY_IRayCastFilterCallback **filterCallbacks,
+                            const MT_Vector3 *fromPoints,
+                            const MT_Vector3 *toPoints,
+                            PHY_IPhysicsController **hitControllers,
+                            unsigned int numRays);
   virtual bool CullingTest(PHY_CullingCallback callback,
                            void *userData,
                            const std::array<MT_Vector4, 6> &planes,
@@ -272,11 +317,17 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
 
   void SyncMotionStates(float timeStep);
 
-  class btSoftRigidDynamicsWorld *GetDynamicsWorld()
+  class btDiscreteDynamicsWorld *GetDynamicsWorld()
   {
     return m_dynamicsWorld;
   }
 
+  /// Return the dynamics world as a soft body world, nullptr if the world is multithreaded.
+  class btSoftRigidDynamicsWorld *GetSoftBodyWorld()
+  {
+    return m_softBodyWorld;
+  }
+
   class btConstraintSolver *GetConstraintSolver();
 
   void MergeEnvironment(PHY_IPhysicsEnvironment *other_env);
@@ -301,11 +352,83 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
                                       bool replicate_dupli);
 
  protected:
-  std::set<CcdPhysicsController *> m_controllers;
+  /// Kind of a physics controller, selecting the work done on it at each simulation step.
+  enum ControllerKind {
+    /// Non static rigid bodies, synchronized and clamped at each step.
+    CONTROLLER_DYNAMIC = 0,
+    /// Soft bodies, synchronized and updated at each step.
+    CONTROLLER_SOFT,
+    /** Static rigid bodies, also when moved kinematically, and the other collision objects,
+     * they are only updated when their transform changes.
+     */
+    CONTROLLER_STATIC,
+    CONTROLLER_KIND_MAX
+  };
+
+  /** Controllers of each kind, stored densely to iterate only the controllers needing
+   * synchronization. A controller knows its index and is removed by swapping it with the last.
+   */
+  std::vector<CcdPhysicsController *> m_controllers[CONTROLLER_KIND_MAX];
+  /// Dynamic controllers using Fh springs.
+  std::vector<CcdPhysicsController *> m_fhControllers;
+
+  /// Result of the ray of a Fh spring controller.
+  struct FhRayResult {
+    /// Object hit by the ray, nullptr if no hit or the ray was not tested.
+    const btCollisionObject *m_hitObject;
+    btScalar m_hitFraction;
+    btVector3 m_hitNormal;
+  };
+
+  friend class CcdFhRayTestBody;
+
+  /// Ray results of the Fh spring controllers, kept between the steps.
+  std::vector<FhRayResult> m_fhRayResults;
+  /// Number of Fh spring rays tested in the last step.
+  unsigned int m_numFhRays;
+  /// Number of sleeping dynamic controllers at the last motion state synchronization.
+  unsigned int m_numSleepingControllers;
+  /// Number of controllers whose shape is or contains a GImpact mesh.
+  unsigned int m_numGImpactControllers;
+
+  /// Directory of the BVH disk cache given to the triangle mesh shapes, empty when disabled.
+  std::string m_bvhCacheDirectory;
+
+  bool m_deterministic;
+  /// Forces of the dynamic bodies applied again at each deterministic sub step.
+  btAlignedObjectArray<btVector3> m_stepForces;
+
+  /** Return true if the rays can be tested in parallel in the world, false if a shape
+   * is not thread safe for ray tests.
+   */
+  bool IsParallelRayTestSafe() const;
+
+  /// Return the kind of a controller from its current body and collision flags.
+  ControllerKind GetControllerKind(CcdPhysicsController *ctrl) const;
+  /// Insert a controller in the arrays of its kind.
+  void InsertController(CcdPhysicsController *ctrl);
+  /// Remove a controller from the arrays of its kind.
+  void EraseController(CcdPhysicsController *ctrl);
+  /** Count or uncount the controller in the GImpact controllers depending on its current
+   * shape, count is false when the controller is removed.
+   */
+  void CountGImpactController(CcdPhysicsController *ctrl, bool count);
 
   PHY_ResponseCallback m_triggerCallbacks[PHY_NUM_RESPONSE];
   void *m_triggerCallbacksUserPtrs[PHY_NUM_RESPONSE];
 
+  /** Frame arena of the collision data passed to the collision callbacks, the blocks are kept
+   * between the frames and the records reused after ClearCollisionData().
+   */
+  std::vector<std::unique_ptr<CcdFrameCollData[]>> m_collDataBlocks;
+  /// Number of records used in the arena.
+  unsigned int m_numCollData;
+  /// Number of physics steps which reported collisions since the last clear.
+  unsigned int m_collisionStep;
+
+  /// Return a free record of the collision data arena.
+  CcdFrameCollData *NewFrameCollData();
+
   std::vector<WrapperVehicle *> m_wrapperVehicles;
 
   /** use explicit btSoftRigidDynamicsWorld/btDiscreteDynamicsWorld* so that we have access to
@@ -315,7 +438,9 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
    * Ideally we would like to have access to this function from the btDynamicsWorld interface
    */
   // class btDynamicsWorld *m_dynamicsWorld;
-  class btSoftRigidDynamicsWorld *m_dynamicsWorld;
+  class btDiscreteDynamicsWorld *m_dynamicsWorld;
+  /// The same world when soft bodies are supported.
+  class btSoftRigidDynamicsWorld *m_softBodyWorld;
 
   class btConstraintSolver *m_solver;
 
@@ -326,6 +451,11 @@ class CcdPhysicsEnvironment : public PHY_IPhysicsEnvironment {
   class btDispatcher *m_ownDispatcher;
 
   virtual void ExportFile(const std::string &filename);
+
+  virtual bool SaveState(PHY_SnapshotWriter &writer);
+  virtual PHY_ISnapshotState *ReadState(PHY_SnapshotReader &reader);
+  virtual void SetDeterministic(bool deterministic);
+  virtual bool GetDeterministic() const;
 };
 
 class CcdCollData : public PHY_ICollData {
@@ -345,3 +475,37 @@ class CcdCollData : public PHY_ICollData {
   virtual float GetCombinedRestitution(unsigned int index, bool first) const;
   virtual float GetAppliedImpulse(unsigned int index, bool first) const;
 };
+
+/// Copy of the contact points of a manifold, valid until the collision data of the frame is cleared.
+class CcdFrameCollData : public PHY_ICollData {
+  struct ContactPoint {
+    btVector3 m_localPointA;
+    btVector3 m_localPointB;
+    btVector3 m_positionWorldOnB;
+    btVector3 m_normalWorldOnB;
+    btScalar m_combinedFriction;
+    btScalar m_combinedRollingFriction;
+    btScalar m_combinedRestitution;
+    btScalar m_appliedImpulse;
+  };
+
+  ContactPoint m_points[MANIFOLD_CACHE_SIZE];
+  unsigned int m_numContacts;
+
+ public:
+  CcdFrameCollData();
+  virtual ~CcdFrameCollData();
+
+  /// Copy the contact points of the manifold.
+  void Update(const btPersistentManifold *manifold);
+
+  virtual unsigned int GetNumContacts() const;
+  virtual MT_Vector3 GetLocalPointA(unsigned int index, bool first) const;
+  virtual MT_Vector3 GetLocalPointB(unsigned int index, bool first) const;
+  virtual MT_Vector3 GetWorldPoint(unsigned int index, bool first) const;
+  virtual MT_Vector3 GetNormal(unsigned int index, bool first) const;
+  virtual float GetCombinedFriction(unsigned int index, bool first) const;
+  virtual float GetCombinedRollingFriction(unsigned int index, bool first) const;
+  virtual float GetCombinedRestitution(unsigned int index, bool first) const;
+  virtual float GetAppliedImpulse(unsigned int index, bool first) const;
+};
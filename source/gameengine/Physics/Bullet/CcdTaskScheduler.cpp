@@ -0,0 +1,323 @@
+/** \file gameengine/Physics/Bullet/CcdTaskScheduler.cpp
+ *  \ingroup physbullet
+ */
+/*
+   Bullet Continuous Collision Detection and Physics Library
+   Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+   This software is provided 'as-is', without any express or implied warranty.
+   In no event will the authors be held liable for any damages arising from the use of this
+   software. Permission is granted to anyone to use this software for any purpose, including
+   commercial applications, and to alter it and redistribute it freely, subject to the following
+   restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+   original software. If you use this software in a product, an acknowledgment in the product
+   documentation would be appreciated but is not required.
+   2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+   being the original software.
+   3. This notice may not be removed or altered from any source distribution.
+ */
+#include "CcdTaskScheduler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "LinearMath/btMinMax.h"
+
+#include "BLI_task.h"
+
+/// Range shared by the tasks of a parallel loop, each task pulls chunks until the range is done.
+struct CcdParallelLoop {
+  int begin;
+  int end;
+  int grainSize;
+  std::atomic<int> next;
+  const btIParallelForBody *forBody;
+  const btIParallelSumBody *sumBody;
+  /// Sum of each chunk, added in order after the loop to keep a deterministic result.
+  btScalar *sums;
+  /// Tasks of the loop not yet done by a worker, protected by the pool mutex.
+  int pendingTasks;
+};
+
+/** Worker threads running the parallel loops. Bullet indexes its per thread data with
+ * btGetCurrentThreadIndex(), which gives each new thread the next index of a global counter.
+ * The workers are created once and never destroyed so their indices stay the same, and a
+ * worker only runs loop tasks while its index is one of the slots in use.
+ */
+struct CcdWorkerPool {
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  /// Notified when tasks are pushed, the used slots change or the pool stops.
+  std::condition_variable taskCondition;
+  /// Notified when a worker completes a task.
+  std::condition_variable doneCondition;
+  /// One entry per task to run, a loop appears as many times as it has tasks.
+  std::deque<CcdParallelLoop *> tasks;
+  /// Workers whose Bullet index is in [1, numSlots) run the tasks.
+  int numSlots = 1;
+  /// Bullet index of each worker which read it, used when starting the pool.
+  std::vector<int> workerIndices;
+  /// Number of workers running the tasks, read without the mutex when starting a loop.
+  std::atomic<int> numSlotWorkers{0};
+  bool stop = false;
+
+  /// Count the workers running the tasks, must be called with the mutex locked.
+  void UpdateSlotWorkers()
+  {
+    int count = 0;
+    for (const int index : workerIndices) {
+      /* An index outside the slots was already taken by a thread which is not part of the
+       * pool, the worker then never runs any task. */
+      if (index > 0 && index < numSlots) {
+        ++count;
+      }
+    }
+    numSlotWorkers = count;
+  }
+
+  ~CcdWorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    taskCondition.notify_all();
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  }
+};
+
+static CcdWorkerPool workerPool;
+
+/// The calling thread is a worker of the pool.
+static thread_local bool pool_worker = false;
+/// Loops started by this thread run serially, see CcdTaskScheduler::SetSerial.
+static thread_local bool serial_loops = false;
+
+static void parallel_loop_run(CcdParallelLoop *loop)
+{
+  for (int i = loop->next.fetch_add(loop->grainSize); i < loop->end;
+       i = loop->next.fetch_add(loop->grainSize)) {
+    const int end = btMin(i + loop->grainSize, loop->end);
+    if (loop->sumBody) {
+      loop->sums[(i - loop->begin) / loop->grainSize] = loop->sumBody->sumLoop(i, end);
+    }
+    else {
+      loop->forBody->forLoop(i, end);
+    }
+  }
+}
+
+static void worker_thread_func()
+{
+  pool_worker = true;
+
+  const int index = btGetCurrentThreadIndex();
+  {
+    std::lock_guard<std::mutex> lock(workerPool.mutex);
+    workerPool.workerIndices.push_back(index);
+    workerPool.UpdateSlotWorkers();
+  }
+  workerPool.doneCondition.notify_all();
+
+  std::unique_lock<std::mutex> lock(workerPool.mutex);
+  while (true) {
+    workerPool.taskCondition.wait(lock, [index]() {
+      return workerPool.stop || (!workerPool.tasks.empty() && index > 0 &&
+                                 index < workerPool.numSlots);
+    });
+    if (workerPool.stop) {
+      return;
+    }
+
+    CcdParallelLoop *loop = workerPool.tasks.front();
+    workerPool.tasks.pop_front();
+
+    lock.unlock();
+    parallel_loop_run(loop);
+    lock.lock();
+
+    --loop->pendingTasks;
+    workerPool.doneCondition.notify_all();
+  }
+}
+
+CcdTaskScheduler::CcdTaskScheduler() : btITaskScheduler("Blender")
+{
+  m_maxNumThreads = btMin(BLI_task_scheduler_num_threads(), (int)BT_MAX_THREAD_COUNT);
+  m_numThreads = m_maxNumThreads;
+}
+
+CcdTaskScheduler::~CcdTaskScheduler()
+{
+}
+
+int CcdTaskScheduler::getMaxNumThreads() const
+{
+  return m_maxNumThreads;
+}
+
+int CcdTaskScheduler::getNumThreads() const
+{
+  return m_numThreads;
+}
+
+void CcdTaskScheduler::setNumThreads(int numThreads)
+{
+  m_numThreads = btMax(1, btMin(numThreads, m_maxNumThreads));
+
+  {
+    std::lock_guard<std::mutex> lock(workerPool.mutex);
+    /* A loop started by a thread which can't run its tasks needs a worker even
+     * with a single thread in use. */
+    workerPool.numSlots = btMax(m_numThreads, 2);
+    workerPool.UpdateSlotWorkers();
+  }
+  workerPool.taskCondition.notify_all();
+}
+
+int CcdTaskScheduler::GetUsedThreads() const
+{
+  return m_numThreads;
+}
+
+static void run_parallel_loop(CcdParallelLoop &loop, int numThreads)
+{
+  const int numChunks = (loop.end - loop.begin + loop.grainSize - 1) / loop.grainSize;
+  /* Only the main thread and the workers have an index of a slot, a loop started from any
+   * other thread, as the worker of an independent scene, is run by the workers. */
+  const bool callerRuns = (pool_worker || btIsMainThread() || workerPool.numSlotWorkers == 0);
+
+  int numTasks;
+  if (serial_loops) {
+    // The chunks stay in order when all done by the same thread.
+    numTasks = callerRuns ? 0 : 1;
+  }
+  else {
+    numTasks = btMin(numThreads, numChunks) - (callerRuns ? 1 : 0);
+    numTasks = btMax(numTasks, callerRuns ? 0 : 1);
+  }
+
+  // Not enough work to pay the task creation, run the loop in the calling thread.
+  if (numTasks == 0) {
+    parallel_loop_run(&loop);
+    return;
+  }
+
+  loop.pendingTasks = numTasks;
+  {
+    std::lock_guard<std::mutex> lock(workerPool.mutex);
+    workerPool.tasks.insert(workerPool.tasks.end(), numTasks, &loop);
+  }
+  workerPool.taskCondition.notify_all();
+
+  if (callerRuns) {
+    parallel_loop_run(&loop);
+  }
+
+  std::unique_lock<std::mutex> lock(workerPool.mutex);
+  // The tasks not yet started have nothing left to do, remove them instead of waiting.
+  for (std::deque<CcdParallelLoop *>::iterator it = workerPool.tasks.begin();
+       it != workerPool.tasks.end();) {
+    if (*it == &loop && loop.next >= loop.end) {
+      it = workerPool.tasks.erase(it);
+      --loop.pendingTasks;
+    }
+    else {
+      ++it;
+    }
+  }
+  workerPool.doneCondition.wait(lock, [&loop]() { return loop.pendingTasks == 0; });
+}
+
+void CcdTaskScheduler::parallelFor(int iBegin,
+                                   int iEnd,
+                                   int grainSize,
+                                   const btIParallelForBody &body)
+{
+  if (iBegin >= iEnd) {
+    return;
+  }
+
+  CcdParallelLoop loop;
+  loop.begin = iBegin;
+  loop.end = iEnd;
+  loop.grainSize = btMax(1, grainSize);
+  loop.next = iBegin;
+  loop.forBody = &body;
+  loop.sumBody = nullptr;
+  loop.sums = nullptr;
+
+  run_parallel_loop(loop, m_numThreads);
+}
+
+btScalar CcdTaskScheduler::parallelSum(int iBegin,
+                                       int iEnd,
+                                       int grainSize,
+                                       const btIParallelSumBody &body)
+{
+  if (iBegin >= iEnd) {
+    return btScalar(0);
+  }
+
+  const int chunkSize = btMax(1, grainSize);
+  std::vector<btScalar> sums((iEnd - iBegin + chunkSize - 1) / chunkSize, btScalar(0));
+
+  CcdParallelLoop loop;
+  loop.begin = iBegin;
+  loop.end = iEnd;
+  loop.grainSize = chunkSize;
+  loop.next = iBegin;
+  loop.forBody = nullptr;
+  loop.sumBody = &body;
+  loop.sums = sums.data();
+
+  run_parallel_loop(loop, m_numThreads);
+
+  btScalar sum = btScalar(0);
+  for (const btScalar chunkSum : sums) {
+    sum += chunkSum;
+  }
+
+  return sum;
+}
+
+CcdTaskScheduler *CcdTaskScheduler::Get()
+{
+  static CcdTaskScheduler scheduler;
+  return &scheduler;
+}
+
+void CcdTaskScheduler::Install()
+{
+  CcdTaskScheduler *scheduler = Get();
+  if (btGetTaskScheduler() != scheduler) {
+    btSetTaskScheduler(scheduler);
+  }
+
+  if (!workerPool.threads.empty()) {
+    return;
+  }
+
+  /* The workers are started one after the other just after the scheduler is activated,
+   * they are then the next threads indexed by Bullet and get the slots [1, m_maxNumThreads). */
+  scheduler->setNumThreads(scheduler->m_numThreads);
+  for (int i = 1; i < scheduler->m_maxNumThreads; ++i) {
+    workerPool.threads.emplace_back(worker_thread_func);
+
+    std::unique_lock<std::mutex> lock(workerPool.mutex);
+    workerPool.doneCondition.wait(lock, [i]() { return (int)workerPool.workerIndices.size() == i; });
+  }
+}
+
+void CcdTaskScheduler::SetSerial(bool serial)
+{
+  serial_loops = serial;
+}
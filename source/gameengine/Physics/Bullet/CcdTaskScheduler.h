@@ -0,0 +1,73 @@
+/*
+   Bullet Continuous Collision Detection and Physics Library
+   Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+   This software is provided 'as-is', without any express or implied warranty.
+   In no event will the authors be held liable for any damages arising from the use of this
+   software. Permission is granted to anyone to use this software for any purpose, including
+   commercial applications, and to alter it and redistribute it freely, subject to the following
+   restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+   original software. If you use this software in a product, an acknowledgment in the product
+   documentation would be appreciated but is not required.
+   2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+   being the original software.
+   3. This notice may not be removed or altered from any source distribution.
+ */
+
+/** \file CcdTaskScheduler.h
+ *  \ingroup physbullet
+ */
+
+#pragma once
+
+#include "LinearMath/btThreads.h"
+
+/** Bullet task scheduler running the parallel loops of the multithreaded dynamics world
+ * on a fixed pool of worker threads. Bullet indexes its per thread data with the index
+ * it gives to each thread, the workers keep their index for the whole process and only the
+ * main thread and the workers of index lower than the number of used threads run the loops.
+ */
+class CcdTaskScheduler : public btITaskScheduler {
+ private:
+  /// Number of threads used to run a parallel loop.
+  int m_numThreads;
+  /// Number of threads of the Blender task scheduler, the pool has one worker less.
+  int m_maxNumThreads;
+
+ public:
+  CcdTaskScheduler();
+  virtual ~CcdTaskScheduler();
+
+  virtual int getMaxNumThreads() const;
+  /** Bullet sizes its per thread arrays with this value and indexes them with
+   * btGetCurrentThreadIndex(). The loops run on the threads of index lower than this
+   * value, except a loop started from a thread other than the main thread with a single
+   * used thread which is run by the worker of index 1. The arrays must then be sized
+   * with getMaxNumThreads().
+   */
+  virtual int getNumThreads() const;
+  virtual void setNumThreads(int numThreads);
+  virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody &body);
+  virtual btScalar parallelSum(int iBegin,
+                               int iEnd,
+                               int grainSize,
+                               const btIParallelSumBody &body);
+
+  /// Return the number of threads used to run a parallel loop.
+  int GetUsedThreads() const;
+
+  /// Return the shared scheduler, Install must have been called before any physics step.
+  static CcdTaskScheduler *Get();
+  /** Install the shared scheduler in Bullet and start its workers. Bullet requires it to be
+   * done by its thread of index 0, this function must be called from the main thread at the
+   * engine start.
+   */
+  static void Install();
+
+  /** Run the parallel loops started by the calling thread in this thread and in order,
+   * the multithreaded world then gives reproducible results.
+   */
+  static void SetSerial(bool serial);
+};
@@ -36,6 +36,9 @@
 
 class PHY_IMotionState;
 class PHY_IPhysicsEnvironment;
+class PHY_SnapshotWriter;
+class PHY_SnapshotReader;
+class PHY_ISnapshotState;
 
 class MT_Vector3;
 class MT_Matrix3x3;
@@ -122,6 +125,8 @@ class PHY_IPhysicsController : public PHY_IController {
   virtual MT_Vector3 GetVelocity(const MT_Vector3 &pos) = 0;
   virtual MT_Vector3 GetLocalInertia() = 0;
   virtual MT_Vector3 GetGravity() = 0;
+  /// Compute the world axis aligned bounding box of the collision shape.
+  virtual void GetAabb(MT_Vector3 &aabbMin, MT_Vector3 &aabbMax) = 0;
 
   // dyna's that are rigidbody are free in orientation, dyna's with non-rigidbody are restricted
   virtual void SetRigidBody(bool rigid) = 0;
@@ -158,6 +163,8 @@ class PHY_IPhysicsController : public PHY_IController {
   virtual bool IsCompound() = 0;
   virtual bool IsDynamicsSuspended() const = 0;
   virtual bool IsPhysicsSuspended() = 0;
+  /// Return true if the body was put to sleep by the simulation and its transform is not synced.
+  virtual bool IsSleeping() const = 0;
 
   virtual bool ReinstancePhysicsShape(KX_GameObject *from_gameobj,
                                       RAS_MeshObject *from_meshobj,
@@ -173,4 +180,12 @@ class PHY_IPhysicsController : public PHY_IController {
   // CCD methods
   virtual void SetCcdMotionThreshold(float val) = 0;
   virtual void SetCcdSweptSphereRadius(float val) = 0;
+
+  /// Write the simulation state of the controller: transform, velocities and activation.
+  virtual void SaveState(PHY_SnapshotWriter &writer) = 0;
+  /** Read the state written by SaveState without applying it.
+   * \return The state to apply, owned by the caller, or nullptr if it doesn't match the
+   * controller.
+   */
+  virtual PHY_ISnapshotState *ReadState(PHY_SnapshotReader &reader) = 0;
 };
@@ -52,6 +52,9 @@ class KX_Scene;
 class BL_SceneConverter;
 
 class PHY_IMotionState;
+class PHY_SnapshotWriter;
+class PHY_SnapshotReader;
+class PHY_ISnapshotState;
 struct bRigidBodyJointConstraint;
 
 /**
@@ -201,6 +204,23 @@ class PHY_IPhysicsEnvironment {
   virtual void SetSolverDamping(float damping)
   {
   }
+  /// setNumThreads sets the number of threads used by the multithreaded physics of all scenes
+  virtual void SetNumThreads(int numThreads)
+  {
+  }
+  virtual int GetNumThreads()
+  {
+    return 1;
+  }
+  /// Set the process wide settings of the physics engine, must be called on the main thread.
+  virtual void ApplyGlobalSettings()
+  {
+  }
+  /// Return true if the process wide settings of both environments are the same.
+  virtual bool HasSameGlobalSettings(PHY_IPhysicsEnvironment *other)
+  {
+    return true;
+  }
 
   virtual void SetGravity(float x, float y, float z) = 0;
   virtual void GetGravity(MT_Vector3 &grav) = 0;
@@ -242,6 +262,36 @@ class PHY_IPhysicsEnvironment {
                                           float toY,
                                           float toZ) = 0;
 
+  /** Test a batch of rays, the ray i goes from fromPoints[i] to toPoints[i], is filtered and
+   * reported by filterCallbacks[i] and its hit controller is stored in hitControllers[i].
+   * The rays can be tested on several threads, the filter callbacks must then only read shared
+   * data.
+   */
+  virtual void RayTestBatch(PHY_IRayCastFilterCallback **filterCallbacks,
+                            const MT_Vector3 *fromPoints,
+                            const MT_Vector3 *toPoints,
+                            PHY_IPhysicsController **hitControllers,
+                            unsigned int numRays)
+  {
+    for (unsigned int i = 0; i < numRays; ++i) {
+      const MT_Vector3 &from = fromPoints[i];
+      const MT_Vector3 &to = toPoints[i];
+      hitControllers[i] = RayTest(
+          *filterCallbacks[i], from.x(), from.y(), from.z(), to.x(), to.y(), to.z());
+    }
+  }
+
+  /// Return the number of Fh spring rays tested in the last simulation step.
+  virtual unsigned int GetNumFhRays() const
+  {
+    return 0;
+  }
+  /// Return the number of bodies put to sleep by the simulation.
+  virtual unsigned int GetNumSleepingControllers() const
+  {
+    return 0;
+  }
+
   // culling based on physical broad phase
   // the plane number must be set as follow: near, far, left, right, top, botton
   // the near plane must be the first one and must always be present, it is used to get the
@@ -260,6 +310,15 @@ class PHY_IPhysicsEnvironment {
                                     PHY_ResponseCallback callback,
                                     void *user) = 0;
   virtual bool RequestCollisionCallback(PHY_IPhysicsController *ctrl) = 0;
+  /// Release the collision data passed to the collision callbacks since the last call.
+  virtual void ClearCollisionData()
+  {
+  }
+  /// Index of the physics step reporting the collisions, counted from the last clear.
+  virtual unsigned int GetCollisionStep() const
+  {
+    return 0;
+  }
   virtual bool RemoveCollisionCallback(PHY_IPhysicsController *ctrl) = 0;
   virtual PHY_CollisionTestResult CheckCollision(PHY_IPhysicsController *ctrl0, PHY_IPhysicsController *ctrl1) = 0;
   // These two methods are *solely* used to create controllers for sensor! Don't use for anything
@@ -270,6 +329,33 @@ class PHY_IPhysicsEnvironment {
 
   virtual void ExportFile(const std::string &filename){};
 
+  /** Write the simulation state owned by the environment, the controllers save their own
+   * state before. Return false if the environment doesn't support snapshots.
+   */
+  virtual bool SaveState(PHY_SnapshotWriter &writer)
+  {
+    return false;
+  }
+  /** Read the state written by SaveState without applying it, the state is applied after
+   * the states of the controllers. Return nullptr if it doesn't match the environment.
+   */
+  virtual PHY_ISnapshotState *ReadState(PHY_SnapshotReader &reader)
+  {
+    return nullptr;
+  }
+  /** In deterministic mode the simulation always runs the same sub steps for a step and
+   * restoring a snapshot resets the contact caches, so that simulating again from a restored
+   * snapshot gives bit identical results. The running simulation keeps its contacts when a
+   * snapshot is saved and can then differ slightly from a simulation restarted from it.
+   */
+  virtual void SetDeterministic(bool deterministic)
+  {
+  }
+  virtual bool GetDeterministic() const
+  {
+    return false;
+  }
+
   virtual void MergeEnvironment(PHY_IPhysicsEnvironment *other_env) = 0;
 
   virtual void ConvertObject(BL_SceneConverter *converter,
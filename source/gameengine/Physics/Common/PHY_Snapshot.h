@@ -0,0 +1,101 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file PHY_Snapshot.h
+ *  \ingroup phys
+ */
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+/** Write the values of a simulation snapshot in a binary buffer.
+ * The values are copied in their memory layout, a snapshot is only meant to be restored
+ * by the same build, usually in the same session for rollback and replays.
+ */
+class PHY_SnapshotWriter {
+ private:
+  std::vector<char> &m_buffer;
+
+ public:
+  PHY_SnapshotWriter(std::vector<char> &buffer) : m_buffer(buffer)
+  {
+  }
+
+  void Write(const void *data, size_t size)
+  {
+    const char *bytes = (const char *)data;
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+  }
+
+  template <class Value> void Write(const Value &value)
+  {
+    Write(&value, sizeof(Value));
+  }
+};
+
+/** Values read from a snapshot and not applied yet. A snapshot is first read and checked
+ * entirely, then its states are applied, a partially valid snapshot never modifies the scene.
+ */
+class PHY_ISnapshotState {
+ public:
+  virtual ~PHY_ISnapshotState()
+  {
+  }
+
+  virtual void Apply() = 0;
+};
+
+/// Read the values of a simulation snapshot written by PHY_SnapshotWriter.
+class PHY_SnapshotReader {
+ private:
+  const char *m_data;
+  const char *m_end;
+
+ public:
+  PHY_SnapshotReader(const char *data, size_t size) : m_data(data), m_end(data + size)
+  {
+  }
+
+  /// Copy the next size bytes into data, return false if the snapshot is too short.
+  bool Read(void *data, size_t size)
+  {
+    if ((size_t)(m_end - m_data) < size) {
+      return false;
+    }
+    memcpy(data, m_data, size);
+    m_data += size;
+    return true;
+  }
+
+  template <class Value> bool Read(Value &value)
+  {
+    return Read(&value, sizeof(Value));
+  }
+
+  /// Return true if all the snapshot was read.
+  bool IsEnd() const
+  {
+    return m_data == m_end;
+  }
+};
@@ -14,6 +14,11 @@
 static CM_ThreadMutex scheduleMutex;
 static CM_ThreadMutex transformMutex;
 
+/** Nodes scheduled by the calling thread during a threaded scene graph update, nullptr when
+ * the nodes are directly scheduled in the shared list under scheduleMutex.
+ */
+static thread_local SG_ScheduleList *threadScheduleList = nullptr;
+
 SG_Node::SG_Node(void *clientobj, void *clientinfo, SG_Callbacks &callbacks)
     : SG_QList(),
       m_SGclientObject(clientobj),
@@ -237,10 +242,20 @@ void SG_Node::UpdateWorldDataThreadSchedule(double time, bool parentUpdated)
     ActivateUpdateTransformCallback();
   }
 
-  scheduleMutex.Lock();
-  // The node is updated, remove it from the update list
-  Delink();
-  scheduleMutex.Unlock();
+  /* The node is updated, remove it from the update list. Its links are modified by the
+   * neighbours unlinked on other threads, they are read only under the lock. In a threaded
+   * scene graph update no node is linked to the shared list until the thread lists are merged.
+   */
+  if (threadScheduleList) {
+    Delink();
+  }
+  else {
+    scheduleMutex.Lock();
+    if (!Empty()) {
+      Delink();
+    }
+    scheduleMutex.Unlock();
+  }
 
   // update children's worlddata
   for (SG_Node *childnode : m_children) {
@@ -279,6 +294,11 @@ void SG_Node::SetSimulatedTimeThread(double time, bool recurse)
 
 bool SG_Node::Schedule(SG_QList &head)
 {
+  if (threadScheduleList) {
+    threadScheduleList->scheduled.push_back(this);
+    return true;
+  }
+
   scheduleMutex.Lock();
   // Put top parent in front of list to make sure they are updated before their
   // children => the children will be udpated and removed from the list before
@@ -300,6 +320,11 @@ SG_Node *SG_Node::GetNextScheduled(SG_QList &head)
 
 bool SG_Node::Reschedule(SG_QList &head)
 {
+  if (threadScheduleList) {
+    threadScheduleList->rescheduled.push_back(this);
+    return true;
+  }
+
   scheduleMutex.Lock();
   const bool result = head.QAddBack(this);
   scheduleMutex.Unlock();
@@ -316,6 +341,33 @@ SG_Node *SG_Node::GetNextRescheduled(SG_QList &head)
   return result;
 }
 
+void SG_Node::SetThreadScheduleList(SG_ScheduleList *list)
+{
+  threadScheduleList = list;
+}
+
+void SG_Node::MergeScheduleList(SG_ScheduleList &list, SG_QList &head)
+{
+  BLI_assert(threadScheduleList == nullptr);
+
+  // The transform callbacks, e.g. to the physics, run on the merging thread without lock.
+  for (SG_Node *node : list.transformed) {
+    node->m_callbacks.m_updatefunc(node, node->m_SGclientObject, node->m_SGclientInfo);
+  }
+
+  // A node scheduled twice or already scheduled is ignored by Schedule and Reschedule.
+  for (SG_Node *node : list.scheduled) {
+    node->Schedule(head);
+  }
+  for (SG_Node *node : list.rescheduled) {
+    node->Reschedule(head);
+  }
+
+  list.scheduled.clear();
+  list.rescheduled.clear();
+  list.transformed.clear();
+}
+
 void SG_Node::AddSGController(SG_Controller *cont)
 {
   m_SGcontrollers.push_back(cont);
@@ -611,7 +663,13 @@ void SG_Node::ActivateDestructionCallback()
 void SG_Node::ActivateUpdateTransformCallback()
 {
   if (m_callbacks.m_updatefunc) {
-    // Call client provided update func.
+    // In a threaded scene graph update the callback is called when the thread list is merged.
+    if (threadScheduleList) {
+      threadScheduleList->transformed.push_back(this);
+      return;
+    }
+
+    // Call client provided update func, locked for the threaded animation updates.
     transformMutex.Lock();
     m_callbacks.m_updatefunc(this, m_SGclientObject, m_SGclientInfo);
     transformMutex.Unlock();
@@ -623,9 +681,15 @@ bool SG_Node::ActivateScheduleUpdateCallback()
   // HACK, this check assumes that the scheduled nodes are put on a DList (see SG_Node.h)
   // The early check on Empty() allows up to avoid calling the callback function
   // when the node is already scheduled for update.
-  scheduleMutex.Lock();
-  const bool empty = Empty();
-  scheduleMutex.Unlock();
+  bool empty;
+  if (threadScheduleList) {
+    empty = Empty();
+  }
+  else {
+    scheduleMutex.Lock();
+    empty = Empty();
+    scheduleMutex.Unlock();
+  }
 
   if (empty && m_callbacks.m_schedulefunc) {
     // Call client provided update func.
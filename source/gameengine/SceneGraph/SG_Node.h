@@ -74,6 +74,17 @@ struct SG_Callbacks {
 
 typedef std::vector<SG_Node *> NodeList;
 
+/**
+ * Nodes scheduled and rescheduled by one thread during a threaded scene graph update,
+ * merged in the shared update list once all the threads are done.
+ */
+struct SG_ScheduleList {
+  NodeList scheduled;
+  NodeList rescheduled;
+  /// Updated nodes whose transform callback is called by the merge, on the merging thread.
+  NodeList transformed;
+};
+
 /**
  * Scenegraph node.
  */
@@ -193,6 +204,19 @@ class SG_Node : public SG_QList {
    */
   static SG_Node *GetNextRescheduled(SG_QList &head);
 
+  /**
+   * Make Schedule and Reschedule called from the calling thread append to list instead
+   * of locking the shared update list, and defer the transform callbacks of the updated
+   * nodes to the merge of the list. nullptr restores the shared list.
+   */
+  static void SetThreadScheduleList(SG_ScheduleList *list);
+
+  /**
+   * Call the deferred transform callbacks and schedule and reschedule in head the nodes of a
+   * thread list, then clear it. Must be called once the thread filling the list is done.
+   */
+  static void MergeScheduleList(SG_ScheduleList &list, SG_QList &head);
+
   /**
    * Node replication functions.
    */
@@ -0,0 +1,308 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <chrono>
+#include <thread>
+
+#include "KX_NetworkStream.h"
+#include "KX_ReplicationPeer.h"
+#include "KX_ReplicationSnapshot.h"
+
+static KX_ReplicationState make_state(uint32_t id,
+                                      const std::shared_ptr<const KX_ReplicationLayout> &layout,
+                                      const MT_Vector3 &position,
+                                      const MT_Quaternion &orientation,
+                                      const std::vector<double> &properties)
+{
+  KX_ReplicationState state;
+  state.m_id = id;
+  state.m_layout = layout;
+  state.SetPosition(position);
+  state.SetOrientation(orientation);
+  state.m_properties = properties;
+  return state;
+}
+
+static std::shared_ptr<const KX_ReplicationLayout> make_layout(const std::string &name)
+{
+  std::shared_ptr<KX_ReplicationLayout> layout = std::make_shared<KX_ReplicationLayout>();
+  layout->m_name = name;
+  layout->m_propertyNames = {"health", "speed", "alive"};
+  layout->m_propertyTypes = {KX_ReplicationLayout::PROPERTY_INT,
+                             KX_ReplicationLayout::PROPERTY_FLOAT,
+                             KX_ReplicationLayout::PROPERTY_BOOL};
+  return layout;
+}
+
+static void expect_states_eq(const KX_ReplicationState &state, const KX_ReplicationState &other)
+{
+  EXPECT_EQ(state.m_id, other.m_id);
+  EXPECT_TRUE(*state.m_layout == *other.m_layout);
+  for (unsigned short i = 0; i < 3; ++i) {
+    EXPECT_EQ(state.m_position[i], other.m_position[i]);
+    EXPECT_EQ(state.m_orientation[i], other.m_orientation[i]);
+  }
+  EXPECT_EQ(state.m_orientationIndex, other.m_orientationIndex);
+  EXPECT_EQ(state.m_properties, other.m_properties);
+}
+
+static void expect_snapshots_eq(const KX_ReplicationSnapshot &snapshot,
+                                const KX_ReplicationSnapshot &other)
+{
+  ASSERT_EQ(snapshot.m_states.size(), other.m_states.size());
+  for (unsigned int i = 0, size = snapshot.m_states.size(); i < size; ++i) {
+    expect_states_eq(snapshot.m_states[i], other.m_states[i]);
+  }
+}
+
+TEST(network_stream, ReadWrite)
+{
+  KX_NetworkWriter writer;
+  writer.WriteUInt8(0xAB);
+  writer.WriteUInt16(0xBEEF);
+  writer.WriteUInt32(0xDEADBEEF);
+  writer.WriteInt16(-1234);
+  writer.WriteFloat(1.5f);
+  writer.WriteDouble(-2.25);
+  writer.WriteVarUInt(0);
+  writer.WriteVarUInt(127);
+  writer.WriteVarUInt(128);
+  writer.WriteVarUInt(UINT64_MAX);
+  writer.WriteVarInt(-1);
+  writer.WriteVarInt(INT64_MIN);
+  writer.WriteVarInt(INT64_MAX);
+  writer.WriteString("Cube.001");
+  writer.WriteString("");
+
+  const std::vector<uint8_t> &data = writer.GetData();
+  KX_NetworkReader reader(data.data(), data.size());
+  EXPECT_EQ(reader.ReadUInt8(), 0xAB);
+  EXPECT_EQ(reader.ReadUInt16(), 0xBEEF);
+  EXPECT_EQ(reader.ReadUInt32(), 0xDEADBEEF);
+  EXPECT_EQ(reader.ReadInt16(), -1234);
+  EXPECT_EQ(reader.ReadFloat(), 1.5f);
+  EXPECT_EQ(reader.ReadDouble(), -2.25);
+  EXPECT_EQ(reader.ReadVarUInt(), 0u);
+  EXPECT_EQ(reader.ReadVarUInt(), 127u);
+  EXPECT_EQ(reader.ReadVarUInt(), 128u);
+  EXPECT_EQ(reader.ReadVarUInt(), UINT64_MAX);
+  EXPECT_EQ(reader.ReadVarInt(), -1);
+  EXPECT_EQ(reader.ReadVarInt(), INT64_MIN);
+  EXPECT_EQ(reader.ReadVarInt(), INT64_MAX);
+  EXPECT_EQ(reader.ReadString(), "Cube.001");
+  EXPECT_EQ(reader.ReadString(), "");
+  EXPECT_FALSE(reader.HasError());
+  EXPECT_TRUE(reader.IsEnd());
+}
+
+TEST(network_stream, SmallVarInt)
+{
+  KX_NetworkWriter writer;
+  writer.WriteVarInt(-64);
+  writer.WriteVarInt(63);
+  EXPECT_EQ(writer.GetData().size(), 2u);
+}
+
+TEST(network_stream, Overflow)
+{
+  KX_NetworkWriter writer;
+  writer.WriteUInt16(42);
+
+  const std::vector<uint8_t> &data = writer.GetData();
+  KX_NetworkReader reader(data.data(), data.size());
+  EXPECT_EQ(reader.ReadUInt32(), 0u);
+  EXPECT_TRUE(reader.HasError());
+  EXPECT_FALSE(reader.IsEnd());
+  // All the reads after an overflow fail.
+  EXPECT_EQ(reader.ReadUInt8(), 0);
+  EXPECT_TRUE(reader.HasError());
+}
+
+TEST(replication_snapshot, Quantization)
+{
+  KX_ReplicationState state;
+  const MT_Vector3 position(12.3f, -4.56f, 1000.0f);
+  state.SetPosition(position);
+  EXPECT_LE((state.GetPosition() - position).length(), KX_ReplicationState::PositionStep);
+
+  MT_Quaternion orientation;
+  orientation.setRotation(MT_Vector3(1.0f, 2.0f, -3.0f).normalized(), 2.5f);
+  state.SetOrientation(orientation);
+  const MT_Quaternion result = state.GetOrientation();
+  // q and -q are the same rotation.
+  EXPECT_NEAR(std::fabs(result.dot(orientation)), 1.0f, 1e-4f);
+}
+
+TEST(replication_snapshot, WriteReadWithoutBaseline)
+{
+  const std::shared_ptr<const KX_ReplicationLayout> layout = make_layout("Cube");
+
+  KX_ReplicationSnapshot snapshot;
+  snapshot.m_states.push_back(make_state(
+      1, layout, MT_Vector3(1.0f, 2.0f, 3.0f), MT_Quaternion(0, 0, 0, 1), {100.0, 2.5, 1.0}));
+  snapshot.m_states.push_back(make_state(
+      7, layout, MT_Vector3(-5.0f, 0.0f, 9.0f), MT_Quaternion(0, 0, 1, 0), {-3.0, 0.0, 0.0}));
+
+  KX_NetworkWriter writer;
+  snapshot.Write(nullptr, writer);
+
+  const std::vector<uint8_t> &data = writer.GetData();
+  KX_NetworkReader reader(data.data(), data.size());
+  KX_ReplicationSnapshot result;
+  EXPECT_TRUE(result.Read(nullptr, reader));
+  expect_snapshots_eq(snapshot, result);
+}
+
+TEST(replication_snapshot, WriteReadWithBaseline)
+{
+  const std::shared_ptr<const KX_ReplicationLayout> layout = make_layout("Cube");
+  const std::shared_ptr<const KX_ReplicationLayout> otherLayout = make_layout("Sphere");
+
+  KX_ReplicationSnapshot baseline;
+  baseline.m_states.push_back(make_state(
+      1, layout, MT_Vector3(1.0f, 2.0f, 3.0f), MT_Quaternion(0, 0, 0, 1), {100.0, 2.5, 1.0}));
+  baseline.m_states.push_back(make_state(
+      2, layout, MT_Vector3(0.0f, 0.0f, 0.0f), MT_Quaternion(0, 0, 0, 1), {0.0, 0.0, 0.0}));
+  baseline.m_states.push_back(make_state(
+      3, layout, MT_Vector3(4.0f, 4.0f, 4.0f), MT_Quaternion(0, 0, 0, 1), {1.0, 1.0, 1.0}));
+  baseline.m_states.push_back(make_state(
+      4, layout, MT_Vector3(8.0f, 8.0f, 8.0f), MT_Quaternion(0, 0, 0, 1), {2.0, 2.0, 0.0}));
+
+  KX_ReplicationSnapshot snapshot;
+  // Moved and a property changed.
+  snapshot.m_states.push_back(make_state(
+      1, layout, MT_Vector3(1.5f, 2.0f, 3.0f), MT_Quaternion(0, 0, 0, 1), {99.0, 2.5, 1.0}));
+  // Unchanged.
+  snapshot.m_states.push_back(baseline.m_states[1]);
+  // 3 is removed, 4 changed of name.
+  snapshot.m_states.push_back(make_state(
+      4, otherLayout, MT_Vector3(8.0f, 8.0f, 8.0f), MT_Quaternion(0, 0, 0, 1), {2.0, 2.0, 0.0}));
+  // New object.
+  snapshot.m_states.push_back(make_state(
+      5, layout, MT_Vector3(0.0f, 1.0f, 0.0f), MT_Quaternion(1, 0, 0, 0), {5.0, 0.5, 1.0}));
+
+  KX_NetworkWriter fullWriter;
+  snapshot.Write(nullptr, fullWriter);
+  KX_NetworkWriter writer;
+  snapshot.Write(&baseline, writer);
+  // The delta is smaller than the complete snapshot.
+  EXPECT_LT(writer.GetData().size(), fullWriter.GetData().size());
+
+  const std::vector<uint8_t> &data = writer.GetData();
+  KX_NetworkReader reader(data.data(), data.size());
+  KX_ReplicationSnapshot result;
+  EXPECT_TRUE(result.Read(&baseline, reader));
+  expect_snapshots_eq(snapshot, result);
+  EXPECT_EQ(result.FindState(3), nullptr);
+  ASSERT_NE(result.FindState(4), nullptr);
+  EXPECT_EQ(result.FindState(4)->m_layout->m_name, "Sphere");
+}
+
+TEST(replication_snapshot, ReadInvalid)
+{
+  const std::shared_ptr<const KX_ReplicationLayout> layout = make_layout("Cube");
+
+  KX_ReplicationSnapshot baseline;
+  baseline.m_states.push_back(make_state(
+      1, layout, MT_Vector3(1.0f, 2.0f, 3.0f), MT_Quaternion(0, 0, 0, 1), {100.0, 2.5, 1.0}));
+
+  KX_ReplicationSnapshot snapshot = baseline;
+  snapshot.m_states[0].SetPosition(MT_Vector3(0.0f, 0.0f, 0.0f));
+
+  KX_NetworkWriter writer;
+  snapshot.Write(&baseline, writer);
+  const std::vector<uint8_t> &data = writer.GetData();
+
+  // A delta can't be read without its baseline.
+  {
+    KX_NetworkReader reader(data.data(), data.size());
+    KX_ReplicationSnapshot result;
+    EXPECT_FALSE(result.Read(nullptr, reader));
+  }
+
+  // Truncated data.
+  {
+    KX_NetworkReader reader(data.data(), data.size() - 1);
+    KX_ReplicationSnapshot result;
+    EXPECT_FALSE(result.Read(&baseline, reader));
+  }
+}
+
+/// Update the peers until the condition is true or a timeout.
+template <class Condition>
+static bool run_peers(KX_ReplicationServer &server,
+                      KX_ReplicationClient &client,
+                      double &time,
+                      Condition condition)
+{
+  for (unsigned int i = 0; i < 200; ++i) {
+    client.Receive(time);
+    server.Receive(time);
+    if (condition()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    time += 0.005;
+  }
+  return false;
+}
+
+TEST(replication_peer, Loopback)
+{
+  KX_ReplicationServer server;
+  // Any free port.
+  ASSERT_TRUE(server.Open(0, 60.0));
+  ASSERT_NE(server.GetPort(), 0);
+
+  KX_NetworkAddress address;
+  ASSERT_TRUE(KX_NetworkAddress::Resolve("127.0.0.1", server.GetPort(), address));
+
+  KX_ReplicationClient client;
+  ASSERT_TRUE(client.Open(address, 0.0));
+
+  double time = 0.0;
+  EXPECT_TRUE(run_peers(server, client, time, [&server]() {
+    return (server.GetNumClients() == 1);
+  }));
+
+  const std::shared_ptr<const KX_ReplicationLayout> layout = make_layout("Cube");
+  KX_ReplicationSnapshot snapshot;
+  snapshot.m_states.push_back(make_state(
+      1, layout, MT_Vector3(1.0f, 2.0f, 3.0f), MT_Quaternion(0, 0, 0, 1), {100.0, 2.5, 1.0}));
+  snapshot.m_states.push_back(make_state(
+      2, layout, MT_Vector3(-1.0f, 0.0f, 0.5f), MT_Quaternion(0, 0, 0, 1), {1.0, 0.0, 0.0}));
+
+  ASSERT_TRUE(server.NeedSnapshot(time));
+  server.Send(snapshot, time);
+  EXPECT_TRUE(run_peers(server, client, time, [&client]() { return client.IsConnected(); }));
+
+  // Without interpolation delay the client shows the last snapshot.
+  std::vector<KX_ReplicationSample> samples;
+  client.Interpolate(time, samples);
+  ASSERT_EQ(samples.size(), 2u);
+  for (unsigned int i = 0; i < 2; ++i) {
+    expect_states_eq(*samples[i].m_state, snapshot.m_states[i]);
+    EXPECT_LE((samples[i].m_position - snapshot.m_states[i].GetPosition()).length(), 1e-5f);
+  }
+
+  // A second snapshot, sent as a delta once the first was acknowledged.
+  snapshot.m_states[0].SetPosition(MT_Vector3(5.0f, 2.0f, 3.0f));
+  snapshot.m_states.pop_back();
+  time += 1.0;
+  ASSERT_TRUE(server.NeedSnapshot(time));
+  server.Send(snapshot, time);
+  EXPECT_TRUE(run_peers(server, client, time, [&client, &samples, &time]() {
+    client.Interpolate(time, samples);
+    return (samples.size() == 1);
+  }));
+  // Past the last snapshot the states are not interpolated.
+  client.Interpolate(time + 1.0, samples);
+  ASSERT_EQ(samples.size(), 1u);
+  expect_states_eq(*samples[0].m_state, snapshot.m_states[0]);
+
+  client.Close();
+  EXPECT_TRUE(run_peers(server, client, time, [&server]() {
+    return (server.GetNumClients() == 0);
+  }));
+}